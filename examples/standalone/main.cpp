@@ -17,8 +17,10 @@
 #include <ossia/network/osc/osc.hpp>
 #include <puara/gestures.h>
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
+#include <span>
 #include <sstream>
 #include <thread>
 #include <vector>
@@ -39,6 +41,20 @@ puara_gestures::Jab3D jab;
 puara_gestures::utils::LeakyIntegrator leakyintegrator;
 IMU_Orientation orientation;
 
+// Three threads share data without locks:
+// - the ossia network thread pushes raw samples into `samples`,
+// - the processing thread runs the descriptors and publishes `outputs`,
+// - the main thread prints the latest outputs and the samples dropped when
+//   `samples` was full.
+struct Outputs {
+    puara_gestures::Coord3D shake;
+    puara_gestures::Coord3D jab;
+    double integrator = 0;
+};
+puara_gestures::utils::Imu9AxisRing<1024> samples;
+puara_gestures::utils::TripleBuffer<Outputs> outputs;
+std::atomic<unsigned long> droppedSamples{0}; // written by the network thread
+
 // struct Coord3D {
 //     double x, y, z;
 // };
@@ -62,17 +78,42 @@ int main(int argc, char* argv[]) {
     accelParam->add_callback([&](const ossia::value& v) {
         std::cout << "New accelerometer value received: " << ossia::value_to_pretty_string(v) << std::endl;
         ossia::vec3f accelerometer = ossia::convert<ossia::vec3f>(v);
-        // shake.update(accelerometer[0], accelerometer[1], accelerometer[2]);
-        // jab.update(accelerometer[0], accelerometer[1], accelerometer[2]);
-        leakyintegrator.integrate(accelerometer[0]);
+        puara_gestures::Imu9Axis sample;
+        sample.accl = {accelerometer[0], accelerometer[1], accelerometer[2]};
+        if(!samples.push(sample))
+            droppedSamples.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    // The descriptors are only touched by this thread.
+    std::thread processing([] {
+        puara_gestures::Imu9Axis block[64];
+        while(true)
+        {
+            const std::size_t count = samples.pop(std::span(block));
+            if(count == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                shake.update(block[i].accl);
+                jab.update(block[i].accl);
+                leakyintegrator.integrate(block[i].accl.x);
+            }
+            outputs.write({shake.current_value(), jab.current_value(),
+                           leakyintegrator.current_value});
+        }
     });
 
     while(true)
     {
-      puara_gestures::Coord3D shakeout = shake.current_value();
-      puara_gestures::Coord3D jabout = jab.current_value();
-      std::cout << "Shake X: " << shakeout.x << ", Jab X: " << jabout.x
-                << ", Integrator: " << leakyintegrator.current_value << std::endl;
+      outputs.update();
+      const Outputs& out = outputs.read();
+      std::cout << "Shake X: " << out.shake.x << ", Jab X: " << out.jab.x
+                << ", Integrator: " << out.integrator
+                << ", Dropped: " << droppedSamples.load(std::memory_order_relaxed)
+                << std::endl;
       std::this_thread::sleep_for(std::chrono::milliseconds(10));
     };
 }
@@ -13,7 +13,12 @@
 */
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <puara/utils.h>
 #include <puara/utils/leakyintegrator.h>
 
@@ -35,8 +40,16 @@ namespace puara_gestures
  * @note
  * This class is not intended to be used directly by most library users.
  * See `Brush` and `Rub` later in this file for the public touch feature API.
+ *
+ * The derived class is a template argument (CRTP) rather than a virtual
+ * override: `Derived::integrate(double, std::optional<uint64_t>)` is called
+ * statically and inlines into `update()`, and the objects carry no vtable
+ * pointer.
+ *
+ * @tparam Derived The feature class, which defines
+ *         `integrate(double, std::optional<uint64_t>)`.
  */
-
+template <typename Derived>
 class ValueIntegrator
 {
 public:
@@ -71,32 +84,41 @@ public:
    */
   void update(double newValue)
   {
-    const auto delta = newValue - prevValue;
-    prevValue = newValue;
+    process(newValue, std::nullopt);
+  }
 
-    // No delta since the last update -> potentially reset the value
-    if(delta == 0.0)
-    {
-      // Only reset the value once we've gotten 0 movements for 10 times
-      if(++counter < 10.0)
-        return;
+  /**
+   * @brief Update the feature with a raw input value taken at a known time.
+   *
+   * Same as `update(double)`, but the integrator uses `timestampMicros`
+   * instead of reading the clock, so recorded data replays identically.
+   *
+   * @param newValue The new input sample.
+   * @param timestampMicros Sample time in microseconds, from any monotonic origin.
+   */
+  void updateAt(double newValue, uint64_t timestampMicros)
+  {
+    process(newValue, timestampMicros);
+  }
 
-      if(value < 0.001)
-        reset();
-      else
-        integrate(delta);
-    }
-    // Large delta -> integrate with 0
-    else if(std::abs(delta) > 1.0)
+  /**
+   * @brief Update the feature with a block of raw input values.
+   *
+   * Equivalent to calling `update(double)` on each value in order.
+   *
+   * @param in Input samples, oldest first.
+   * @param out Receives the feature value after each sample.
+   * @return Number of samples processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const double> in, std::span<double> out)
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < count; ++i)
     {
-      integrate(0.0);
-    }
-    // Goldilocks delta -> integrate and reset the counter
-    else
-    {
-      integrate(delta);
-      counter = 0;
+      ValueIntegrator::update(in[i]);
+      out[i] = value;
     }
+    return count;
   }
 
   /**
@@ -137,12 +159,51 @@ protected:
    */
   utils::LeakyIntegrator integrator{0.0f, 0.0f, 0.7f, 100, 0};
 
-private:
   /**
-   * @brief Abstract method to integrate input into the feature value.
+   * @brief Feed the integrator, at the sample time when one is given.
    * @param input The input value to be integrated.
+   * @param timestampMicros Sample time from `updateAt()`, or none to read the clock.
+   * @return The integrator output.
    */
-  virtual void integrate(double input) = 0;
+  double integrateSample(double input, std::optional<uint64_t> timestampMicros)
+  {
+    if(timestampMicros)
+      return integrator.integrateAt(input, *timestampMicros);
+    return integrator.integrate(input);
+  }
+
+private:
+  void process(double newValue, std::optional<uint64_t> timestampMicros)
+  {
+    const auto delta = newValue - prevValue;
+    prevValue = newValue;
+
+    // No delta since the last update -> potentially reset the value
+    if(delta == 0.0)
+    {
+      // Only reset the value once we've gotten 0 movements for 10 times
+      if(++counter < 10.0)
+        return;
+
+      if(value < 0.001)
+        reset();
+      else
+        derived().integrate(delta, timestampMicros);
+    }
+    // Large delta -> integrate with 0
+    else if(std::abs(delta) > 1.0)
+    {
+      derived().integrate(0.0, timestampMicros);
+    }
+    // Goldilocks delta -> integrate and reset the counter
+    else
+    {
+      derived().integrate(delta, timestampMicros);
+      counter = 0;
+    }
+  }
+
+  Derived& derived() { return static_cast<Derived&>(*this); }
 
   /**
    * @brief A counter for tracking consecutive zero-movement updates.
@@ -165,7 +226,7 @@ private:
  * double brushValue = brush.value; // Access the brush feature value
  * @endcode
  */
-class Brush : public ValueIntegrator
+class Brush : public ValueIntegrator<Brush>
 {
 public:
   Brush() = default;
@@ -180,14 +241,17 @@ public:
   }
 
 private:
+  friend class ValueIntegrator<Brush>;
+
   /**
    * @brief Integrates movement input into the brush feature value.
    * Applies a scaling factor to the input and uses the leaky integrator.
    * @param movement The input movement to integrate.
+   * @param timestampMicros Sample time, or none to read the clock.
    */
-  void integrate(double movement) override
+  void integrate(double movement, std::optional<uint64_t> timestampMicros)
   {
-    value = integrator.integrate(movement * .15);
+    value = integrateSample(movement * .15, timestampMicros);
   }
 };
 
@@ -209,7 +273,7 @@ private:
  * double rubValue = rub.value; // Access the rub feature value
  * @endcode
  */
-class Rub : public ValueIntegrator
+class Rub : public ValueIntegrator<Rub>
 {
 public:
   Rub() = default;
@@ -224,14 +288,17 @@ public:
   }
 
 private:
+  friend class ValueIntegrator<Rub>;
+
   /**
    * @brief Integrates movement input into the rub feature value.
    * Takes the absolute value of the input before applying the leaky integrator.
    * @param movement The input movement to integrate.
+   * @param timestampMicros Sample time, or none to read the clock.
    */
-  void integrate(double movement) override
+  void integrate(double movement, std::optional<uint64_t> timestampMicros)
   {
-    value = integrator.integrate(std::abs(movement * .15));
+    value = integrateSample(std::abs(movement * .15), timestampMicros);
   }
 };
 
@@ -268,6 +335,40 @@ public:
     brush.update(newData);
     rub.update(newData);
   }
+
+  /**
+   * @brief Update both features from a shared input taken at a known time.
+   * @param newData The new input value used by each detector.
+   * @param timestampMicros Sample time in microseconds.
+   */
+  void updateAt(double newData, uint64_t timestampMicros)
+  {
+    brush.updateAt(newData, timestampMicros);
+    rub.updateAt(newData, timestampMicros);
+  }
+
+  /**
+   * @brief Update both features with a block of input values.
+   *
+   * Equivalent to calling `update(double)` on each value in order.
+   *
+   * @param in Input samples, oldest first.
+   * @param brushOut Receives the brush value after each sample.
+   * @param rubOut Receives the rub value after each sample.
+   * @return Number of samples processed, the smallest of the three sizes.
+   */
+  std::size_t update(
+      std::span<const double> in, std::span<double> brushOut, std::span<double> rubOut)
+  {
+    const std::size_t count = std::min({in.size(), brushOut.size(), rubOut.size()});
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      update(in[i]);
+      brushOut[i] = brush.value;
+      rubOut[i] = rub.value;
+    }
+    return count;
+  }
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+/**
+* @file brushRubBank.h
+* @brief Brush and rub features for many touch positions at once, with structure-of-arrays state.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+*/
+#pragma once
+
+#include <puara/utils/chrono.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace puara_gestures
+{
+
+/**
+ * @class BrushRubBank
+ * @brief `BrushRubDetector` for `N` positions, updated in a single pass.
+ *
+ * @details
+ * Each `BrushRubDetector` holds a `Brush` and a `Rub`, each with its own
+ * previous position, zero-movement counter and `LeakyIntegrator`. BrushRubBank
+ * keeps that state in contiguous per-channel arrays. The previous position and
+ * counter are shared by the brush and rub of a channel, since both always see
+ * the same input. All channels are updated in one loop, with selects instead
+ * of the per-sample branches of `ValueIntegrator`.
+ *
+ * For the same settings and the same update times, each channel produces
+ * exactly the values of a `BrushRubDetector`. The clock is read once per
+ * `update()`, or not at all with `updateAt()`.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::BrushRubBank<4> fingers;
+ *
+ * std::array<double, 4> positions = readFingerPositions();
+ * fingers.update(positions);
+ * double brush = fingers.brushValue(2); // finger 2
+ * @endcode
+ *
+ * @tparam N Number of positions (e.g. fingers).
+ *
+ * @ingroup puara_gestures_descriptors
+ */
+template <std::size_t N>
+class BrushRubBank
+{
+public:
+  /**
+   * @brief Leak factor of the integrators, as in `Brush` and `Rub` (which
+   * store 0.7 rounded to float).
+   */
+  double leak = double(0.7f);
+
+  /**
+   * @brief Integrator update frequency in Hz, as in `Brush` and `Rub`. Use 0
+   * or a negative value to leak on every update.
+   */
+  int frequency = 100;
+
+  /**
+   * @brief Update every channel with a new position, reading the clock once.
+   * @param positions One position per channel.
+   * @return 1 when the update is processed.
+   */
+  int update(std::span<const double, N> positions)
+  {
+    return updateAt(positions, utils::getCurrentTimeMicroseconds());
+  }
+
+  /**
+   * @brief Update every channel with a position taken at `timestampMicros`.
+   * @param positions One position per channel.
+   * @param timestampMicros Time of the samples, in microseconds.
+   * @return 1 when the update is processed.
+   */
+  int updateAt(std::span<const double, N> positions, uint64_t timestampMicros)
+  {
+    const bool timed = frequency > 0;
+    const unsigned long long period = timed ? 1000 / frequency : 0;
+
+    for(std::size_t c = 0; c < N; ++c)
+    {
+      const double delta = positions[c] - prevValue[c];
+      prevValue[c] = positions[c];
+
+      // Same cases as ValueIntegrator: no movement only integrates after ten
+      // still samples, a jump of more than one integrates 0.
+      const bool still = delta == 0.0;
+      counter[c] = still ? (counter[c] < 10 ? counter[c] + 1 : 10)
+                         : (std::abs(delta) > 1.0 ? counter[c] : 0);
+      const bool waiting = still & (counter[c] < 10);
+      const double movement = (std::abs(delta) > 1.0 ? 0.0 : delta) * .15;
+
+      step(brush[c], brushOld[c], brushTimer[c], brushLast[c], movement, waiting, still,
+           timestampMicros, timed, period);
+      step(rub[c], rubOld[c], rubTimer[c], rubLast[c], std::abs(movement), waiting,
+           still, timestampMicros, timed, period);
+    }
+    return 1;
+  }
+
+  /**
+   * @brief Brush value of one channel.
+   * @param channel Channel index, below `N`.
+   */
+  double brushValue(std::size_t channel) const { return brush[channel]; }
+
+  /**
+   * @brief Rub value of one channel.
+   * @param channel Channel index, below `N`.
+   */
+  double rubValue(std::size_t channel) const { return rub[channel]; }
+
+  /**
+   * @brief Brush value of every channel.
+   */
+  std::span<const double, N> brushValues() const { return brush; }
+
+  /**
+   * @brief Rub value of every channel.
+   */
+  std::span<const double, N> rubValues() const { return rub; }
+
+  /**
+   * @brief Set the previous position of a channel without integrating.
+   *
+   * The next update measures movement from `position`, as when a new finger
+   * takes over the channel.
+   */
+  void setPosition(std::size_t channel, double position) { prevValue[channel] = position; }
+
+  /**
+   * @brief Reset every channel to zero brush and rub.
+   */
+  void reset()
+  {
+    brush.fill(0.0);
+    rub.fill(0.0);
+    brushOld.fill(0.0);
+    rubOld.fill(0.0);
+    brushTimer.fill(0);
+    rubTimer.fill(0);
+    brushLast.fill(noTimestamp);
+    rubLast.fill(noTimestamp);
+    prevValue.fill(0.0);
+    counter.fill(0);
+  }
+
+private:
+  // Marks a feature that has not integrated a timestamped sample yet.
+  static constexpr uint64_t noTimestamp = ~uint64_t(0);
+
+  static constexpr std::array<uint64_t, N> filled(uint64_t v)
+  {
+    std::array<uint64_t, N> a{};
+    a.fill(v);
+    return a;
+  }
+
+  // One feature of one channel: ValueIntegrator::process() followed by the
+  // gated LeakyIntegrator::integrateAt(), written as selects. `last` is the
+  // time of the previous integrated sample; an earlier timestamp restarts the
+  // gate there, as in integrateAt().
+  void step(
+      double& value, double& old, unsigned long long& timer, uint64_t& last, double input,
+      bool waiting, bool still, uint64_t timestampMicros, bool timed,
+      unsigned long long period)
+  {
+    const unsigned long long nowMillis = timestampMicros / 1000ULL;
+    const bool settle = still & !waiting & (value < 0.001);
+    const bool integrate = !waiting & !settle;
+    const bool restart = (last != noTimestamp) & (timestampMicros < last);
+    const unsigned long long from = restart ? nowMillis : timer;
+    const bool gated = timed & (nowMillis < from + period);
+    const double integrated = input + old * (gated ? 1.0 : leak);
+
+    old = integrate ? integrated : old;
+    value = settle ? 0.0 : (integrate ? integrated : value);
+    timer = integrate ? ((timed & !gated) ? nowMillis : from) : timer;
+    last = integrate ? timestampMicros : last;
+  }
+
+  std::array<double, N> brush{};
+  std::array<double, N> rub{};
+  std::array<double, N> brushOld{};
+  std::array<double, N> rubOld{};
+  std::array<unsigned long long, N> brushTimer{};
+  std::array<unsigned long long, N> rubTimer{};
+  std::array<uint64_t, N> brushLast = filled(noTimestamp);
+  std::array<uint64_t, N> rubLast = filled(noTimestamp);
+  std::array<double, N> prevValue{};
+  std::array<int, N> counter{};
+};
+
+}
@@ -11,9 +11,115 @@
 #pragma once
 
 #include <puara/utils.h>
+#include <puara/utils/spscRing.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 
 namespace puara_gestures
 {
+  /**
+   * @brief Snapshot of the public Button outputs after an update.
+   *
+   * Used by the block `Button::update(in, out)` overload.
+   */
+  struct ButtonState
+  {
+    unsigned int count = 0;
+    bool press = false;
+    unsigned int tap = 0;
+    unsigned int doubleTap = 0;
+    unsigned int tripleTap = 0;
+    bool hold = false;
+    unsigned int pressTime = 0;
+  };
+
+  /**
+   * @brief Kind of a `ButtonEvent`.
+   */
+  enum class ButtonEventType : uint8_t
+  {
+    Press,     ///< The button went down.
+    Release,   ///< The button went up.
+    Tap,       ///< A tap sequence ended; `ButtonEvent::taps` holds its length.
+    HoldStart, ///< The button has been down for `holdInterval`.
+    HoldEnd    ///< A held button went up (followed by a `Release`).
+  };
+
+  /**
+   * @brief A button transition, stamped with the time of the update that
+   * detected it.
+   */
+  struct ButtonEvent
+  {
+    uint64_t timestampMicros = 0;
+    ButtonEventType type = ButtonEventType::Press;
+    /**
+     * @brief `Button::id`, or the bit index in a `ButtonBank`.
+     */
+    uint8_t button = 0;
+    /**
+     * @brief Number of taps in the sequence, for `ButtonEventType::Tap`.
+     */
+    uint16_t taps = 0;
+  };
+
+  /**
+   * @brief Event queue filled by `Button` and `ButtonBank`.
+   *
+   * Lock-free between one producer (the scanning code) and one consumer.
+   */
+  template <std::size_t Capacity = 64>
+  using ButtonEventRing = utils::SpscRing<ButtonEvent, Capacity>;
+
+  /**
+   * @brief Where a `Button` pushes its events: a `ButtonEventRing` of any
+   * capacity, or nothing.
+   *
+   * Converts from a pointer to the ring, so `button.events = &ring;` works
+   * whatever the ring's capacity. The ring is not owned and must outlive the
+   * button, or be detached with `button.events = nullptr;`.
+   */
+  class ButtonEventSink
+  {
+  public:
+    ButtonEventSink() noexcept = default;
+    ButtonEventSink(std::nullptr_t) noexcept { }
+
+    template <std::size_t Capacity>
+    ButtonEventSink(ButtonEventRing<Capacity>* ring) noexcept
+        : target(ring)
+        , pushEvent(ring != nullptr ? &pushToRing<Capacity> : nullptr)
+    {
+    }
+
+    explicit operator bool() const noexcept { return target != nullptr; }
+    friend bool operator==(const ButtonEventSink& sink, std::nullptr_t) noexcept
+    {
+      return sink.target == nullptr;
+    }
+
+    /**
+     * @brief Push an event; false when the ring is full or there is none.
+     */
+    bool push(const ButtonEvent& event) const
+    {
+      return pushEvent != nullptr && pushEvent(target, event);
+    }
+
+  private:
+    template <std::size_t Capacity>
+    static bool pushToRing(void* ring, const ButtonEvent& event)
+    {
+      return static_cast<ButtonEventRing<Capacity>*>(ring)->push(event);
+    }
+
+    void* target = nullptr;
+    bool (*pushEvent)(void*, const ButtonEvent&) = nullptr;
+  };
+
   /**
    * @class Button
    * @brief Simple helper for discrete button inputs to identify taps, double
@@ -49,7 +155,26 @@ namespace puara_gestures
    * the button object uses the latest value automatically.
    *
    * If you prefer not to use `tied_data`, call `button.update(value)`
-   * directly with the input value.
+   * directly with the input value. `button.update(in, out)` processes a
+   * block of input values and stores a `ButtonState` after each of them.
+   *
+   * `tap`, `doubleTap` and `tripleTap` are only set for the one update that
+   * ends the tap sequence. To avoid polling them, point `events` at a
+   * `ButtonEventRing` of any capacity and read press, release, tap and hold
+   * transitions from it; `updateAt(value, timestampMicros)` stamps them with
+   * the scan time without reading the clock:
+   * @code
+   * puara_gestures::ButtonEventRing<> events;
+   * puara_gestures::Button button;
+   * button.events = &events;
+   *
+   * button.updateAt(digitalRead(BUTTON_PIN), scanMicros);
+   *
+   * puara_gestures::ButtonEvent event;
+   * while(events.pop(event))
+   *   if(event.type == puara_gestures::ButtonEventType::Tap)
+   *     handleTaps(event.taps);
+   * @endcode
    *
    * @ingroup puara_gestures_descriptors
    */
@@ -57,6 +182,8 @@ class Button
 {
 private:
   long timer = 0;
+  uint64_t lastTimestampMicros = 0;
+  bool hasTimestamp = false;
   const int* tied_data{};
 
 public:
@@ -100,6 +227,24 @@ public:
   unsigned int countInterval = 200;
   unsigned int holdInterval = 5000;
 
+  /**
+   * @brief Queue receiving this button's events, or nullptr for none.
+   *
+   * Assign the address of a `ButtonEventRing<N>` for any `N`.
+   */
+  ButtonEventSink events;
+
+  /**
+   * @brief Reported as `ButtonEvent::button`, to tell buttons apart when
+   * several share one event queue.
+   */
+  uint8_t id = 0;
+
+  /**
+   * @brief Number of events lost because `events` was full.
+   */
+  unsigned int droppedEvents = 0;
+
   /**
    * @brief Update the button from a direct input value.
    *
@@ -108,7 +253,27 @@ public:
    */
   void update(int value)
   {
-    long currentTime = puara_gestures::utils::getCurrentTimeMicroseconds() / 1000LL;
+    updateAt(value, puara_gestures::utils::getCurrentTimeMicroseconds());
+  }
+
+  /**
+   * @brief Update the button from an input value read at a known time.
+   *
+   * Same as `update(int)`, but intervals are measured from `timestampMicros`
+   * instead of the clock, and events are stamped with it. A timestamp earlier
+   * than the previous one (a restarted device, a looping replay) restarts
+   * the running press or tap interval at that time.
+   *
+   * @param value Current button input value.
+   * @param timestampMicros Time of the reading, in microseconds.
+   */
+  void updateAt(int value, uint64_t timestampMicros)
+  {
+    long currentTime = timestampMicros / 1000LL;
+    if(hasTimestamp && timestampMicros < lastTimestampMicros)
+      timer = currentTime;
+    lastTimestampMicros = timestampMicros;
+    hasTimestamp = true;
     value = value;
     if(value >= threshold)
     {
@@ -116,10 +281,12 @@ public:
       {
         press = true;
         timer = currentTime;
+        emit(ButtonEventType::Press, timestampMicros);
       }
-      if(currentTime - timer > holdInterval)
+      if(currentTime - timer > holdInterval && !hold)
       {
         hold = true;
+        emit(ButtonEventType::HoldStart, timestampMicros);
       }
     }
     else if(hold)
@@ -127,6 +294,8 @@ public:
       hold = false;
       press = false;
       count = -1;
+      emit(ButtonEventType::HoldEnd, timestampMicros);
+      emit(ButtonEventType::Release, timestampMicros);
     }
     else
     {
@@ -136,10 +305,14 @@ public:
         pressTime = currentTime - timer;
         timer = currentTime;
         count++;
+        emit(ButtonEventType::Release, timestampMicros);
       }
     }
     if(!press && (currentTime - timer > countInterval))
     {
+      // count is -1 after a hold, which cancels the tap sequence.
+      if(count > 0 && count != static_cast<unsigned int>(-1))
+        emit(ButtonEventType::Tap, timestampMicros, count);
       switch(count)
       {
         case 0:
@@ -167,6 +340,34 @@ public:
     }
   }
 
+  /**
+   * @brief Update the button from a block of input values.
+   *
+   * Equivalent to calling `update(int)` on each value in order.
+   *
+   * @param in Button input values, oldest first.
+   * @param out Receives the button outputs after each value.
+   * @return Number of values processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const int> in, std::span<ButtonState> out)
+  {
+    const std::size_t processed = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < processed; ++i)
+    {
+      Button::update(in[i]);
+      out[i] = state();
+    }
+    return processed;
+  }
+
+  /**
+   * @brief Get a snapshot of the current button outputs.
+   */
+  ButtonState state() const
+  {
+    return ButtonState{count, press, tap, doubleTap, tripleTap, hold, pressTime};
+  }
+
   /**
    * @brief Update the button from the tied external input value.
    *
@@ -186,5 +387,13 @@ public:
       return 0;
     }
   }
+
+private:
+  void emit(ButtonEventType type, uint64_t timestampMicros, unsigned int taps = 0)
+  {
+    if(events
+       && !events.push(ButtonEvent{timestampMicros, type, id, static_cast<uint16_t>(taps)}))
+      ++droppedEvents;
+  }
 };
 }
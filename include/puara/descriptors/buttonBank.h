@@ -0,0 +1,231 @@
+/**
+* @file buttonBank.h
+* @brief Debounced press, tap and hold detection for up to 64 buttons scanned as one bitmask.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+*/
+#pragma once
+
+#include <puara/descriptors/button.h>
+#include <puara/utils/chrono.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace puara_gestures
+{
+
+/**
+ * @class ButtonBank
+ * @brief `Button` for `N` inputs read together, one bit per button.
+ *
+ * @details
+ * A keyboard matrix or a shift-register chain delivers all buttons of a scan
+ * as one word. ButtonBank takes that word, debounces each bit, and runs the
+ * `Button` tap/hold logic on the buttons that need it: pressed buttons,
+ * buttons whose input changed, and buttons with an unfinished tap sequence.
+ * Buttons that stay up cost nothing, so a scan of 32 idle buttons is a few
+ * mask operations.
+ *
+ * A change of input is accepted once it has lasted `debounceInterval`
+ * milliseconds (0 accepts it on the scan that sees it). Accepted changes then
+ * behave as `Button::updateAt()` would with the same intervals, including
+ * the restart of every interval when the scan time goes backwards. All outputs
+ * are events, pushed to `events` and stamped with the scan time; `pressed()`
+ * and `held()` give the current state as bitmasks.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::ButtonBank<32> buttons;
+ *
+ * void loop() {
+ *   buttons.updateAt(scanButtonMatrix(), micros()); // bit i = button i is down
+ *
+ *   puara_gestures::ButtonEvent event;
+ *   while(buttons.events.pop(event))
+ *     if(event.type == puara_gestures::ButtonEventType::Tap && event.taps == 2)
+ *       onDoubleTap(event.button);
+ * }
+ * @endcode
+ *
+ * @tparam N Number of buttons, at most 64. Bit `i` of the scan is button `i`.
+ * @tparam EventCapacity Capacity of the event queue, a power of two.
+ *
+ * @ingroup puara_gestures_descriptors
+ */
+template <std::size_t N, std::size_t EventCapacity = 64>
+class ButtonBank
+{
+  static_assert(N > 0 && N <= 64, "ButtonBank handles 1 to 64 buttons");
+
+public:
+  /**
+   * @brief Time after a release within which another press extends the tap
+   * sequence, in milliseconds, as in `Button`.
+   */
+  unsigned int countInterval = 200;
+
+  /**
+   * @brief Time a button has to stay down to start a hold, in milliseconds,
+   * as in `Button`.
+   */
+  unsigned int holdInterval = 5000;
+
+  /**
+   * @brief Time an input change has to last before it is accepted, in
+   * milliseconds.
+   */
+  unsigned int debounceInterval = 5;
+
+  /**
+   * @brief Events of every button, in scan order.
+   */
+  ButtonEventRing<EventCapacity> events;
+
+  /**
+   * @brief Number of events lost because `events` was full.
+   */
+  unsigned int droppedEvents = 0;
+
+  /**
+   * @brief Process one scan, reading the clock once.
+   * @param bits Bit `i` set when button `i` is down.
+   * @return 1 when the scan is processed.
+   */
+  int update(uint64_t bits) { return updateAt(bits, utils::getCurrentTimeMicroseconds()); }
+
+  /**
+   * @brief Process one scan taken at `timestampMicros`.
+   * @param bits Bit `i` set when button `i` is down.
+   * @param timestampMicros Time of the scan, in microseconds.
+   * @return 1 when the scan is processed.
+   */
+  int updateAt(uint64_t bits, uint64_t timestampMicros)
+  {
+    const uint64_t now = timestampMicros / 1000ULL;
+    bits &= mask;
+
+    // A scan earlier than the previous one restarts every running interval
+    // there, as Button::updateAt() does, instead of letting `now - timer`
+    // wrap around.
+    if(hasTimestamp && timestampMicros < lastTimestampMicros)
+    {
+      for(std::size_t i = 0; i < N; ++i)
+      {
+        timer[i] = now;
+        settleStart[i] = now;
+      }
+    }
+    lastTimestampMicros = timestampMicros;
+    hasTimestamp = true;
+
+    // Debounce: a bit that differs from the accepted state starts settling,
+    // and flips once it has differed for debounceInterval.
+    const uint64_t differing = bits ^ down;
+    settling &= differing;
+    uint64_t toggled = 0;
+    for(uint64_t pending = differing; pending != 0; pending &= pending - 1)
+    {
+      const int i = std::countr_zero(pending);
+      const uint64_t bit = uint64_t(1) << i;
+      if(!(settling & bit))
+      {
+        settling |= bit;
+        settleStart[i] = now;
+      }
+      if(now - settleStart[i] >= debounceInterval)
+        toggled |= bit;
+    }
+    settling &= ~toggled;
+
+    // Button::updateAt on the buttons that can produce an event.
+    for(uint64_t active = toggled | down | counting; active != 0; active &= active - 1)
+    {
+      const int i = std::countr_zero(active);
+      const uint64_t bit = uint64_t(1) << i;
+      const bool isDown = (down ^ toggled) & bit;
+
+      if(isDown)
+      {
+        if(!(down & bit))
+        {
+          timer[i] = now;
+          emit(ButtonEventType::Press, i, timestampMicros);
+        }
+        if(now - timer[i] > holdInterval && !(holding & bit))
+        {
+          holding |= bit;
+          emit(ButtonEventType::HoldStart, i, timestampMicros);
+        }
+      }
+      else if(holding & bit)
+      {
+        // A hold cancels the tap sequence.
+        holding &= ~bit;
+        counting &= ~bit;
+        count[i] = 0;
+        emit(ButtonEventType::HoldEnd, i, timestampMicros);
+        emit(ButtonEventType::Release, i, timestampMicros);
+      }
+      else
+      {
+        if(down & bit)
+        {
+          pressTimes[i] = static_cast<unsigned int>(now - timer[i]);
+          timer[i] = now;
+          ++count[i];
+          counting |= bit;
+          emit(ButtonEventType::Release, i, timestampMicros);
+        }
+        if((counting & bit) && now - timer[i] > countInterval)
+        {
+          emit(ButtonEventType::Tap, i, timestampMicros, count[i]);
+          count[i] = 0;
+          counting &= ~bit;
+        }
+      }
+    }
+    down ^= toggled;
+    return 1;
+  }
+
+  /**
+   * @brief Debounced state: bit `i` set while button `i` is down.
+   */
+  uint64_t pressed() const { return down; }
+
+  /**
+   * @brief Bit `i` set while button `i` is held.
+   */
+  uint64_t held() const { return holding; }
+
+  /**
+   * @brief Duration of the last press of a button, in milliseconds.
+   * @param button Button index, below `N`.
+   */
+  unsigned int pressTime(std::size_t button) const { return pressTimes[button]; }
+
+private:
+  void emit(ButtonEventType type, int button, uint64_t timestampMicros, unsigned int taps = 0)
+  {
+    if(!events.push(ButtonEvent{
+           timestampMicros, type, static_cast<uint8_t>(button), static_cast<uint16_t>(taps)}))
+      ++droppedEvents;
+  }
+
+  static constexpr uint64_t mask = N == 64 ? ~uint64_t(0) : (uint64_t(1) << N) - 1;
+
+  uint64_t down = 0;
+  uint64_t holding = 0;
+  uint64_t counting = 0;
+  uint64_t settling = 0;
+  uint64_t timer[N]{};
+  uint64_t settleStart[N]{};
+  uint64_t lastTimestampMicros = 0;
+  bool hasTimestamp = false;
+  unsigned int count[N]{};
+  unsigned int pressTimes[N]{};
+};
+
+}
@@ -0,0 +1,335 @@
+/**
+* @file gestureEngine.h
+* @brief Gesture processing for many IMUs, sharded over a pool of worker threads.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+* @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+*/
+#pragma once
+
+#include <puara/descriptors/jab.h>
+#include <puara/descriptors/shake.h>
+#include <puara/descriptors/simple_tilt_roll.h>
+#include <puara/utils/imuRecording.h>
+#include <puara/utils/seqlock.h>
+#include <puara/utils/spscRing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace puara_gestures
+{
+/**
+ * @brief Default descriptor chain of a `GestureEngine` device: shake, jab,
+ * and tilt/roll, all from the accelerometer.
+ *
+ * Any type with `update(const utils::ImuSample&)` (or
+ * `update(std::span<const utils::ImuSample>)`), a trivially copyable
+ * `Output` type and `Output output() const` can replace it.
+ */
+struct ImuGestureChain
+{
+  struct Output
+  {
+    uint64_t timestampMicros = 0;
+    Coord3D shake;
+    Coord3D jab;
+    double tilt = 0;
+    double roll = 0;
+  };
+
+  Shake3D shake;
+  Jab3D jab;
+  Tilt_Roll tiltRoll;
+  uint64_t lastTimestampMicros = 0;
+
+  void update(const utils::ImuSample& sample)
+  {
+    shake.updateAt(sample.imu.accl, sample.timestampMicros);
+    jab.update(sample.imu.accl);
+    tiltRoll.update(sample.imu.accl);
+    lastTimestampMicros = sample.timestampMicros;
+  }
+
+  Output output() const
+  {
+    return Output{
+        lastTimestampMicros, shake.current_value(), jab.current_value(),
+        tiltRoll.current_tilt_value(), tiltRoll.current_roll_value()};
+  }
+};
+
+/**
+ * @class GestureEngine
+ * @brief Runs a descriptor chain for each of many devices on a thread pool.
+ *
+ * @details
+ * Each registered device owns a `Chain`, a queue of incoming samples and a
+ * published output. Samples are queued with `ingest()`, from one producer
+ * thread per device (typically the network thread). Each `process()` call is
+ * one round: every device drains its queue through its chain and publishes
+ * its output once, and the call returns when all devices are done.
+ *
+ * A round splits the devices into one contiguous shard per thread; the
+ * calling thread works on the first shard and the pool threads on the
+ * others. A thread that finishes its shard takes devices from the far end of
+ * the other shards, so a shard of busy devices (more samples, or a costlier
+ * chain) is shared out instead of holding back the round. Taking a device is
+ * one compare-and-swap on the shard's packed bounds; no locks are taken.
+ *
+ * Outputs are read with `snapshot()`, from any number of threads and at any
+ * time: each device publishes its output through a `utils::Seqlock` after
+ * its samples of the round, so readers always get a whole output and never
+ * hold up the pool.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::GestureEngine<> engine(4);
+ * for(int i = 0; i < 128; ++i)
+ *   engine.addDevice();
+ *
+ * // network thread
+ * engine.ingest(device, receivedSamples);
+ *
+ * // processing thread, e.g. every 5 ms
+ * engine.process();
+ *
+ * // display threads
+ * puara_gestures::ImuGestureChain::Output out;
+ * if(engine.snapshot(12, out) != lastVersion)
+ *   draw(out.shake);
+ * @endcode
+ *
+ * Host only: it uses `std::thread`.
+ *
+ * @tparam Chain Descriptor chain of each device.
+ * @tparam QueueCapacity Samples queued per device between rounds, a power of two.
+ *
+ * @ingroup puara_gestures_descriptors
+ */
+template <typename Chain = ImuGestureChain, std::size_t QueueCapacity = 256>
+class GestureEngine
+{
+public:
+  using Output = typename Chain::Output;
+
+  /**
+   * @param threads Threads working on each round, including the caller of
+   *        `process()`; 0 uses one per hardware thread.
+   */
+  explicit GestureEngine(std::size_t threads = 0)
+      : shards(std::max<std::size_t>(
+          1, threads != 0 ? threads : std::thread::hardware_concurrency()))
+  {
+    for(std::size_t w = 1; w < shards.size(); ++w)
+      workers.emplace_back([this, w] { workerLoop(w); });
+  }
+
+  GestureEngine(const GestureEngine&) = delete;
+  GestureEngine& operator=(const GestureEngine&) = delete;
+
+  ~GestureEngine()
+  {
+    stopping.store(true, std::memory_order_relaxed);
+    epoch.fetch_add(1, std::memory_order_release);
+    epoch.notify_all();
+    for(auto& worker : workers)
+      worker.join();
+  }
+
+  /**
+   * @brief Register a device. Not concurrent with `process()` or `ingest()`.
+   * @param chain Initial state and settings of the device's descriptors.
+   * @return Device index, used by the other methods.
+   */
+  std::size_t addDevice(Chain chain = {})
+  {
+    devices.push_back(std::make_unique<Device>());
+    devices.back()->chain = std::move(chain);
+    return devices.size() - 1;
+  }
+
+  std::size_t deviceCount() const { return devices.size(); }
+
+  /**
+   * @brief Threads working on each round, including the caller.
+   */
+  std::size_t threadCount() const { return shards.size(); }
+
+  /**
+   * @brief The chain of a device, e.g. to change its settings between rounds.
+   */
+  Chain& chain(std::size_t device) { return devices[device]->chain; }
+
+  /**
+   * @brief Queue samples for the next round. One producer thread per device.
+   * @return Number of samples queued; the rest were dropped because the
+   * queue was full, and are counted in `droppedSamples()`.
+   */
+  std::size_t ingest(std::size_t device, std::span<const utils::ImuSample> samples)
+  {
+    Device& d = *devices[device];
+    const std::size_t queued = d.queue.push(samples);
+    d.dropped += samples.size() - queued;
+    return queued;
+  }
+
+  /**
+   * @brief Samples of a device dropped by `ingest()`. Producer side.
+   */
+  std::size_t droppedSamples(std::size_t device) const { return devices[device]->dropped; }
+
+  /**
+   * @brief Run one round over every device, using the pool.
+   *
+   * Call from one thread at a time.
+   *
+   * @return Number of samples processed.
+   */
+  std::size_t process()
+  {
+    const std::size_t count = devices.size();
+    if(count == 0)
+      return 0;
+
+    // Counters first: a pool thread still leaving the previous round may
+    // take a device as soon as the shards are filled.
+    processed.store(0, std::memory_order_relaxed);
+    remaining.store(count, std::memory_order_relaxed);
+    const std::size_t threads = shards.size();
+    for(std::size_t w = 0; w < threads; ++w)
+      shards[w].bounds.store(
+          pack(count * w / threads, count * (w + 1) / threads), std::memory_order_release);
+    epoch.fetch_add(1, std::memory_order_release);
+    epoch.notify_all();
+
+    work(0);
+    for(std::size_t left = remaining.load(std::memory_order_acquire); left != 0;
+        left = remaining.load(std::memory_order_acquire))
+      remaining.wait(left, std::memory_order_acquire);
+    return processed.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Latest published output of a device. Any thread.
+   * @param out Receives the output.
+   * @return Number of rounds in which the device published, 0 before its
+   * first samples; a reader can compare it with its previous snapshot.
+   */
+  uint64_t snapshot(std::size_t device, Output& out) const
+  {
+    return devices[device]->output.read(out);
+  }
+
+private:
+  struct Device
+  {
+    Chain chain;
+    utils::SpscRing<utils::ImuSample, QueueCapacity> queue;
+    utils::Seqlock<Output> output;
+    std::size_t dropped = 0;
+  };
+
+  // Front (low half) and back (high half) of a shard's remaining devices.
+  struct alignas(64) Shard
+  {
+    std::atomic<uint64_t> bounds{0};
+  };
+
+  static uint64_t pack(std::size_t front, std::size_t back)
+  {
+    return uint64_t(front) | (uint64_t(back) << 32);
+  }
+
+  // The owner takes from the front of its shard, thieves from the back.
+  bool take(std::size_t shard, bool fromFront, std::size_t& device)
+  {
+    auto& bounds = shards[shard].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    for(;;)
+    {
+      const std::size_t front = current & 0xffffffff;
+      const std::size_t back = current >> 32;
+      if(front >= back)
+        return false;
+      const uint64_t next = fromFront ? pack(front + 1, back) : pack(front, back - 1);
+      if(bounds.compare_exchange_weak(
+             current, next, std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+        device = fromFront ? front : back - 1;
+        return true;
+      }
+    }
+  }
+
+  bool steal(std::size_t self, std::size_t& device)
+  {
+    for(std::size_t i = 1; i < shards.size(); ++i)
+      if(take((self + i) % shards.size(), false, device))
+        return true;
+    return false;
+  }
+
+  void work(std::size_t self)
+  {
+    std::size_t device;
+    while(take(self, true, device) || steal(self, device))
+    {
+      processed.fetch_add(run(*devices[device]), std::memory_order_relaxed);
+      if(remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        remaining.notify_all();
+    }
+  }
+
+  static std::size_t run(Device& d)
+  {
+    utils::ImuSample block[64];
+    std::size_t total = 0;
+    // At most one queue's worth, so a fast producer cannot stall the round.
+    while(total < QueueCapacity)
+    {
+      const std::size_t count = d.queue.pop(std::span(block));
+      if(count == 0)
+        break;
+      const std::span<const utils::ImuSample> samples(block, count);
+      if constexpr(requires { d.chain.update(samples); })
+        d.chain.update(samples);
+      else
+        for(const auto& sample : samples)
+          d.chain.update(sample);
+      total += count;
+    }
+    if(total > 0)
+      d.output.write(d.chain.output());
+    return total;
+  }
+
+  void workerLoop(std::size_t self)
+  {
+    uint64_t seen = 0;
+    for(;;)
+    {
+      epoch.wait(seen, std::memory_order_acquire);
+      seen = epoch.load(std::memory_order_acquire);
+      if(stopping.load(std::memory_order_relaxed))
+        return;
+      work(self);
+    }
+  }
+
+  std::vector<std::unique_ptr<Device>> devices;
+  std::vector<Shard> shards;
+  std::vector<std::thread> workers;
+
+  alignas(64) std::atomic<uint64_t> epoch{0};
+  std::atomic<bool> stopping{false};
+  alignas(64) std::atomic<std::size_t> remaining{0};
+  alignas(64) std::atomic<std::size_t> processed{0};
+};
+}
@@ -9,7 +9,11 @@
 #pragma once
 
 #include <puara/structs.h>
-#include <puara/utils.h>
+#include <puara/utils/rollingminmax.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
 
 namespace puara_gestures
 {
@@ -36,7 +40,8 @@ namespace puara_gestures
  * @endcode
  *
  * You can also use `update(data)` directly if you do not want to tie an
- * external variable. `Jab2D` and `Jab3D` follow the same pattern for 2D and 3D axes.
+ * external variable, or `update(in, out)` to process a block of samples at
+ * once. `Jab2D` and `Jab3D` follow the same pattern for 2D and 3D axes.
  *
  * @ingroup puara_gestures_descriptors
  */
@@ -112,6 +117,25 @@ public:
     return value;
   }
 
+  /**
+   * @brief Update the jab detector with a block of input samples.
+   *
+   * Equivalent to calling `update(double)` on each sample in order.
+   *
+   * @param in Axis samples, oldest first.
+   * @param out Receives the jab score after each sample.
+   * @return Number of samples processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const double> in, std::span<double> out)
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      out[i] = Jab::update(in[i]);
+    }
+    return count;
+  }
+
   /**
    * @brief Update the detector from a `Coord1D` sample.
    * @param reading The sampled coordinate containing the X axis value.
@@ -165,7 +189,7 @@ private:
   double value = 0;
 
   /** Keep track of the min and max values over the last 10 times Jab::update() was called. */
-  puara_gestures::utils::RollingMinMax<double> minmax{};
+  puara_gestures::utils::RollingMinMax<double, 10> minmax{};
 };
 
 /**
@@ -233,6 +257,25 @@ public:
     return 1;
   }
 
+  /**
+   * @brief Update both X and Y jab detectors with a block of samples.
+   *
+   * Equivalent to calling `update(Coord2D)` on each sample in order.
+   *
+   * @param in 2D samples, oldest first.
+   * @param out Receives the jab scores after each sample.
+   * @return Number of samples processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const Coord2D> in, std::span<Coord2D> out)
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].x = x.update(in[i].x);
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].y = y.update(in[i].y);
+    return count;
+  }
+
   /**
    * @brief Update both X and Y detectors using tied external input values.
    * @return 1 when the update is processed.
@@ -346,6 +389,27 @@ public:
     return 1;
   }
 
+  /**
+   * @brief Update the detectors with a block of 3D samples.
+   *
+   * Equivalent to calling `update(Coord3D)` on each sample in order.
+   *
+   * @param in 3D samples, oldest first.
+   * @param out Receives the jab scores after each sample.
+   * @return Number of samples processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const Coord3D> in, std::span<Coord3D> out)
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].x = x.update(in[i].x);
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].y = y.update(in[i].y);
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].z = z.update(in[i].z);
+    return count;
+  }
+
   /**
    * @brief Update the detectors using tied external input values.
    * @return 1 when the update is processed.
@@ -0,0 +1,166 @@
+/**
+* @file jabBank.h
+* @brief Jab detection for many 3D sensors at once, with structure-of-arrays state.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+*/
+#pragma once
+
+#include <puara/structs.h>
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+namespace puara_gestures
+{
+
+/**
+ * @class JabBank
+ * @brief `Jab3D` for `N` devices, updated in a single pass.
+ *
+ * @details
+ * JabBank keeps the recent history of all `3 * N` channels as `Window` rows
+ * of contiguous samples (axis-major: all X channels, then all Y, then all Z).
+ * Each update writes one row and scans the rows channel-parallel, so the
+ * min/max and scoring loops run branch-free over contiguous memory and are
+ * vectorized by the compiler for the host (SSE/AVX, NEON) without intrinsics.
+ *
+ * With the default window of 10 samples, each device produces exactly the
+ * values of a `Jab3D` with the same threshold.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::JabBank<64> jabs;
+ * jabs.threshold = 3;
+ *
+ * std::array<puara_gestures::Coord3D, 64> accel = readAllAccelerometers();
+ * jabs.update(accel);
+ * puara_gestures::Coord3D score = jabs.current_value(12); // device 12
+ * @endcode
+ *
+ * @tparam N Number of 3D devices.
+ * @tparam Window Number of recent samples scanned for the min and max.
+ *
+ * @ingroup puara_gestures_descriptors
+ */
+template <std::size_t N, std::size_t Window = 10>
+class JabBank
+{
+public:
+  static_assert(Window > 0, "JabBank window must hold at least one sample");
+
+  /**
+   * @brief Number of scalar channels (three per device).
+   */
+  static constexpr std::size_t channels = 3 * N;
+
+  /**
+   * @brief Threshold for detected jab motion, shared by every channel.
+   */
+  int threshold = 5;
+
+  /**
+   * @brief Update every device from AoS samples.
+   * @param readings One 3D sample per device.
+   * @return 1 when the update is processed.
+   */
+  int update(std::span<const Coord3D, N> readings)
+  {
+    auto& row = history[head];
+    for(std::size_t i = 0; i < N; ++i)
+    {
+      row[i] = readings[i].x;
+      row[N + i] = readings[i].y;
+      row[2 * N + i] = readings[i].z;
+    }
+    process();
+    return 1;
+  }
+
+  /**
+   * @brief Update every device from SoA samples.
+   * @param x X-axis sample of each device.
+   * @param y Y-axis sample of each device.
+   * @param z Z-axis sample of each device.
+   * @return 1 when the update is processed.
+   */
+  int update(
+      std::span<const double, N> x, std::span<const double, N> y,
+      std::span<const double, N> z)
+  {
+    auto& row = history[head];
+    for(std::size_t i = 0; i < N; ++i)
+    {
+      row[i] = x[i];
+      row[N + i] = y[i];
+      row[2 * N + i] = z[i];
+    }
+    process();
+    return 1;
+  }
+
+  /**
+   * @brief Get the jab score of one device.
+   * @param device Device index, below `N`.
+   */
+  Coord3D current_value(std::size_t device) const
+  {
+    return Coord3D{value[device], value[N + device], value[2 * N + device]};
+  }
+
+  /**
+   * @brief Jab score of every channel, axis-major.
+   */
+  std::span<const double, channels> values() const { return value; }
+
+  /**
+   * @brief Forget the history and reset every score to zero.
+   */
+  void reset()
+  {
+    value.fill(0.0);
+    head = 0;
+    filled = 0;
+  }
+
+private:
+  void process()
+  {
+    const auto& newest = history[head];
+    head = (head + 1 == Window) ? 0 : head + 1;
+    if(filled < Window)
+      ++filled;
+
+    minimum = newest;
+    maximum = newest;
+    for(std::size_t r = 0; r < filled; ++r)
+    {
+      const auto& row = history[r];
+      for(std::size_t c = 0; c < channels; ++c)
+      {
+        minimum[c] = row[c] < minimum[c] ? row[c] : minimum[c];
+        maximum[c] = row[c] > maximum[c] ? row[c] : maximum[c];
+      }
+    }
+
+    const double limit = threshold;
+    for(std::size_t c = 0; c < channels; ++c)
+    {
+      const double range = maximum[c] - minimum[c];
+      // Same scoring as Jab: negative when the whole window is below zero,
+      // which is the case exactly when the maximum is.
+      const double score = maximum[c] < 0 ? -range : range;
+      value[c] = range > limit ? score : value[c];
+    }
+  }
+
+  std::array<std::array<double, channels>, Window> history{};
+  std::array<double, channels> minimum{};
+  std::array<double, channels> maximum{};
+  std::array<double, channels> value{};
+  std::size_t head = 0;
+  std::size_t filled = 0;
+};
+
+}
@@ -11,6 +11,12 @@
 #include <puara/structs.h>
 #include <puara/utils.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
 namespace puara_gestures
 {
 
@@ -41,6 +47,10 @@ namespace puara_gestures
  *
  * `Shake2D` and `Shake3D` work the same way for two or three axes.
  *
+ * When samples arrive in blocks (a sensor FIFO, a recorded session), pass
+ * the whole block at once with `update(in, out)`; the results are the same
+ * as calling `update(reading)` on each sample.
+ *
  * @ingroup puara_gestures_descriptors
  */
 class Shake
@@ -93,22 +103,51 @@ public:
     {
       *tied_value = reading;
     }
+    return process(reading);
+  }
 
-    double abs_reading = std::abs(reading);
+  /**
+   * @brief Update the shake detector with a reading taken at a known time.
+   *
+   * Same as `update(double)`, but the integrator uses `timestampMicros`
+   * instead of reading the clock, so recorded data replays identically.
+   *
+   * @param reading The axis reading.
+   * @param timestampMicros Sample time in microseconds, from any monotonic origin.
+   * @return The current shake energy value.
+   */
+  double updateAt(double reading, uint64_t timestampMicros)
+  {
+    if(tied_value != nullptr)
+    {
+      *tied_value = reading;
+    }
+    return process(reading, timestampMicros);
+  }
 
-    if(abs_reading > threshold)
+  /**
+   * @brief Update the shake detector with a block of axis readings.
+   *
+   * Equivalent to calling `update(double)` on each reading in order. If the
+   * detector is tied to external input, the tied value receives the last
+   * reading of the block.
+   *
+   * @param in Axis readings, oldest first.
+   * @param out Receives the shake energy after each reading.
+   * @return Number of samples processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const double> in, std::span<double> out)
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < count; ++i)
     {
-      integrator.integrate(abs_reading / 10, fast_leak);
+      out[i] = process(in[i]);
     }
-    else
+    if(count > 0 && tied_value != nullptr)
     {
-      integrator.integrate(0.0, slow_leak);
-      if( integrator.current_value < (threshold/10) )
-      {
-        integrator.current_value = 0;
-      }
+      *tied_value = in[count - 1];
     }
-    return integrator.current_value;
+    return count;
   }
 
   /**
@@ -175,6 +214,33 @@ public:
 
 private:
   double* tied_value{};
+
+  double process(double reading, std::optional<uint64_t> timestampMicros = std::nullopt)
+  {
+    double abs_reading = std::abs(reading);
+
+    if(abs_reading > threshold)
+    {
+      integrate(abs_reading / 10, fast_leak, timestampMicros);
+    }
+    else
+    {
+      integrate(0.0, slow_leak, timestampMicros);
+      if( integrator.current_value < (threshold/10) )
+      {
+        integrator.current_value = 0;
+      }
+    }
+    return integrator.current_value;
+  }
+
+  void integrate(double input, double leak, std::optional<uint64_t> timestampMicros)
+  {
+    if(timestampMicros)
+      integrator.integrateAt(input, leak, *timestampMicros);
+    else
+      integrator.integrate(input, leak);
+  }
 };
 
 /**
@@ -244,6 +310,39 @@ public:
     return 1;
   }
 
+  /**
+   * @brief Update both X and Y shake detectors from a sample taken at a known time.
+   * @param reading The sampled 2D coordinate.
+   * @param timestampMicros Sample time in microseconds.
+   * @return 1 when the update is processed.
+   */
+  int updateAt(Coord2D reading, uint64_t timestampMicros)
+  {
+    x.updateAt(reading.x, timestampMicros);
+    y.updateAt(reading.y, timestampMicros);
+    return 1;
+  }
+
+  /**
+   * @brief Update both X and Y shake detectors with a block of samples.
+   *
+   * Equivalent to calling `update(Coord2D)` on each sample in order. Each
+   * axis runs through the whole block before the next one.
+   *
+   * @param in 2D samples, oldest first.
+   * @param out Receives the shake energy after each sample.
+   * @return Number of samples processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const Coord2D> in, std::span<Coord2D> out)
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].x = x.update(in[i].x);
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].y = y.update(in[i].y);
+    return count;
+  }
+
   /**
    * @brief Update both X and Y shake detectors using tied input values.
    * @return 1 when the update is processed.
@@ -367,6 +466,42 @@ public:
     return 1;
   }
 
+  /**
+   * @brief Update all three shake detectors from a sample taken at a known time.
+   * @param reading The sampled 3D coordinate.
+   * @param timestampMicros Sample time in microseconds.
+   * @return 1 when the update is processed.
+   */
+  int updateAt(Coord3D reading, uint64_t timestampMicros)
+  {
+    x.updateAt(reading.x, timestampMicros);
+    y.updateAt(reading.y, timestampMicros);
+    z.updateAt(reading.z, timestampMicros);
+    return 1;
+  }
+
+  /**
+   * @brief Update the 3D shake detector with a block of samples.
+   *
+   * Equivalent to calling `update(Coord3D)` on each sample in order. Each
+   * axis runs through the whole block before the next one.
+   *
+   * @param in 3D samples, oldest first.
+   * @param out Receives the shake energy after each sample.
+   * @return Number of samples processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const Coord3D> in, std::span<Coord3D> out)
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].x = x.update(in[i].x);
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].y = y.update(in[i].y);
+    for(std::size_t i = 0; i < count; ++i)
+      out[i].z = z.update(in[i].z);
+    return count;
+  }
+
   /**
    * @brief Update the 3D shake detector using tied input values.
    * @return 1 when the update is processed.
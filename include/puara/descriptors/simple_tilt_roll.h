@@ -10,12 +10,18 @@
 
 #include <puara/structs.h>
 #include <puara/utils.h>
+#include <puara/utils/fastmath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
 
 namespace puara_gestures
 {
 
 /**
- * @class Tilt_Roll
+ * @class Tilt_RollT
  * @brief Lightweight 3DoF tilt and roll extractor for IMUs without a magnetometer.
  *
  * @ingroup puara_gestures_descriptors
@@ -28,6 +34,9 @@ namespace puara_gestures
  * It can optionally use a tied `Coord3D` pointer so the caller may update raw
  * IMU data externally and then call `update()` without parameters.
  *
+ * `Tilt_Roll` uses the standard library's `atan2`; `Tilt_RollT<fastmath::FastMath>`
+ * uses the polynomial approximation of fastmath.h instead, within 1e-9 rad.
+ *
  * @note The `three_dof_tilt_roll` and `simple_tilt_roll` aliases are provided
  * for backwards compatibility and refer to the same `Tilt_Roll` type.
  *
@@ -59,27 +68,30 @@ namespace puara_gestures
  *   Serial.println(tilt);
  * }
  * @endcode
+ *
+ * @tparam Math Math policy, `fastmath::StdMath` or `fastmath::FastMath`.
  */
-class Tilt_Roll
+template <typename Math = fastmath::StdMath>
+class Tilt_RollT
 {
 public:
-  Tilt_Roll() noexcept
+  Tilt_RollT() noexcept
       : tied_x(nullptr)
       , tied_y(nullptr)
       , tied_z(nullptr)
   {
   }
 
-  Tilt_Roll(const Tilt_Roll&) noexcept = default;
-  Tilt_Roll(Tilt_Roll&&) noexcept = default;
-  Tilt_Roll& operator=(const Tilt_Roll&) noexcept = default;
-  Tilt_Roll& operator=(Tilt_Roll&&) noexcept = default;
+  Tilt_RollT(const Tilt_RollT&) noexcept = default;
+  Tilt_RollT(Tilt_RollT&&) noexcept = default;
+  Tilt_RollT& operator=(const Tilt_RollT&) noexcept = default;
+  Tilt_RollT& operator=(Tilt_RollT&&) noexcept = default;
 
   /**
    * @brief Construct a tilt/roll extractor tied to an external IMU sample.
    * @param tied Pointer to a `Coord3D` containing accelerometer data.
    */
-  explicit Tilt_Roll(Coord3D* tied)
+  explicit Tilt_RollT(Coord3D* tied)
     : tied_x(&(tied->x))
     , tied_y(&(tied->y))
     , tied_z(&(tied->z))
@@ -96,12 +108,10 @@ public:
    */
   int update(double accelx, double accely, double accelz)
   {
-    // calculate polar representation of accelerometer data
-    roll = atan2(accelz, accely);
-    magnitude = sqrt(pow(accelz, 2) + pow(accely, 2));
-    tilt = atan2(accelx, magnitude);
-    magnitude = sqrt(pow(accelx, 2) + pow(magnitude, 2));
-    magnitude *= 0.00390625;
+    const Simple_Orientation orientation = compute(accelx, accely, accelz);
+    roll = orientation.roll;
+    tilt = orientation.tilt;
+    magnitude = orientation.magnitude;
 
     return 1;
   }
@@ -117,6 +127,33 @@ public:
     return 1;
   }
 
+  /**
+   * @brief Update tilt and roll from a block of accelerometer samples.
+   *
+   * Each output only depends on its own sample, so the block is processed
+   * without touching the object state until the last sample, which becomes
+   * the current value as if `update(Coord3D)` had been called on it.
+   *
+   * @param in Accelerometer samples, oldest first.
+   * @param out Receives the roll, tilt and magnitude of each sample.
+   * @return Number of samples processed, the smaller of the two sizes.
+   */
+  std::size_t update(std::span<const Coord3D> in, std::span<Simple_Orientation> out)
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      out[i] = compute(in[i].x, in[i].y, in[i].z);
+    }
+    if(count > 0)
+    {
+      roll = out[count - 1].roll;
+      tilt = out[count - 1].tilt;
+      magnitude = out[count - 1].magnitude;
+    }
+    return count;
+  }
+
   /**
    * @brief Update tilt and roll from the tied external IMU sample.
    *
@@ -183,6 +220,18 @@ public:
   }
 
 private:
+  static Simple_Orientation compute(double accelx, double accely, double accelz)
+  {
+    // calculate polar representation of accelerometer data
+    Simple_Orientation result;
+    result.roll = Math::atan2(accelz, accely);
+    const double magnitudeYZ = std::sqrt(accelz * accelz + accely * accely);
+    result.tilt = Math::atan2(accelx, magnitudeYZ);
+    result.magnitude
+        = std::sqrt(accelx * accelx + magnitudeYZ * magnitudeYZ) * 0.00390625;
+    return result;
+  }
+
   const double* tied_x;
   const double* tied_y;
   const double* tied_z;
@@ -191,6 +240,7 @@ private:
   double magnitude = 0;
 };
 
+using Tilt_Roll = Tilt_RollT<>;
 using three_dof_tilt_roll = Tilt_Roll;
 using simple_tilt_roll = three_dof_tilt_roll;
 
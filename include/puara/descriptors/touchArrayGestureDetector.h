@@ -8,11 +8,30 @@
 */
 #pragma once
 
+#include <puara/utils/bitArray.h>
 #include <puara/utils/blobDetector.h>
 #include "brushRub.h"
+#include "brushRubBank.h"
+
+#include <cstdint>
+#include <optional>
 
 namespace puara_gestures
 {
+/**
+ * @brief Snapshot of the public TouchArrayGestureDetector outputs, e.g. to
+ * publish through a `utils::Seqlock`.
+ */
+struct TouchArrayState
+{
+  float totalTouchAverage = 0;
+  float topTouchAverage = 0;
+  float middleTouchAverage = 0;
+  float bottomTouchAverage = 0;
+  float totalBrush = 0;
+  float totalRub = 0;
+};
+
 /**
  * @class TouchArrayGestureDetector
  * @brief Detects touch gestures on a 1D touch sensor array.
@@ -21,6 +40,13 @@ namespace puara_gestures
  * for the top, middle and bottom regions. It also detects contiguous touch
  * blobs and tracks simple brush/rub motion for each blob.
  *
+ * Each finger keeps its own brush/rub channel while it stays on the array:
+ * every frame, blobs are matched to the previous frame's fingers by nearest
+ * center (closest pairs first, within `maxTrackDistance` stripes). Fingers
+ * appearing or lifting elsewhere on the array therefore do not shift which
+ * integrator a moving finger feeds. A new finger starts its integrators at
+ * its own position; a lifted finger decays like a finger that stopped moving.
+ *
  * Example usage:
  * @code{.cpp}
  * #include <puara/descriptors/touchArrayGestureDetector.h>
@@ -58,6 +84,11 @@ namespace puara_gestures
  * element is either 1 (touch present) or 0 (no touch). After `update()` it
  * computes region averages and gesture motion values.
  *
+ * For long arrays, `update()` also accepts the touch array packed one stripe
+ * per bit (`utils::packBits()`, or straight from the sensor driver). Averages
+ * then come from popcounts and blobs from bit scans, with results identical to
+ * the int overload.
+ *
  * @ingroup puara_gestures_descriptors
  * @tparam maxNumBlobs The maximum number of touch blobs that can be detected.
  * @tparam touchSizeEdge The number of stripes reserved for the top and bottom regions.
@@ -102,6 +133,12 @@ public:
    */
   float totalRub{};
 
+  /**
+   * @brief Largest blob center displacement, in stripes per frame, for which
+   * a blob is considered the same finger as in the previous frame.
+   */
+  float maxTrackDistance = 4.0f;
+
   /**
    * @brief Update the touch array detector with a new touch sample.
    *
@@ -112,6 +149,73 @@ public:
    * @param touchSize Number of elements in the touch array.
    */
   void update(int* touchArray, int touchSize)
+  {
+    updateImpl(touchArray, touchSize, std::nullopt);
+  }
+
+  /**
+   * @brief Update the detector with a touch sample taken at a known time.
+   *
+   * Same as `update(int*, int)`, but the brush and rub integrators use
+   * `timestampMicros` instead of reading the clock.
+   */
+  void updateAt(int* touchArray, int touchSize, uint64_t timestampMicros)
+  {
+    updateImpl(touchArray, touchSize, timestampMicros);
+  }
+
+  /**
+   * @brief Update the detector with a bit-packed touch sample.
+   *
+   * @param touchBits Touch array where bit `i` (see `utils::packBits()`) is set
+   *        when stripe `i` is touched.
+   * @param touchSize Number of stripes in the touch array.
+   */
+  void update(const uint64_t* touchBits, int touchSize)
+  {
+    updateImpl(touchBits, touchSize, std::nullopt);
+  }
+
+  /**
+   * @brief Update the detector with a bit-packed touch sample taken at a known time.
+   */
+  void updateAt(const uint64_t* touchBits, int touchSize, uint64_t timestampMicros)
+  {
+    updateImpl(touchBits, touchSize, timestampMicros);
+  }
+
+  /**
+   * @brief Get a snapshot of the current detector outputs.
+   */
+  TouchArrayState state() const
+  {
+    return TouchArrayState{
+        totalTouchAverage, topTouchAverage, middleTouchAverage, bottomTouchAverage,
+        totalBrush, totalRub};
+  }
+
+private:
+  BlobDetector<maxNumBlobs> blobDetector;
+  BrushRubBank<maxNumBlobs> brushRub;
+
+  // Finger tracks, one per brushRub channel: whether a blob fed it in the
+  // last frame, and that blob's center and start position.
+  bool trackActive[maxNumBlobs]{};
+  float trackCenter[maxNumBlobs]{};
+  int trackStartPos[maxNumBlobs]{};
+  // The active tracks from left to right, like the blobs that fed them.
+  int trackOrder[maxNumBlobs]{};
+  int activeCount = 0;
+
+  // Same arithmetic as utils::arrayAverage so both overloads agree exactly.
+  static float bitAverage(const uint64_t* touchBits, int start, int end)
+  {
+    const float sum = utils::countBits(touchBits, start, end);
+    const auto count = end - start;
+    return (count > 0) ? (sum / count) : 0.0;
+  }
+
+  void updateImpl(int* touchArray, int touchSize, std::optional<uint64_t> timestampMicros)
   {
     // Update the "amount of touch" for the entire touch sensor, as well as the top, middle and bottom parts.
     // All normalized between 0 and 1.
@@ -123,18 +227,84 @@ public:
     //detect blobs on the touch array
     blobDetector.detect1D(touchArray, touchSize);
 
-    //based on the start position of detected blobs, update the brush and rub detector
-    for(int i = 0; i < maxNumBlobs; ++i)
-      brushRubDetector[i].update(blobDetector.blobStartPos[i]);
+    updateBrushAndRub(timestampMicros);
+  }
+
+  void updateImpl(const uint64_t* touchBits, int touchSize, std::optional<uint64_t> timestampMicros)
+  {
+    totalTouchAverage = bitAverage(touchBits, 0, touchSize);
+    topTouchAverage = bitAverage(touchBits, 0, touchSizeEdge);
+    middleTouchAverage = bitAverage(touchBits, (0 + touchSizeEdge), (touchSize - touchSizeEdge));
+    bottomTouchAverage = bitAverage(touchBits, (touchSize - touchSizeEdge), touchSize);
+
+    blobDetector.detect1D(touchBits, touchSize);
+
+    updateBrushAndRub(timestampMicros);
+  }
+
+  void updateBrushAndRub(std::optional<uint64_t> timestampMicros)
+  {
+    //match the detected blobs to the fingers of the previous frame; both are
+    //ordered by position
+    float activeCenter[maxNumBlobs];
+    for(int i = 0; i < activeCount; ++i)
+      activeCenter[i] = trackCenter[trackOrder[i]];
+    int match[maxNumBlobs];
+    detail::matchNearestSorted<maxNumBlobs>(
+        blobDetector.blobCenter, blobDetector.blobCount, activeCenter, activeCount,
+        maxTrackDistance, match);
+
+    bool fed[maxNumBlobs]{};
+    int blobTrack[maxNumBlobs];
+    for(int b = 0; b < blobDetector.blobCount; ++b)
+    {
+      blobTrack[b] = match[b] >= 0 ? trackOrder[match[b]] : -1;
+      if(blobTrack[b] >= 0)
+        fed[blobTrack[b]] = true;
+    }
+
+    //new fingers take a free track, preferring one that is already idle
+    for(int b = 0; b < blobDetector.blobCount; ++b)
+    {
+      if(blobTrack[b] >= 0)
+        continue;
+      int track = -1;
+      for(int t = 0; t < maxNumBlobs && track < 0; ++t)
+        if(!fed[t] && !trackActive[t])
+          track = t;
+      for(int t = 0; t < maxNumBlobs && track < 0; ++t)
+        if(!fed[t])
+          track = t;
+
+      blobTrack[b] = track;
+      fed[track] = true;
+      brushRub.setPosition(track, blobDetector.blobStartPos[b]);
+    }
+
+    for(int b = 0; b < blobDetector.blobCount; ++b)
+    {
+      trackCenter[blobTrack[b]] = blobDetector.blobCenter[b];
+      trackStartPos[blobTrack[b]] = blobDetector.blobStartPos[b];
+      trackOrder[b] = blobTrack[b];
+    }
+    activeCount = blobDetector.blobCount;
+    for(int t = 0; t < maxNumBlobs; ++t)
+      trackActive[t] = fed[t];
+
+    //update the brush and rub of each finger; lifted fingers keep their last
+    //position
+    double positions[maxNumBlobs];
+    for(int t = 0; t < maxNumBlobs; ++t)
+      positions[t] = trackStartPos[t];
+    if(timestampMicros)
+      brushRub.updateAt(positions, *timestampMicros);
+    else
+      brushRub.update(positions);
 
     //and finally update the total brush and rub values
     updateTotalBrushAndRub();
   }
 
-private:
-  BlobDetector<maxNumBlobs> blobDetector;
-  BrushRubDetector brushRubDetector[maxNumBlobs];
-
   /**
    * @brief Recalculate the aggregated brush and rub totals for active blobs.
    *
@@ -144,16 +314,8 @@ private:
   void updateTotalBrushAndRub()
   {
     // Calculate total brush and rub values
-    double brushes[maxNumBlobs];
-    double rubs[maxNumBlobs];
-    for(int i = 0; i < maxNumBlobs; ++i)
-    {
-      brushes[i] = brushRubDetector[i].brush.value;
-      rubs[i] = brushRubDetector[i].rub.value;
-    }
-
-    totalBrush = utils::arrayAverageWithoutZero(brushes, maxNumBlobs);
-    totalRub = utils::arrayAverageWithoutZero(rubs, maxNumBlobs);
+    totalBrush = utils::arrayAverageWithoutZero(brushRub.brushValues().data(), maxNumBlobs);
+    totalRub = utils::arrayAverageWithoutZero(brushRub.rubValues().data(), maxNumBlobs);
   }
 };
 }
\ No newline at end of file
@@ -9,10 +9,14 @@
 #pragma once
 
 #include <IMU_Sensor_Fusion/imu_orientation.h>
+#include <puara/descriptors/brushRubBank.h>
 #include <puara/descriptors/button.h>
+#include <puara/descriptors/buttonBank.h>
 #include <puara/descriptors/jab.h>
+#include <puara/descriptors/jabBank.h>
 #include <puara/descriptors/roll.h>
 #include <puara/descriptors/shake.h>
+#include <puara/descriptors/shakeBank.h>
 #include <puara/descriptors/simple_tilt_roll.h>
 #include <puara/descriptors/tilt.h>
 #include <puara/descriptors/touchArrayGestureDetector.h>
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <type_traits>
 #include <vector>
 
 namespace puara_gestures
@@ -38,12 +39,25 @@ struct Coord2D
 
 /**
  * @brief Three-dimensional coordinate or sensor sample.
+ *
+ * Templated on the scalar type so that orientation filters can run in single
+ * precision on targets without a double-precision FPU. `Coord3D` is the
+ * double-precision type used everywhere else.
  */
-struct Coord3D
+template <typename T>
+struct Coord3DT
 {
-  double x = 0.0, y = 0.0, z = 0.0;
+  T x = 0, y = 0, z = 0;
+
+  template <typename U>
+  explicit operator Coord3DT<U>() const
+  {
+    return {static_cast<U>(x), static_cast<U>(y), static_cast<U>(z)};
+  }
 };
 
+using Coord3D = Coord3DT<double>;
+
 struct Simple_Orientation
 {
   double roll = 0.0, tilt = 0.0, magnitude = 0.0;
@@ -59,42 +73,92 @@ struct Simple_Orientation
  *   - yaw  = azimuth
  *   - pitch = elevation
  *   - r = distance
+ *
+ * Each alias shares storage with its field through an anonymous union, so the
+ * struct is four plain doubles: trivially copyable, standard-layout and safe to
+ * store in contiguous arrays or copy with memcpy.
+ *
+ * Reading an alias after writing its field (or the reverse) reads the inactive
+ * member of the union, which ISO C++ leaves undefined. GCC, Clang and MSVC
+ * define it as reading the shared bytes, and the aliases rely on that. The
+ * library itself only uses the canonical names (azimuth, elevation,
+ * distance); code that must stay within the standard should do the same.
  */
 struct Spherical
 {
-  double azimuth = 0.0;
-  double& yaw = azimuth;
-  double elevation = 0.0;
-  double& pitch = elevation;
-  double distance = 0.0;
-  double& r = distance;
+  union
+  {
+    double azimuth = 0.0;
+    double yaw;
+  };
+  union
+  {
+    double elevation = 0.0;
+    double pitch;
+  };
+  union
+  {
+    double distance = 0.0;
+    double r;
+  };
   double roll = 0.0;
 };
 
+static_assert(sizeof(Spherical) == 4 * sizeof(double));
+static_assert(std::is_trivially_copyable_v<Spherical>);
+static_assert(std::is_standard_layout_v<Spherical>);
+
 /**
  * @brief Quaternion representation for 3D rotation or orientation.
  */
-struct Quaternion
+template <typename T>
+struct QuaternionT
 {
-  double w = 1.0, x = 0.0, y = 0.0, z = 0.0;
+  T w = 1, x = 0, y = 0, z = 0;
+
+  template <typename U>
+  explicit operator QuaternionT<U>() const
+  {
+    return {static_cast<U>(w), static_cast<U>(x), static_cast<U>(y), static_cast<U>(z)};
+  }
 };
 
+using Quaternion = QuaternionT<double>;
+
 /**
  * @brief Six-axis IMU sample containing accelerometer and gyroscope data.
  */
-struct Imu6Axis
+template <typename T>
+struct Imu6AxisT
 {
-  Coord3D accl, gyro;
+  Coord3DT<T> accl, gyro;
+
+  template <typename U>
+  explicit operator Imu6AxisT<U>() const
+  {
+    return {Coord3DT<U>(accl), Coord3DT<U>(gyro)};
+  }
 };
 
+using Imu6Axis = Imu6AxisT<double>;
+
 /**
  * @brief Nine-axis IMU sample containing accelerometer, gyroscope, and magnetometer data.
  */
-struct Imu9Axis
+template <typename T>
+struct Imu9AxisT
 {
-  Coord3D accl, gyro, magn;
+  Coord3DT<T> accl, gyro, magn;
+
+  template <typename U>
+  explicit operator Imu9AxisT<U>() const
+  {
+    return {Coord3DT<U>(accl), Coord3DT<U>(gyro), Coord3DT<U>(magn)};
+  }
 };
 
+using Imu9Axis = Imu9AxisT<double>;
+
 /**
  * @brief Simple container for a fixed-sized integer array.
  *
@@ -18,23 +18,35 @@
 #pragma once
 
 #include <puara/structs.h>
+#include <puara/utils/bitArray.h>
 #include <puara/utils/blobDetector.h>
+#include <puara/utils/bitShift.h>
 #include <puara/utils/calibration.h>
 #include <puara/utils/chrono.h>
 #include <puara/utils/circularbuffer.h>
+#include <puara/utils/circularbufferRuntime.h>
 #include <puara/utils/discretizer.h>
+#include <puara/utils/fastmath.h>
 #include <puara/utils/includeEigen.h>
 #include <puara/utils/leakyintegrator.h>
 #include <puara/utils/maprange.h>
 #include <puara/utils/rollingminmax.h>
+#include <puara/utils/seqlock.h>
 #include <puara/utils/smooth.h>
+#include <puara/utils/spscRing.h>
 #include <puara/utils/threshold.h>
+#include <puara/utils/tripleBuffer.h>
 #include <puara/utils/wrap.h>
 #include <puara/utils/kalmanQuaternion.h>
+#include <puara/utils/madgwickBank.h>
 #include <puara/utils/madgwickQuaternion.h>
 #include <puara/utils/mahonyQuaternion.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <span>
 #include <boost/math/constants/constants.hpp>
 
 
@@ -104,7 +116,7 @@ float arrayAverage(const T* array, int start, int end)
  * the passed Array that is == 0 is ignored in the average calculation.
  */
 
-inline double arrayAverageWithoutZero(double* Array, int ArraySize)
+inline double arrayAverageWithoutZero(const double* Array, int ArraySize)
 {
   double sum = 0;
   int count = 0;
@@ -127,6 +139,9 @@ inline double arrayAverageWithoutZero(double* Array, int ArraySize)
 /**
  * @brief Legacy function used to calculate 1D blob detection in older
  * digital musical instruments.
+ *
+ * Takes `shift` passes over the array. For byte buffers, `bitShiftLeft()` in
+ * bitShift.h gives the same result (masked to 8 bits) in a single pass.
  */
 inline void bitShiftArrayL(int* origArray, int* shiftedArray, int arraySize, int shift)
 {
@@ -249,10 +264,10 @@ inline Coord3D spheric_to_cartesian(Spherical sphericCoords)
   Coord3D cartesianCoords;
 
   cartesianCoords.x
-      = sphericCoords.r * cos(sphericCoords.azimuth) * sin(sphericCoords.elevation);
+      = sphericCoords.distance * cos(sphericCoords.azimuth) * sin(sphericCoords.elevation);
   cartesianCoords.y
-      = sphericCoords.r * sin(sphericCoords.elevation) * sin(sphericCoords.azimuth);
-  cartesianCoords.z = sphericCoords.r * cos(sphericCoords.elevation);
+      = sphericCoords.distance * sin(sphericCoords.elevation) * sin(sphericCoords.azimuth);
+  cartesianCoords.z = sphericCoords.distance * cos(sphericCoords.elevation);
 
   return cartesianCoords;
 }
@@ -269,10 +284,10 @@ inline Spherical cartesian_to_spheric(Coord3D cartesianCoords)
 {
   Spherical sphericCoords;
 
-  sphericCoords.r = sqrt(
+  sphericCoords.distance = sqrt(
       pow(cartesianCoords.x, 2) + pow(cartesianCoords.y, 2) + pow(cartesianCoords.z, 2));
 
-  sphericCoords.elevation = acos(cartesianCoords.z / sphericCoords.r);
+  sphericCoords.elevation = acos(cartesianCoords.z / sphericCoords.distance);
 
   sphericCoords.azimuth = atan2(cartesianCoords.y, cartesianCoords.x);
 
@@ -289,7 +304,7 @@ inline Spherical phased_cartesian_to_spheric(Coord3D cartesianCoords)
 {
   Spherical sphericCoords;
 
-  sphericCoords.r = sqrt(
+  sphericCoords.distance = sqrt(
       pow(cartesianCoords.x, 2) + pow(cartesianCoords.y, 2) + pow(cartesianCoords.z, 2));
 
   sphericCoords.elevation = atan2(
@@ -313,13 +328,54 @@ inline Coord3D phased_spheric_to_cartesian(Spherical sphericCoords)
   Coord3D cartesianCoords;
 
   cartesianCoords.x
-      = sphericCoords.r * cos(sphericCoords.elevation) * cos(sphericCoords.azimuth);
+      = sphericCoords.distance * cos(sphericCoords.elevation) * cos(sphericCoords.azimuth);
   cartesianCoords.y
-      = sphericCoords.r * cos(sphericCoords.elevation) * sin(sphericCoords.azimuth);
-  cartesianCoords.z = sphericCoords.r * sin(sphericCoords.elevation);
+      = sphericCoords.distance * cos(sphericCoords.elevation) * sin(sphericCoords.azimuth);
+  cartesianCoords.z = sphericCoords.distance * sin(sphericCoords.elevation);
 
   return cartesianCoords;
 }
 
+/**
+ * @brief Block versions of the conversions above: out[i] receives the
+ * conversion of in[i]. Return the number of points converted, the smaller of
+ * the two sizes.
+ */
+inline std::size_t
+spheric_to_cartesian(std::span<const Spherical> in, std::span<Coord3D> out)
+{
+  const std::size_t count = std::min(in.size(), out.size());
+  for(std::size_t i = 0; i < count; ++i)
+    out[i] = spheric_to_cartesian(in[i]);
+  return count;
+}
+
+inline std::size_t
+cartesian_to_spheric(std::span<const Coord3D> in, std::span<Spherical> out)
+{
+  const std::size_t count = std::min(in.size(), out.size());
+  for(std::size_t i = 0; i < count; ++i)
+    out[i] = cartesian_to_spheric(in[i]);
+  return count;
+}
+
+inline std::size_t
+phased_spheric_to_cartesian(std::span<const Spherical> in, std::span<Coord3D> out)
+{
+  const std::size_t count = std::min(in.size(), out.size());
+  for(std::size_t i = 0; i < count; ++i)
+    out[i] = phased_spheric_to_cartesian(in[i]);
+  return count;
+}
+
+inline std::size_t
+phased_cartesian_to_spheric(std::span<const Coord3D> in, std::span<Spherical> out)
+{
+  const std::size_t count = std::min(in.size(), out.size());
+  for(std::size_t i = 0; i < count; ++i)
+    out[i] = phased_cartesian_to_spheric(in[i]);
+  return count;
+}
+
 }
 }
\ No newline at end of file
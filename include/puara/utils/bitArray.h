@@ -0,0 +1,105 @@
+/**
+ * @file bitArray.h
+ * @brief Helpers for touch arrays packed one stripe per bit in 64-bit words.
+ * @see https://github.com/Puara/puara-gestures
+ * @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+ * @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+ */
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+namespace puara_gestures::utils
+{
+/**
+ * @brief Bit-packed binary arrays.
+ *
+ * Stripe `i` is bit `i % 64` of word `i / 64` (least significant bit first).
+ * Runs are located with count-trailing-zeros and ranges are counted with
+ * popcount, so a 120-stripe array is handled in two words instead of 120
+ * integer comparisons.
+ *
+ * Example:
+ * @code{.cpp}
+ * int touchArray[120] = {...};
+ * uint64_t touchBits[puara_gestures::utils::bitWordCount(120)];
+ * puara_gestures::utils::packBits(touchArray, 120, touchBits);
+ * int touched = puara_gestures::utils::countBits(touchBits, 0, 120);
+ * @endcode
+ */
+
+/**
+ * @brief Number of 64-bit words needed to hold `bits` bits.
+ */
+constexpr int bitWordCount(int bits)
+{
+  return (bits + 63) / 64;
+}
+
+/**
+ * @brief Packs an int array into words: bit `i` is set when `values[i] == 1`.
+ *
+ * @param values Array of `size` values.
+ * @param size Number of values.
+ * @param words Output, at least `bitWordCount(size)` words. Bits past `size`
+ *        in the last word are cleared.
+ */
+inline void packBits(const int* values, int size, uint64_t* words)
+{
+  for(int w = 0; w < bitWordCount(size); ++w)
+  {
+    const int first = w * 64;
+    const int count = size - first < 64 ? size - first : 64;
+    uint64_t word = 0;
+    for(int b = 0; b < count; ++b)
+      word |= uint64_t(values[first + b] == 1) << b;
+    words[w] = word;
+  }
+}
+
+/**
+ * @brief Number of set bits in the range [start, end).
+ */
+inline int countBits(const uint64_t* words, int start, int end)
+{
+  if(end <= start)
+    return 0;
+
+  const int first = start / 64;
+  const int last = (end - 1) / 64;
+  const uint64_t firstMask = ~uint64_t(0) << (start % 64);
+  const uint64_t lastMask = ~uint64_t(0) >> (63 - (end - 1) % 64);
+
+  if(first == last)
+    return std::popcount(words[first] & firstMask & lastMask);
+
+  int count = std::popcount(words[first] & firstMask);
+  for(int w = first + 1; w < last; ++w)
+    count += std::popcount(words[w]);
+  return count + std::popcount(words[last] & lastMask);
+}
+
+/**
+ * @brief Index of the first bit in [from, end) equal to `value`, or `end`
+ * when there is none.
+ */
+inline int findBit(const uint64_t* words, int from, int end, bool value)
+{
+  if(from >= end)
+    return end;
+
+  const uint64_t flip = value ? 0 : ~uint64_t(0);
+  int w = from / 64;
+  uint64_t bits = (words[w] ^ flip) & (~uint64_t(0) << (from % 64));
+  const int lastWord = (end - 1) / 64;
+  while(bits == 0)
+  {
+    if(++w > lastWord)
+      return end;
+    bits = words[w] ^ flip;
+  }
+  const int index = w * 64 + std::countr_zero(bits);
+  return index < end ? index : end;
+}
+}
@@ -0,0 +1,99 @@
+/**
+ * @file bitShift.h
+ * @brief Single-pass, in-place bit shifts of multi-word buffers.
+ * @see https://github.com/Puara/puara-gestures
+ * @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+ * @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+ */
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <span>
+
+namespace puara_gestures::utils
+{
+/**
+ * @brief Shift a buffer left by `shift` bits, in place.
+ *
+ * The buffer is one big-endian bit stream: `buffer[0]` holds the most
+ * significant bits, and bits shifted out of `buffer[i + 1]` enter at the bottom
+ * of `buffer[i]`, as in `bitShiftArrayL()`. Zeros enter at the end. Any shift
+ * amount takes a single pass over the buffer: whole words move by
+ * `shift / digits` and the remaining bits are spliced from two neighbours.
+ *
+ * Example:
+ * @code{.cpp}
+ * uint8_t raw[] = {0x12, 0x34, 0x56};
+ * puara_gestures::utils::bitShiftLeft<uint8_t>(raw, 4); // {0x23, 0x45, 0x60}
+ * @endcode
+ *
+ * @tparam T uint8_t, uint32_t, uint64_t or any other unsigned integer type.
+ * @param buffer Words to shift.
+ * @param shift Number of bits; shifts past the buffer length clear it.
+ */
+template <std::unsigned_integral T>
+void bitShiftLeft(std::span<T> buffer, std::size_t shift)
+{
+  constexpr std::size_t digits = std::numeric_limits<T>::digits;
+  const std::size_t size = buffer.size();
+  const std::size_t wordShift = shift / digits;
+  const unsigned bitShift = shift % digits;
+  if(wordShift >= size)
+  {
+    std::fill(buffer.begin(), buffer.end(), T(0));
+    return;
+  }
+
+  const std::size_t kept = size - wordShift;
+  if(bitShift == 0)
+  {
+    for(std::size_t i = 0; i < kept; ++i)
+      buffer[i] = buffer[i + wordShift];
+  }
+  else
+  {
+    for(std::size_t i = 0; i + 1 < kept; ++i)
+      buffer[i] = T(buffer[i + wordShift] << bitShift)
+                  | T(buffer[i + wordShift + 1] >> (digits - bitShift));
+    buffer[kept - 1] = T(buffer[size - 1] << bitShift);
+  }
+  std::fill(buffer.begin() + kept, buffer.end(), T(0));
+}
+
+/**
+ * @brief Shift a buffer right by `shift` bits, in place.
+ *
+ * The mirror of `bitShiftLeft()`: bits move from `buffer[i]` into
+ * `buffer[i + 1]`, and zeros enter at `buffer[0]`.
+ */
+template <std::unsigned_integral T>
+void bitShiftRight(std::span<T> buffer, std::size_t shift)
+{
+  constexpr std::size_t digits = std::numeric_limits<T>::digits;
+  const std::size_t size = buffer.size();
+  const std::size_t wordShift = shift / digits;
+  const unsigned bitShift = shift % digits;
+  if(wordShift >= size)
+  {
+    std::fill(buffer.begin(), buffer.end(), T(0));
+    return;
+  }
+
+  if(bitShift == 0)
+  {
+    for(std::size_t i = size; i-- > wordShift;)
+      buffer[i] = buffer[i - wordShift];
+  }
+  else
+  {
+    for(std::size_t i = size - 1; i > wordShift; --i)
+      buffer[i] = T(buffer[i - wordShift] >> bitShift)
+                  | T(buffer[i - wordShift - 1] << (digits - bitShift));
+    buffer[wordShift] = T(buffer[0] >> bitShift);
+  }
+  std::fill(buffer.begin(), buffer.begin() + wordShift, T(0));
+}
+}
@@ -1,6 +1,6 @@
 /**
 * @file blobDetector.h
-* @brief Detects contiguous runs of `1` values in a 1D binary array.
+* @brief Detects contiguous runs of `1` values in 1D binary arrays and connected regions in 2D grids.
 * @see https://github.com/Puara/puara-gestures
 * @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
 * @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
@@ -8,9 +8,218 @@
 */
 #pragma once
 
+#include <puara/utils/bitArray.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
 namespace puara_gestures
 {
 
+/**
+ * @brief A connected region found by `BlobDetector::detect2D()`.
+ *
+ * Coordinates are cell indices: `x` is the column and `y` the row.
+ */
+struct Blob2D
+{
+  /// Identifier that follows the blob from frame to frame.
+  int id = 0;
+  /// Number of touched cells.
+  int area = 0;
+  /// Mean position of the touched cells.
+  float centroidX = 0, centroidY = 0;
+  /// Inclusive bounding box.
+  int minX = 0, minY = 0, maxX = 0, maxY = 0;
+};
+
+namespace detail
+{
+// Scratch storage for detect2D: every horizontal run of the grid, and a
+// union-find forest over the runs. A row of n cells holds at most (n + 1) / 2 runs.
+template <int maxGridSide>
+struct BlobLabeling
+{
+  static_assert(maxGridSide <= 256, "run indices are stored on 16 bits");
+  static constexpr int maxRuns = maxGridSide * ((maxGridSide + 1) / 2);
+  int16_t row[maxRuns];
+  int16_t start[maxRuns];
+  int16_t end[maxRuns];
+  int16_t parent[maxRuns];
+  int16_t slot[maxRuns];
+};
+
+template <>
+struct BlobLabeling<0>
+{
+};
+
+/**
+ * @brief Greedy nearest-pair assignment between two small sets of points.
+ *
+ * Candidate pairs closer than `maxDistance` are taken closest first, each
+ * point being used at most once; ties go to the lowest current, then previous,
+ * index. Each current point keeps only its nearest free previous point, so
+ * the scratch storage is O(k) for k points per set. The first pass costs k^2
+ * distance evaluations and each match O(k), plus O(k) for every current point
+ * whose candidate it takes: O(k^2) for points that are not all crowded around
+ * the same few candidates, O(k^3) at worst.
+ *
+ * @param currentCount Number of points in the current set (at most maxCount).
+ * @param previousCount Number of points in the previous set (at most maxCount).
+ * @param distanceSq `distanceSq(c, p)` gives the squared distance between
+ *        current point `c` and previous point `p`.
+ * @param match Receives, for each current point, the index of its previous
+ *        point, or -1.
+ */
+template <int maxCount, typename DistanceSq>
+void matchNearest(
+    int currentCount, int previousCount, float maxDistance, DistanceSq distanceSq,
+    int* match)
+{
+  const float maxDistanceSq = maxDistance * maxDistance;
+  bool previousTaken[maxCount]{};
+  int nearest[maxCount]{};
+  float nearestSq[maxCount]{};
+
+  // Nearest free previous point of current point c within maxDistance, or -1.
+  auto findNearest = [&](int c) {
+    nearest[c] = -1;
+    for(int p = 0; p < previousCount; ++p)
+    {
+      if(previousTaken[p])
+        continue;
+      const float d = distanceSq(c, p);
+      if(d <= maxDistanceSq && (nearest[c] < 0 || d < nearestSq[c]))
+      {
+        nearest[c] = p;
+        nearestSq[c] = d;
+      }
+    }
+  };
+
+  for(int c = 0; c < currentCount; ++c)
+  {
+    match[c] = -1;
+    findNearest(c);
+  }
+
+  for(;;)
+  {
+    // The closest free pair is the closest of the candidates.
+    int best = -1;
+    for(int c = 0; c < currentCount; ++c)
+      if(match[c] < 0 && nearest[c] >= 0 && (best < 0 || nearestSq[c] < nearestSq[best]))
+        best = c;
+    if(best < 0)
+      return;
+
+    const int taken = nearest[best];
+    match[best] = taken;
+    previousTaken[taken] = true;
+    for(int c = 0; c < currentCount; ++c)
+      if(match[c] < 0 && nearest[c] == taken)
+        findNearest(c);
+  }
+}
+
+/**
+ * @brief `matchNearest()` for points on a line, both sets sorted by position.
+ *
+ * Gives the same pairs as `matchNearest()` with the distance
+ * `(current[c] - previous[p])^2`, as long as positions differ by exactly
+ * representable amounts (e.g. the half-stripe centers of `detect1D()`). On a
+ * line, the closest free pair is always adjacent in the merged order of the
+ * free points, so the sweep merges the two sets, keeps the adjacent pairs of
+ * different sets in a heap, and relinks the neighbours of every matched pair:
+ * O(k log k) for k points per set, without allocating.
+ *
+ * @param current Positions of the current points, strictly increasing.
+ * @param previous Positions of the previous points, strictly increasing.
+ * @param match Receives, for each current point, the index of its previous
+ *        point, or -1.
+ */
+template <int maxCount>
+void matchNearestSorted(
+    const float* current, int currentCount, const float* previous, int previousCount,
+    float maxDistance, int* match)
+{
+  static_assert(maxCount <= 0x10000, "point indices are packed on 16 bits");
+  const float maxDistanceSq = maxDistance * maxDistance;
+
+  // Merged list of both sets, in position order.
+  int currentNode[maxCount];
+  int previousNode[maxCount];
+  int point[2 * maxCount];
+  bool isCurrent[2 * maxCount];
+  bool taken[2 * maxCount];
+  int before[2 * maxCount];
+  int after[2 * maxCount];
+  int nodes = 0;
+  for(int c = 0, p = 0; c < currentCount || p < previousCount; ++nodes)
+  {
+    isCurrent[nodes] = p == previousCount || (c < currentCount && current[c] <= previous[p]);
+    if(isCurrent[nodes])
+      currentNode[point[nodes] = c++] = nodes;
+    else
+      previousNode[point[nodes] = p++] = nodes;
+    taken[nodes] = false;
+    before[nodes] = nodes - 1;
+    after[nodes] = nodes + 1;
+  }
+
+  // Adjacent pairs of different sets, as (distanceSq, c, p) packed into one
+  // integer that orders them closest first, then by lowest current and
+  // previous index (the bits of a non-negative float order like its value).
+  // Every match adds at most one pair to the initial adjacent ones.
+  uint64_t heap[3 * maxCount];
+  int heapSize = 0;
+  const auto push = [&](int left, int right) {
+    if(left < 0 || right >= nodes || isCurrent[left] == isCurrent[right])
+      return;
+    const int c = point[isCurrent[left] ? left : right];
+    const int p = point[isCurrent[left] ? right : left];
+    const float d = current[c] - previous[p];
+    if(d * d > maxDistanceSq)
+      return;
+    heap[heapSize++] = uint64_t(std::bit_cast<uint32_t>(d * d)) << 32 | uint32_t(c) << 16 | uint32_t(p);
+    std::push_heap(heap, heap + heapSize, std::greater<>{});
+  };
+
+  for(int c = 0; c < currentCount; ++c)
+    match[c] = -1;
+  for(int n = 0; n + 1 < nodes; ++n)
+    push(n, n + 1);
+
+  while(heapSize > 0)
+  {
+    std::pop_heap(heap, heap + heapSize, std::greater<>{});
+    const uint64_t pair = heap[--heapSize];
+    const int c = int(pair >> 16 & 0xffff);
+    const int p = int(pair & 0xffff);
+    // Points are only ever removed, so a pair whose points are both free is
+    // still adjacent.
+    if(taken[currentNode[c]] || taken[previousNode[p]])
+      continue;
+
+    match[c] = p;
+    const int first = std::min(currentNode[c], previousNode[p]);
+    const int second = std::max(currentNode[c], previousNode[p]);
+    taken[first] = taken[second] = true;
+    const int left = before[first];
+    const int right = after[second];
+    if(left >= 0)
+      after[left] = right;
+    if(right < nodes)
+      before[right] = left;
+    push(left, right);
+  }
+}
+}
+
 /**
  * @class BlobDetector
  * @brief Detects contiguous runs of `1` values in a 1D binary array.
@@ -33,9 +242,30 @@ namespace puara_gestures
  * // detector.blobSize[1] == 3
  * @endcode
  *
+ * `detect1D()` also accepts the array packed one stripe per bit (see
+ * `utils::packBits()`), which finds the same blobs with word-level scans.
+ *
+ * `detect2D()` finds 8-connected regions in a bit-packed grid of up to
+ * `maxGridSide` x `maxGridSide` cells and reports them in `blobs`. Each blob
+ * keeps its `id` from one frame to the next while it moves by less than
+ * `maxTrackDistance` cells, so per-finger state (e.g. a `BrushRubDetector`)
+ * can be keyed on it:
+ * @code{.cpp}
+ * puara_gestures::BlobDetector<4, 16> detector;
+ * uint64_t grid[16]; // one word per 16-cell row
+ * for(int row = 0; row < 16; ++row)
+ *   puara_gestures::utils::packBits(touchMatrix[row], 16, &grid[row]);
+ * detector.detect2D(grid, 16, 16);
+ * for(int i = 0; i < detector.blobCount; ++i)
+ *   use(detector.blobs[i].id, detector.blobs[i].centroidX, detector.blobs[i].centroidY);
+ * @endcode
+ *
  * @tparam maxNumBlobs Maximum number of blobs the detector will store.
+ * @tparam maxGridSide Largest grid side accepted by `detect2D()`. The labeling
+ *         scratch space grows with its square, so the default of 0 leaves it
+ *         out for 1D-only use.
  */
-template <int maxNumBlobs>
+template <int maxNumBlobs, int maxGridSide = 0>
 class BlobDetector
 {
 public:
@@ -70,6 +300,28 @@ public:
    */
   int blobCount{};
 
+  /**
+   * @brief Blobs found by the last detect2D call, in raster order of their
+   * top-left run.
+   */
+  Blob2D blobs[maxNumBlobs]{};
+
+  /**
+   * @brief Blobs from the previous detect2D call.
+   */
+  Blob2D prevBlobs[maxNumBlobs]{};
+
+  /**
+   * @brief Number of blobs in `prevBlobs`.
+   */
+  int prevBlobCount{};
+
+  /**
+   * @brief Largest centroid displacement, in cells, for which a blob keeps
+   * its id between two detect2D calls.
+   */
+  float maxTrackDistance = 3.0f;
+
   /**
    * @brief Detect contiguous regions (blobs) of `1`s in a 1D binary array.
    *
@@ -83,15 +335,7 @@ public:
    */
   void detect1D(const int* const touchArray, const int touchArraySize)
   {
-    blobCount = 0;
-    for(int i = 0; i < maxNumBlobs; i++)
-    {
-      //cache the last blobStartPos before clearing it
-      prevBlobStartPos[i] = blobStartPos[i];
-      blobStartPos[i] = 0;
-      blobSize[i] = 0;
-      blobCenter[i] = 0;
-    }
+    clearBlobs();
 
     for(int stripe = 0; stripe < touchArraySize;)
     {
@@ -118,5 +362,188 @@ public:
         break;
     }
   }
+
+  /**
+   * @brief Detect blobs in a bit-packed touch array.
+   *
+   * Gives the same results as the int overload on the unpacked array.
+   *
+   * @param touchBits Touch array packed with `utils::packBits()`: bit `i` is
+   *        set when stripe `i` is touched.
+   * @param touchArraySize Number of stripes in the touch array.
+   */
+  void detect1D(const uint64_t* const touchBits, const int touchArraySize)
+  {
+    clearBlobs();
+
+    for(int stripe = utils::findBit(touchBits, 0, touchArraySize, true);
+        stripe < touchArraySize;)
+    {
+      const int end = utils::findBit(touchBits, stripe, touchArraySize, false);
+      const int sizeCounter = end - stripe;
+
+      blobStartPos[blobCount] = stripe;
+      blobSize[blobCount] = sizeCounter;
+      blobCenter[blobCount] = stripe + (sizeCounter - 1.0) / 2.0;
+
+      if(++blobCount >= maxNumBlobs)
+        break;
+      stripe = utils::findBit(touchBits, end, touchArraySize, true);
+    }
+  }
+
+  /**
+   * @brief Detect 8-connected regions of touched cells in a 2D grid.
+   *
+   * Single pass of run-length connected-component labeling: each row is split
+   * into runs with bit scans, runs that touch a run of the previous row
+   * (including diagonally) are merged with union-find, and the area, centroid
+   * and bounding box of every region are then accumulated from its runs. No
+   * memory is allocated.
+   *
+   * Blob ids are matched to the previous frame greedily, closest pair first.
+   * Blobs without a match within `maxTrackDistance` get a new id.
+   *
+   * @param gridBits Row-major grid: row `r` is `utils::bitWordCount(cols)`
+   *        words starting at `gridBits + r * utils::bitWordCount(cols)`, packed
+   *        as by `utils::packBits()`.
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   * @return false, with no blobs, when the grid is larger than `maxGridSide`.
+   * @note Regions beyond `maxNumBlobs` are ignored.
+   */
+  bool detect2D(const uint64_t* const gridBits, const int rows, const int cols)
+  {
+    static_assert(maxGridSide > 0, "detect2D needs the maxGridSide template parameter");
+
+    std::copy(std::begin(blobs), std::end(blobs), std::begin(prevBlobs));
+    prevBlobCount = blobCount;
+    blobCount = 0;
+    std::fill(std::begin(blobs), std::end(blobs), Blob2D{});
+    if(rows > maxGridSide || cols > maxGridSide || rows < 0 || cols < 0)
+      return false;
+
+    auto& runs = labeling;
+    const int rowWords = utils::bitWordCount(cols);
+    int runCount = 0;
+    int prevBegin = 0;
+    int prevEnd = 0;
+    for(int r = 0; r < rows; ++r)
+    {
+      const uint64_t* rowBits = gridBits + r * rowWords;
+      const int rowBegin = runCount;
+      int prev = prevBegin;
+      for(int start = utils::findBit(rowBits, 0, cols, true); start < cols;
+          start = utils::findBit(rowBits, runs.end[runCount - 1], cols, true))
+      {
+        const int end = utils::findBit(rowBits, start, cols, false);
+        const int run = runCount++;
+        runs.row[run] = r;
+        runs.start[run] = start;
+        runs.end[run] = end;
+        runs.parent[run] = run;
+
+        // Previous-row runs ending left of this run's diagonal neighbour cannot
+        // touch this or any later run of the row.
+        while(prev < prevEnd && runs.end[prev] < start)
+          ++prev;
+        for(int p = prev; p < prevEnd && runs.start[p] <= end; ++p)
+          unite(run, p);
+      }
+      prevBegin = rowBegin;
+      prevEnd = runCount;
+    }
+
+    // Runs are numbered in raster order and every root is the smallest run of
+    // its region, so a region gets its slot when its root is reached.
+    for(int run = 0; run < runCount; ++run)
+    {
+      const int root = find(run);
+      if(root == run)
+        runs.slot[run] = blobCount < maxNumBlobs ? blobCount++ : -1;
+      const int slot = runs.slot[root];
+      if(slot < 0)
+        continue;
+
+      Blob2D& blob = blobs[slot];
+      const int length = runs.end[run] - runs.start[run];
+      const int lastX = runs.end[run] - 1;
+      if(blob.area == 0)
+      {
+        blob.minX = runs.start[run];
+        blob.maxX = lastX;
+        blob.minY = runs.row[run];
+      }
+      blob.minX = std::min<int>(blob.minX, runs.start[run]);
+      blob.maxX = std::max(blob.maxX, lastX);
+      blob.maxY = runs.row[run];
+      blob.area += length;
+      // Sums of coordinates, divided by the area below.
+      blob.centroidX += 0.5f * length * (runs.start[run] + lastX);
+      blob.centroidY += float(length) * runs.row[run];
+    }
+    for(int i = 0; i < blobCount; ++i)
+    {
+      blobs[i].centroidX /= blobs[i].area;
+      blobs[i].centroidY /= blobs[i].area;
+    }
+
+    assignIds();
+    return true;
+  }
+
+private:
+  [[no_unique_address]] detail::BlobLabeling<maxGridSide> labeling;
+  int nextBlobId = 1;
+
+  int find(int run)
+  {
+    auto& parent = labeling.parent;
+    while(parent[run] != run)
+    {
+      parent[run] = parent[parent[run]];
+      run = parent[run];
+    }
+    return run;
+  }
+
+  // Union keeping the smaller run as root.
+  void unite(int a, int b)
+  {
+    a = find(a);
+    b = find(b);
+    if(a < b)
+      labeling.parent[b] = a;
+    else if(b < a)
+      labeling.parent[a] = b;
+  }
+
+  // Greedy nearest-pair matching of the new blobs to the previous frame.
+  void assignIds()
+  {
+    const auto distanceSq = [this](int c, int p) {
+      const float dx = blobs[c].centroidX - prevBlobs[p].centroidX;
+      const float dy = blobs[c].centroidY - prevBlobs[p].centroidY;
+      return dx * dx + dy * dy;
+    };
+    int match[maxNumBlobs];
+    detail::matchNearest<maxNumBlobs>(
+        blobCount, prevBlobCount, maxTrackDistance, distanceSq, match);
+    for(int c = 0; c < blobCount; ++c)
+      blobs[c].id = match[c] >= 0 ? prevBlobs[match[c]].id : nextBlobId++;
+  }
+
+  void clearBlobs()
+  {
+    blobCount = 0;
+    for(int i = 0; i < maxNumBlobs; i++)
+    {
+      //cache the last blobStartPos before clearing it
+      prevBlobStartPos[i] = blobStartPos[i];
+      blobStartPos[i] = 0;
+      blobSize[i] = 0;
+      blobCenter[i] = 0;
+    }
+  }
 };
 }
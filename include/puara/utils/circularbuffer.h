@@ -1,6 +1,9 @@
 /**
 * @file circularbuffer.h
-* @brief Simple circular buffer implementation.
+* @brief Fixed-capacity circular buffer with inline storage.
+* @details
+* The runtime-sized, Boost-backed `CircularBuffer<T>` is declared in
+* circularbufferRuntime.h, so this header has no Boost dependency.
 * @see https://github.com/Puara/puara-gestures
 * @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
 * @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
@@ -9,81 +12,136 @@
 
 #pragma once
 
-#include <boost/circular_buffer.hpp>
 #include <puara/structs.h>
 
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <span>
+
 namespace puara_gestures::utils
 {
 /**
  * @class CircularBuffer
- * @brief Simple circular buffer wrapper for fixed-size element storage.
+ * @brief Fixed-capacity circular buffer with inline storage.
  *
  * @details
- * CircularBuffer stores a fixed number of values and automatically drops the
- * oldest element when new values are added beyond capacity. It is intended for
- * lightweight buffering on platforms where the Boost circular buffer is used
- * as the underlying container.
+ * When the capacity `N` is known at compile time, CircularBuffer stores its
+ * elements in an inline `std::array` and never touches the heap. The storage
+ * is rounded up to the next power of two so that wrapping is a single mask
+ * instead of a compare-and-branch; only the `N` most recent elements are kept.
+ *
+ * Element 0 is always the most recently added value, like the runtime-sized
+ * `CircularBuffer<T>` of circularbufferRuntime.h. `segments()` exposes the stored values as at
+ * most two contiguous spans, oldest first, for tight loops over the history.
  *
  * Example:
  * @code{.cpp}
- *   // default stores doubles
- *   puara_gestures::utils::CircularBuffer<> buffer;
- *   buffer.add(1.0);
- *   buffer.add(2.0);
+ *   puara_gestures::utils::CircularBuffer<double, 4> buffer;
+ *   for (double v : {1.0, 2.0, 3.0, 4.0, 5.0})
+ *     buffer.add(v);
  *
- *   // templated for other types
- *   puara_gestures::utils::CircularBuffer<int> intBuffer(4);
- *   intBuffer.add(10);
- *   intBuffer.add(20);
+ *   // buffer[0] == 5.0, buffer[3] == 2.0, buffer.size() == 4
+ *   double sum = 0.0;
+ *   for (auto segment : buffer.segments())
+ *     for (double v : segment)
+ *       sum += v; // visits 2, 3, 4, 5
  * @endcode
  *
  * @tparam T Value type stored in the buffer.
+ * @tparam N Number of elements retained. `0` selects the runtime-sized,
+ *         Boost-backed buffer of circularbufferRuntime.h.
  */
-template <typename T = double>
+template <typename T = double, std::size_t N = 0>
 class CircularBuffer
 {
 public:
   /**
-   * @brief Requested capacity for the circular buffer.
-   * */
-  std::size_t size = 10;
+   * @brief Number of slots in the inline storage (`N` rounded up to a power of two).
+   */
+  static constexpr std::size_t storage_size = std::bit_ceil(N);
 
   /**
-   * @brief Underlying storage for circular buffer elements.
-   * */
-  boost::circular_buffer<T> buffer = boost::circular_buffer<T>(size);
+   * @brief Add an element, dropping the oldest one when the buffer is full.
+   *
+   * @param element The value to push into the buffer.
+   * @return T The same element that was added.
+   */
+  T add(const T& element)
+  {
+    storage[head & mask] = element;
+    ++head;
+    if(count < N)
+      ++count;
+    return element;
+  }
 
-  CircularBuffer(const CircularBuffer&) = default;
-  CircularBuffer(CircularBuffer&&) noexcept = default;
-  CircularBuffer& operator=(const CircularBuffer&) = default;
-  CircularBuffer& operator=(CircularBuffer&&) noexcept = default;
+  /**
+   * @brief Access a stored element, 0 being the most recent one.
+   */
+  const T& operator[](std::size_t index) const
+  {
+    return storage[(head - 1 - index) & mask];
+  }
 
   /**
-   * @brief Construct a circular buffer with the default capacity.
+   * @brief Most recently added element. The buffer must not be empty.
    */
-  CircularBuffer() : buffer(size) {}
+  const T& front() const { return (*this)[0]; }
 
   /**
-   * @brief Construct a circular buffer with a custom capacity.
-   *
-   * @param capacity Number of elements to retain in the buffer.
+   * @brief Oldest retained element. The buffer must not be empty.
    */
-  explicit CircularBuffer(std::size_t capacity) : size(capacity), buffer(capacity) {}
+  const T& back() const { return (*this)[count - 1]; }
 
   /**
-   * @brief Add an element to the circular buffer.
+   * @brief Number of elements currently stored.
+   */
+  std::size_t size() const { return count; }
+
+  /**
+   * @brief Maximum number of elements retained.
+   */
+  static constexpr std::size_t capacity() { return N; }
+
+  bool empty() const { return count == 0; }
+
+  bool full() const { return count == N; }
+
+  /**
+   * @brief Forget all stored elements.
+   */
+  void clear()
+  {
+    head = 0;
+    count = 0;
+  }
+
+  /**
+   * @brief Contiguous views over the stored elements, oldest first.
    *
-   * @param element The value to push into the buffer.
-   * @return T The same element that was added.
+   * The second span is empty unless the stored range wraps around the end
+   * of the storage.
    */
-  T add(const T& element)
+  std::array<std::span<const T>, 2> segments() const
   {
-    if (buffer.capacity() != size){
-      buffer.set_capacity(size);
-    }
-    buffer.push_front(element);
-    return element;
+    const std::size_t start = (head - count) & mask;
+    const std::size_t firstLength
+        = (start + count <= storage_size) ? count : storage_size - start;
+    return {
+        std::span<const T>(storage.data() + start, firstLength),
+        std::span<const T>(storage.data(), count - firstLength)};
   }
+
+private:
+  static_assert(
+      N > 0, "CircularBuffer<T> (runtime capacity) is declared in "
+             "<puara/utils/circularbufferRuntime.h>");
+  static constexpr std::size_t mask = storage_size - 1;
+
+  std::array<T, storage_size> storage{};
+  std::size_t head = 0;
+  std::size_t count = 0;
 };
 
 }
@@ -0,0 +1,92 @@
+/**
+* @file circularbufferRuntime.h
+* @brief Runtime-sized circular buffer backed by `boost::circular_buffer`.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+* @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+* @author Edu Meneses (2024) - https://www.edumeneses.com
+*/
+
+#pragma once
+
+#include <boost/circular_buffer.hpp>
+#include <puara/utils/circularbuffer.h>
+
+#include <cstddef>
+
+namespace puara_gestures::utils
+{
+/**
+ * @class CircularBuffer
+ * @brief Simple circular buffer wrapper for fixed-size element storage.
+ *
+ * @details
+ * CircularBuffer stores a fixed number of values and automatically drops the
+ * oldest element when new values are added beyond capacity. It is intended for
+ * lightweight buffering on platforms where the Boost circular buffer is used
+ * as the underlying container. The capacity can be changed at runtime through
+ * `size`; prefer `CircularBuffer<T, N>` when it is known at compile time.
+ *
+ * Example:
+ * @code{.cpp}
+ *   // default stores doubles
+ *   puara_gestures::utils::CircularBuffer<> buffer;
+ *   buffer.add(1.0);
+ *   buffer.add(2.0);
+ *
+ *   // templated for other types
+ *   puara_gestures::utils::CircularBuffer<int> intBuffer(4);
+ *   intBuffer.add(10);
+ *   intBuffer.add(20);
+ * @endcode
+ *
+ * @tparam T Value type stored in the buffer.
+ */
+template <typename T>
+class CircularBuffer<T, 0>
+{
+public:
+  /**
+   * @brief Requested capacity for the circular buffer.
+   * */
+  std::size_t size = 10;
+
+  /**
+   * @brief Underlying storage for circular buffer elements.
+   * */
+  boost::circular_buffer<T> buffer = boost::circular_buffer<T>(size);
+
+  CircularBuffer(const CircularBuffer&) = default;
+  CircularBuffer(CircularBuffer&&) noexcept = default;
+  CircularBuffer& operator=(const CircularBuffer&) = default;
+  CircularBuffer& operator=(CircularBuffer&&) noexcept = default;
+
+  /**
+   * @brief Construct a circular buffer with the default capacity.
+   */
+  CircularBuffer() : buffer(size) {}
+
+  /**
+   * @brief Construct a circular buffer with a custom capacity.
+   *
+   * @param capacity Number of elements to retain in the buffer.
+   */
+  explicit CircularBuffer(std::size_t capacity) : size(capacity), buffer(capacity) {}
+
+  /**
+   * @brief Add an element to the circular buffer.
+   *
+   * @param element The value to push into the buffer.
+   * @return T The same element that was added.
+   */
+  T add(const T& element)
+  {
+    if (buffer.capacity() != size){
+      buffer.set_capacity(size);
+    }
+    buffer.push_front(element);
+    return element;
+  }
+};
+
+}
@@ -0,0 +1,246 @@
+/**
+* @file fastmath.h
+* @brief Polynomial and Newton approximations of rsqrt, atan2 and asin, and the
+* math policies that select them in the orientation code.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+* @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+*/
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @namespace puara_gestures::fastmath
+ * @brief Cheaper replacements for the libm calls of the per-sample paths.
+ *
+ * @details
+ * The quaternion filters and `Tilt_RollT` take a math policy as a template
+ * parameter: `StdMath` (the default) calls the standard library, `FastMath`
+ * replaces `atan2` and `asin` by the functions below, and
+ * `FastMathNoHardwareSqrt` also replaces `1 / sqrt` by `rsqrt()`. The
+ * functions are branch-light, use no tables, and cost a handful of
+ * multiply-adds.
+ *
+ * Maximum errors over the whole domain, measured by the `[fastmath]`
+ * accuracy sweep in `tests/test_utils.cpp`:
+ *
+ * | function      | float            | double           |
+ * |---------------|------------------|------------------|
+ * | `rsqrt(x)`    | 2e-7 (relative)  | 5e-16 (relative) |
+ * | `atan(x)`     | 4e-7 rad         | 1e-9 rad         |
+ * | `atan2(y, x)` | 6e-7 rad         | 1e-9 rad         |
+ * | `asin(x)`     | 1e-6 rad         | 3e-10 rad        |
+ *
+ * That is below 1e-4 degrees in float, far below the noise of any IMU.
+ *
+ * `atan2` and `asin` are two to six times faster than libm on a desktop
+ * x86-64 CPU (`BM_MathAtan2`, `BM_MathAsin`), so `FastMath` speeds up the
+ * Euler angle getters and `Tilt_RollT`. `rsqrt` is not faster there: the
+ * hardware square root and divide beat three Newton steps (`BM_MathRsqrt`),
+ * which is why `FastMath` keeps `1 / std::sqrt`, and the filters' updates,
+ * which only normalize, cost the same with `StdMath` and `FastMath`
+ * (`BM_ReplayFilter`). `FastMathNoHardwareSqrt` is for FPUs without a square
+ * root or a divide instruction, such as the ESP32's, where the PlatformIO
+ * runner times it against the other policies.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::MadgwickQuaternionFilterT<float, puara_gestures::fastmath::FastMath> filter;
+ * puara_gestures::Tilt_RollT<puara_gestures::fastmath::FastMath> tiltRoll;
+ * float angle = puara_gestures::fastmath::atan2(y, x);
+ * @endcode
+ */
+namespace puara_gestures::fastmath
+{
+namespace detail
+{
+template <typename T, std::size_t N>
+constexpr T horner(const T (&coefficients)[N], T x)
+{
+  T result = coefficients[N - 1];
+  for(std::size_t i = N - 1; i-- > 0;)
+    result = result * x + coefficients[i];
+  return result;
+}
+
+template <typename T>
+inline constexpr T halfPi = T(1.5707963267948966);
+
+template <typename T>
+inline constexpr T pi = T(3.141592653589793);
+
+// Minimax fits, atan(x) / x in powers of x^2 on [0, 1], and
+// (pi/2 - asin(x)) / sqrt(1 - x) in powers of x on [0, 1].
+template <typename T>
+struct Coefficients;
+
+template <>
+struct Coefficients<float>
+{
+  static constexpr float atan[] = {
+      0.99999611f,  -0.33317368f, 0.19807817f,  -0.13233345f,
+      0.079623696f, -0.033604229f, 0.0068117932f};
+  static constexpr float asin[] = {
+      1.5707957f,    -0.21454281f,  0.088171028f,
+      -0.045927145f, 0.020619951f, -0.0049111247f};
+};
+
+template <>
+struct Coefficients<double>
+{
+  static constexpr double atan[] = {
+      0.99999998094092024,   -0.33333181961568142,  0.19996458172036974,
+      -0.14247359704439155,  0.10878498457692515,   -0.082147997156808109,
+      0.055041526508670183,  -0.028501111126510582, 0.0095716767952666003,
+      -0.0015100630871626305};
+  static constexpr double asin[] = {
+      1.5707963265370333,    -0.21460177497682911,  0.089046225538328819,
+      -0.050756738667430731, 0.033403421099153771,  -0.023119262195781993,
+      0.015074426344447006,  -0.007970771396405783, 0.0028158422650976403,
+      -0.00047413758389461687};
+};
+}
+
+/**
+ * @brief 1 / sqrt(x), from a bit-level first guess refined by Newton steps
+ * (three in float, four in double).
+ * @param x Positive, finite value.
+ */
+template <typename T>
+T rsqrt(T x)
+{
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>);
+  const T half = T(0.5) * x;
+  T y;
+  int steps;
+  if constexpr(std::is_same_v<T, float>)
+  {
+    y = std::bit_cast<float>(0x5f375a86u - (std::bit_cast<uint32_t>(x) >> 1));
+    steps = 3;
+  }
+  else
+  {
+    y = std::bit_cast<double>(0x5fe6eb50c7b537a9ull - (std::bit_cast<uint64_t>(x) >> 1));
+    steps = 4;
+  }
+  for(int i = 0; i < steps; ++i)
+    y = y * (T(1.5) - half * y * y);
+  return y;
+}
+
+/**
+ * @brief Arc tangent, in radians.
+ */
+template <typename T>
+T atan(T x)
+{
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>);
+  const T ax = std::abs(x);
+  // atan(x) = pi/2 - atan(1/x) keeps the polynomial on [0, 1].
+  const bool inverted = ax > T(1);
+  const T r = inverted ? T(1) / ax : ax;
+  T angle = r * detail::horner(detail::Coefficients<T>::atan, r * r);
+  if(inverted)
+    angle = detail::halfPi<T> - angle;
+  return x < T(0) ? -angle : angle;
+}
+
+/**
+ * @brief Angle of the vector (x, y), in radians in [-pi, pi]; 0 for (0, 0).
+ */
+template <typename T>
+T atan2(T y, T x)
+{
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>);
+  const T ax = std::abs(x);
+  const T ay = std::abs(y);
+  const T largest = ax > ay ? ax : ay;
+  if(largest == T(0))
+    return T(0);
+  // One division, for the ratio of the smaller to the larger component.
+  const T r = (ax > ay ? ay : ax) / largest;
+  T angle = r * detail::horner(detail::Coefficients<T>::atan, r * r);
+  if(ay > ax)
+    angle = detail::halfPi<T> - angle;
+  if(x < T(0))
+    angle = detail::pi<T> - angle;
+  return y < T(0) ? -angle : angle;
+}
+
+/**
+ * @brief Arc sine, in radians; `x` is clamped to [-1, 1].
+ */
+template <typename T>
+T asin(T x)
+{
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>);
+  T ax = std::abs(x);
+  if(ax > T(1))
+    ax = T(1);
+  const T angle
+      = detail::halfPi<T> - std::sqrt(T(1) - ax) * detail::horner(detail::Coefficients<T>::asin, ax);
+  return x < T(0) ? -angle : angle;
+}
+
+/**
+ * @brief Math policy calling the standard library. The default everywhere.
+ */
+struct StdMath
+{
+  template <typename T>
+  static T rsqrt(T x)
+  {
+    return T(1) / std::sqrt(x);
+  }
+
+  template <typename T>
+  static T atan2(T y, T x)
+  {
+    return std::atan2(y, x);
+  }
+
+  template <typename T>
+  static T asin(T x)
+  {
+    return std::asin(x < T(-1) ? T(-1) : (x > T(1) ? T(1) : x));
+  }
+};
+
+/**
+ * @brief Math policy with the approximations of `atan2` and `asin`, and the
+ * standard library's `1 / sqrt`, which is faster wherever the FPU has a
+ * square root.
+ */
+struct FastMath : StdMath
+{
+  template <typename T>
+  static T atan2(T y, T x)
+  {
+    return fastmath::atan2(y, x);
+  }
+
+  template <typename T>
+  static T asin(T x)
+  {
+    return fastmath::asin(x);
+  }
+};
+
+/**
+ * @brief `FastMath` with `rsqrt()` as well, for FPUs without a square root or
+ * a divide instruction.
+ */
+struct FastMathNoHardwareSqrt : FastMath
+{
+  template <typename T>
+  static T rsqrt(T x)
+  {
+    return fastmath::rsqrt(x);
+  }
+};
+}
@@ -0,0 +1,718 @@
+/**
+* @file imuRecording.h
+* @brief Versioned binary format for recorded IMU sessions, with quantized
+* encodings, a memory-mapped reader and streaming reader/writer.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+* @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+*/
+#pragma once
+
+#include <puara/structs.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PUARA_GESTURES_HAS_MMAP 1
+#endif
+
+namespace puara_gestures::utils
+{
+/**
+ * @brief One recorded IMU reading and its time.
+ */
+struct ImuSample
+{
+  uint64_t timestampMicros = 0;
+  Imu9Axis imu;
+};
+
+/**
+ * @brief How the nine axes of a record are stored.
+ */
+enum class ImuEncoding : uint16_t
+{
+  Float32 = 0, ///< `ImuRecord`, 48 bytes.
+  Float16 = 1, ///< `ImuRecordHalf`, 32 bytes: IEEE half precision of `value / scale`.
+  Int16 = 2    ///< `ImuRecordInt16`, 32 bytes: `value / scale` rounded to an integer.
+};
+
+/**
+ * @brief File header of the binary IMU recording format.
+ *
+ * A recording is this header followed by fixed-size records, in the host
+ * byte order (little-endian on every supported host). The records start
+ * `headerSize` bytes into the file, a multiple of 8, so a mapped file can be
+ * viewed as an array of records.
+ *
+ * Version 1 files have a 16-byte header (magic, `uint32_t` version, record
+ * size) and `ImuRecord`s; they are read as `ImuEncoding::Float32`. Version 2
+ * adds the encoding and the scale factors of the quantized encodings.
+ */
+struct ImuRecordingHeader
+{
+  char magic[8] = {'P', 'U', 'A', 'R', 'A', 'I', 'M', 'U'};
+  uint16_t version = 2;
+  ImuEncoding encoding = ImuEncoding::Float32;
+  uint32_t recordSize = 48;
+  uint32_t headerSize = 64;
+
+  /**
+   * @brief Scale factors of the quantized encodings: a stored value `q`
+   * reads as `q * scale`. Unused by `ImuEncoding::Float32`.
+   */
+  float acclScale = 1.0f;
+  float gyroScale = 1.0f;
+  float magnScale = 1.0f;
+
+  uint8_t reserved[32]{};
+
+  /**
+   * @brief Header for single-precision records.
+   */
+  static ImuRecordingHeader float32() { return {}; }
+
+  /**
+   * @brief Header for half-precision records, with optional scale factors.
+   */
+  static ImuRecordingHeader float16(float accl = 1.0f, float gyro = 1.0f, float magn = 1.0f)
+  {
+    ImuRecordingHeader header;
+    header.encoding = ImuEncoding::Float16;
+    header.recordSize = 32;
+    header.acclScale = accl;
+    header.gyroScale = gyro;
+    header.magnScale = magn;
+    return header;
+  }
+
+  /**
+   * @brief Header for 16-bit integer records covering `[-range, range]` on
+   * each sensor. Values outside the range are clamped.
+   *
+   * The ranges must be positive and finite: otherwise the header has no
+   * usable scales and `BinaryImuWriter` does not open with it.
+   */
+  static ImuRecordingHeader int16(double acclRange, double gyroRange, double magnRange)
+  {
+    ImuRecordingHeader header;
+    header.encoding = ImuEncoding::Int16;
+    header.recordSize = 32;
+    header.acclScale = float(acclRange / 32767.0);
+    header.gyroScale = float(gyroRange / 32767.0);
+    header.magnScale = float(magnRange / 32767.0);
+    return header;
+  }
+
+  /**
+   * @brief Whether the records can be stored with these scales: the quantized
+   * encodings divide by them, so they must be positive and finite.
+   */
+  bool hasUsableScales() const
+  {
+    const auto usable = [](float scale) { return scale > 0.0f && std::isfinite(scale); };
+    return encoding == ImuEncoding::Float32
+           || (usable(acclScale) && usable(gyroScale) && usable(magnScale));
+  }
+};
+
+static_assert(sizeof(ImuRecordingHeader) == 64);
+
+/**
+ * @brief Convert a float to IEEE 754 half precision, rounding to nearest even.
+ */
+inline uint16_t floatToHalf(float value)
+{
+  const uint32_t bits = std::bit_cast<uint32_t>(value);
+  const uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+  const int exponent = int((bits >> 23) & 0xff);
+  uint32_t mantissa = bits & 0x7fffff;
+
+  if(exponent == 0xff)
+    return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+
+  const int halfExponent = exponent - 127 + 15;
+  if(halfExponent >= 31)
+    return sign | 0x7c00;
+
+  int shift = 13;
+  uint32_t half = (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+  if(halfExponent <= 0)
+  {
+    // Subnormal: the implicit leading bit becomes explicit.
+    if(halfExponent < -10)
+      return sign;
+    mantissa |= 0x800000;
+    shift = 14 - halfExponent;
+    half = mantissa >> shift;
+  }
+  const uint32_t rest = mantissa & ((uint32_t(1) << shift) - 1);
+  const uint32_t halfway = uint32_t(1) << (shift - 1);
+  // A carry out of the mantissa correctly bumps the exponent (up to infinity).
+  if(rest > halfway || (rest == halfway && (half & 1)))
+    ++half;
+  return uint16_t(sign | half);
+}
+
+/**
+ * @brief Convert an IEEE 754 half-precision value to float (exact).
+ */
+inline float halfToFloat(uint16_t half)
+{
+  const uint32_t sign = uint32_t(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1f;
+  const uint32_t mantissa = half & 0x3ff;
+
+  if(exponent == 0)
+  {
+    const float magnitude = float(mantissa) * 0x1p-24f;
+    return sign != 0 ? -magnitude : magnitude;
+  }
+  if(exponent == 31)
+    return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+  return std::bit_cast<float>(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
+
+/**
+ * @brief `ImuEncoding::Float32` record: the timestamp and the nine axes in
+ * single precision.
+ */
+struct ImuRecord
+{
+  static constexpr ImuEncoding encoding = ImuEncoding::Float32;
+
+  uint64_t timestampMicros = 0;
+  float accl[3]{};
+  float gyro[3]{};
+  float magn[3]{};
+  uint32_t reserved = 0;
+
+  static ImuRecord encode(const ImuSample& sample, const ImuRecordingHeader&)
+  {
+    const Imu9AxisT<float> imu(sample.imu);
+    return ImuRecord{
+        sample.timestampMicros,
+        {imu.accl.x, imu.accl.y, imu.accl.z},
+        {imu.gyro.x, imu.gyro.y, imu.gyro.z},
+        {imu.magn.x, imu.magn.y, imu.magn.z}};
+  }
+
+  ImuSample decode(const ImuRecordingHeader&) const
+  {
+    return ImuSample{
+        timestampMicros,
+        Imu9Axis{{accl[0], accl[1], accl[2]}, {gyro[0], gyro[1], gyro[2]},
+                 {magn[0], magn[1], magn[2]}}};
+  }
+};
+
+/**
+ * @brief Shared layout of the 32-byte quantized records.
+ * @tparam Stored `uint16_t` half-precision bits or `int16_t` integers.
+ * @tparam Codec Converts between `value / scale` and `Stored`.
+ */
+template <typename Stored, typename Codec, ImuEncoding Encoding>
+struct ImuRecord16
+{
+  static constexpr ImuEncoding encoding = Encoding;
+
+  uint64_t timestampMicros = 0;
+  Stored accl[3]{};
+  Stored gyro[3]{};
+  Stored magn[3]{};
+  uint16_t reserved[3]{};
+
+  static ImuRecord16 encode(const ImuSample& sample, const ImuRecordingHeader& header)
+  {
+    ImuRecord16 record;
+    record.timestampMicros = sample.timestampMicros;
+    store(record.accl, sample.imu.accl, header.acclScale);
+    store(record.gyro, sample.imu.gyro, header.gyroScale);
+    store(record.magn, sample.imu.magn, header.magnScale);
+    return record;
+  }
+
+  ImuSample decode(const ImuRecordingHeader& header) const
+  {
+    return ImuSample{
+        timestampMicros,
+        Imu9Axis{load(accl, header.acclScale), load(gyro, header.gyroScale),
+                 load(magn, header.magnScale)}};
+  }
+
+private:
+  static void store(Stored* out, const Coord3D& value, float scale)
+  {
+    out[0] = Codec::encode(value.x / scale);
+    out[1] = Codec::encode(value.y / scale);
+    out[2] = Codec::encode(value.z / scale);
+  }
+
+  static Coord3D load(const Stored* in, float scale)
+  {
+    const double s = scale;
+    return {Codec::decode(in[0]) * s, Codec::decode(in[1]) * s, Codec::decode(in[2]) * s};
+  }
+};
+
+struct HalfCodec
+{
+  static uint16_t encode(double value) { return floatToHalf(float(value)); }
+  static double decode(uint16_t stored) { return halfToFloat(stored); }
+};
+
+struct Int16Codec
+{
+  static int16_t encode(double value)
+  {
+    // NaN passes through std::clamp, and converting it to an integer is undefined.
+    if(std::isnan(value))
+      return 0;
+    return int16_t(std::clamp(std::nearbyint(value), -32767.0, 32767.0));
+  }
+  static double decode(int16_t stored) { return stored; }
+};
+
+/**
+ * @brief `ImuEncoding::Float16` record.
+ */
+using ImuRecordHalf = ImuRecord16<uint16_t, HalfCodec, ImuEncoding::Float16>;
+
+/**
+ * @brief `ImuEncoding::Int16` record.
+ */
+using ImuRecordInt16 = ImuRecord16<int16_t, Int16Codec, ImuEncoding::Int16>;
+
+static_assert(sizeof(ImuRecord) == 48);
+static_assert(sizeof(ImuRecordHalf) == 32);
+static_assert(sizeof(ImuRecordInt16) == 32);
+
+/**
+ * @brief Call `f.template operator()<Record>()` with the record type of
+ * `encoding`.
+ * @return false for an unknown encoding.
+ */
+template <typename F>
+bool withImuRecordType(ImuEncoding encoding, F&& f)
+{
+  switch(encoding)
+  {
+    case ImuEncoding::Float32:
+      f.template operator()<ImuRecord>();
+      return true;
+    case ImuEncoding::Float16:
+      f.template operator()<ImuRecordHalf>();
+      return true;
+    case ImuEncoding::Int16:
+      f.template operator()<ImuRecordInt16>();
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Validate the first bytes of a recording and fill `header`.
+ *
+ * Version 1 headers are converted to the equivalent version 2 fields.
+ *
+ * @param bytes At least the header (16 bytes for version 1, 64 for version 2).
+ * @return false if the bytes are not a supported recording header.
+ */
+inline bool parseImuRecordingHeader(std::span<const std::byte> bytes, ImuRecordingHeader& header)
+{
+  const ImuRecordingHeader expected;
+  header = {};
+  if(bytes.size() < 16 || std::memcmp(bytes.data(), expected.magic, sizeof expected.magic) != 0)
+    return false;
+  std::memcpy(&header, bytes.data(), std::min(bytes.size(), sizeof header));
+
+  if(header.version == 1)
+  {
+    // The upper half of the 32-bit version field reads as Float32.
+    header = ImuRecordingHeader::float32();
+    header.version = 1;
+    header.headerSize = 16;
+    return true;
+  }
+
+  uint32_t recordSize = 0;
+  const bool known = withImuRecordType(
+      header.encoding, [&]<typename Record>() { recordSize = sizeof(Record); });
+  return header.version == 2 && bytes.size() >= sizeof header && known
+         && header.recordSize == recordSize && header.headerSize >= sizeof header
+         && header.headerSize % 8 == 0 && header.hasUsableScales();
+}
+
+/**
+ * @class BinaryImuReader
+ * @brief Reads IMU samples from a binary recording in chunks of records.
+ *
+ * Any encoding is decoded to double-precision `ImuSample`s. For large files,
+ * `MappedImuRecording` avoids the copies through the read buffer.
+ */
+class BinaryImuReader
+{
+public:
+  /**
+   * @param path Binary recording.
+   * @param chunkRecords Number of records read from the file at once.
+   */
+  explicit BinaryImuReader(const char* path, std::size_t chunkRecords = 1024)
+      : file(std::fopen(path, "rb"))
+  {
+    std::byte bytes[sizeof(ImuRecordingHeader)];
+    const std::size_t got = file != nullptr ? std::fread(bytes, 1, sizeof bytes, file) : 0;
+    if(!parseImuRecordingHeader(std::span(bytes, got), format)
+       || std::fseek(file, long(format.headerSize), SEEK_SET) != 0)
+    {
+      close();
+      return;
+    }
+    buffer.resize(chunkRecords * format.recordSize);
+  }
+
+  BinaryImuReader(const BinaryImuReader&) = delete;
+  BinaryImuReader& operator=(const BinaryImuReader&) = delete;
+  ~BinaryImuReader() { close(); }
+
+  /**
+   * @brief Whether the file was opened and has a valid header.
+   */
+  bool isOpen() const { return file != nullptr; }
+
+  /**
+   * @brief Header of the recording.
+   */
+  const ImuRecordingHeader& header() const { return format; }
+
+  /**
+   * @brief Read the next samples.
+   * @param out Receives up to `out.size()` samples.
+   * @return Number of samples read, 0 at the end of the file.
+   */
+  std::size_t read(std::span<ImuSample> out)
+  {
+    std::size_t count = 0;
+    while(count < out.size() && isOpen())
+    {
+      if(next == available)
+      {
+        available = std::fread(
+            buffer.data(), format.recordSize, buffer.size() / format.recordSize, file);
+        next = 0;
+        if(available == 0)
+        {
+          close();
+          break;
+        }
+      }
+      withImuRecordType(format.encoding, [&]<typename Record>() {
+        const auto* records = reinterpret_cast<const Record*>(buffer.data());
+        for(; next < available && count < out.size(); ++next)
+          out[count++] = records[next].decode(format);
+      });
+    }
+    return count;
+  }
+
+private:
+  void close()
+  {
+    if(file != nullptr)
+      std::fclose(file);
+    file = nullptr;
+  }
+
+  std::FILE* file{};
+  ImuRecordingHeader format;
+  std::vector<std::byte> buffer;
+  std::size_t next = 0;
+  std::size_t available = 0;
+};
+
+/**
+ * @brief Whether a `BinaryImuWriter` replaces the file or appends to it.
+ */
+enum class ImuWriteMode
+{
+  Replace,
+  Append
+};
+
+/**
+ * @class BinaryImuWriter
+ * @brief Writes IMU samples to a binary recording.
+ *
+ * Samples are encoded into a buffer allocated once, which is written out
+ * when full and on `close()` (or destruction), so appending never
+ * reallocates.
+ *
+ * In `ImuWriteMode::Append`, an existing recording keeps its own header
+ * (encoding and scales) and new records go after its last complete record;
+ * a missing file is created with `format`. A file whose header cannot be
+ * read is left untouched and the writer is not opened, as is a `format`
+ * without usable scales (see `ImuRecordingHeader::hasUsableScales()`).
+ */
+class BinaryImuWriter
+{
+public:
+  /**
+   * @param path Output file.
+   * @param format Encoding and scales of a new file.
+   * @param mode Replace the file, or append to it.
+   * @param chunkRecords Number of records buffered before each write.
+   */
+  explicit BinaryImuWriter(
+      const char* path, const ImuRecordingHeader& format = ImuRecordingHeader::float32(),
+      ImuWriteMode mode = ImuWriteMode::Replace, std::size_t chunkRecords = 1024)
+      : header(format)
+  {
+    if(mode == ImuWriteMode::Append && (file = std::fopen(path, "r+b")) != nullptr)
+    {
+      // `header` keeps `format` unless the whole existing header is usable.
+      std::byte bytes[sizeof(ImuRecordingHeader)];
+      const std::size_t got = std::fread(bytes, 1, sizeof bytes, file);
+      ImuRecordingHeader existing;
+      long size = 0;
+      if(!parseImuRecordingHeader(std::span(bytes, got), existing)
+         || std::fseek(file, 0, SEEK_END) != 0 || (size = std::ftell(file)) < 0
+         || size < long(existing.headerSize))
+        closeFile();
+      else
+      {
+        const long records = (size - long(existing.headerSize)) / long(existing.recordSize);
+        if(std::fseek(
+               file, long(existing.headerSize) + records * long(existing.recordSize), SEEK_SET)
+           != 0)
+          closeFile();
+        else
+          header = existing;
+      }
+    }
+    else if(header.hasUsableScales())
+    {
+      file = std::fopen(path, "wb");
+      if(file != nullptr && std::fwrite(&header, sizeof header, 1, file) != 1)
+        closeFile();
+    }
+    buffer.resize(chunkRecords * header.recordSize);
+  }
+
+  BinaryImuWriter(const BinaryImuWriter&) = delete;
+  BinaryImuWriter& operator=(const BinaryImuWriter&) = delete;
+  ~BinaryImuWriter() { close(); }
+
+  /**
+   * @brief Whether the file is open and every write so far succeeded.
+   */
+  bool isOpen() const { return file != nullptr; }
+
+  /**
+   * @brief Header of the file being written.
+   */
+  const ImuRecordingHeader& format() const { return header; }
+
+  /**
+   * @brief Append samples.
+   * @return false if the file could not be written.
+   */
+  bool write(std::span<const ImuSample> samples)
+  {
+    if(!isOpen())
+      return false;
+    const std::size_t capacity = buffer.size() / header.recordSize;
+    for(std::size_t i = 0; i < samples.size() && isOpen();)
+    {
+      withImuRecordType(header.encoding, [&]<typename Record>() {
+        auto* records = reinterpret_cast<Record*>(buffer.data());
+        for(; i < samples.size() && buffered < capacity; ++i)
+          records[buffered++] = Record::encode(samples[i], header);
+      });
+      if(buffered == capacity)
+        flush();
+    }
+    return isOpen();
+  }
+
+  bool write(const ImuSample& sample) { return write(std::span(&sample, 1)); }
+
+  /**
+   * @brief Write the buffered records and close the file.
+   * @return false if the file could not be written.
+   */
+  bool close()
+  {
+    const bool ok = flush() && std::fclose(file) == 0;
+    file = nullptr;
+    return ok;
+  }
+
+private:
+  bool flush()
+  {
+    if(file != nullptr && buffered > 0
+       && std::fwrite(buffer.data(), header.recordSize, buffered, file) != buffered)
+      closeFile();
+    buffered = 0;
+    return file != nullptr;
+  }
+
+  void closeFile()
+  {
+    if(file != nullptr)
+      std::fclose(file);
+    file = nullptr;
+  }
+
+  std::FILE* file{};
+  ImuRecordingHeader header;
+  std::vector<std::byte> buffer;
+  std::size_t buffered = 0;
+};
+
+/**
+ * @class MappedImuRecording
+ * @brief Zero-copy view of a binary recording.
+ *
+ * @details
+ * The file is mapped read-only (`mmap` on POSIX hosts; elsewhere it is read
+ * into memory once) and `records<Record>()` views it in place as an array of
+ * the stored record type. Replaying a recording is then a pass over memory,
+ * with the kernel reading ahead. `read()` decodes from an internal cursor, so
+ * the mapping also works as a reader for `replay()`.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::utils::MappedImuRecording session("session.imu");
+ * for(const auto& record : session.records<puara_gestures::utils::ImuRecordInt16>())
+ *   shake.updateAt(record.decode(session.header()).imu.accl, record.timestampMicros);
+ * @endcode
+ */
+class MappedImuRecording
+{
+public:
+  explicit MappedImuRecording(const char* path)
+  {
+#if defined(PUARA_GESTURES_HAS_MMAP)
+    const int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+      return;
+    struct stat info;
+    if(::fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+      void* address = ::mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if(address != MAP_FAILED)
+      {
+        ::madvise(address, std::size_t(info.st_size), MADV_SEQUENTIAL);
+        data = static_cast<const std::byte*>(address);
+        length = std::size_t(info.st_size);
+      }
+    }
+    ::close(fd);
+#else
+    if(std::FILE* file = std::fopen(path, "rb"))
+    {
+      std::byte chunk[1 << 16];
+      while(const std::size_t got = std::fread(chunk, 1, sizeof chunk, file))
+        copy.insert(copy.end(), chunk, chunk + got);
+      std::fclose(file);
+      data = copy.data();
+      length = copy.size();
+    }
+#endif
+    if(data != nullptr && parseImuRecordingHeader(std::span(data, length), format))
+      count = (length - std::min<std::size_t>(length, format.headerSize)) / format.recordSize;
+    else
+      unmap();
+  }
+
+  MappedImuRecording(const MappedImuRecording&) = delete;
+  MappedImuRecording& operator=(const MappedImuRecording&) = delete;
+  ~MappedImuRecording() { unmap(); }
+
+  /**
+   * @brief Whether the file was mapped and has a valid header.
+   */
+  bool isOpen() const { return data != nullptr; }
+
+  /**
+   * @brief Header of the recording.
+   */
+  const ImuRecordingHeader& header() const { return format; }
+
+  /**
+   * @brief Number of complete records.
+   */
+  std::size_t size() const { return count; }
+
+  /**
+   * @brief The records, in place.
+   * @tparam Record `ImuRecord`, `ImuRecordHalf` or `ImuRecordInt16`.
+   * @return An empty span if the file holds another encoding.
+   */
+  template <typename Record>
+  std::span<const Record> records() const
+  {
+    if(!isOpen() || Record::encoding != format.encoding)
+      return {};
+    return {reinterpret_cast<const Record*>(data + format.headerSize), count};
+  }
+
+  /**
+   * @brief Decode the next samples from the internal cursor.
+   * @return Number of samples decoded, 0 at the end of the recording.
+   */
+  std::size_t read(std::span<ImuSample> out)
+  {
+    std::size_t decoded = 0;
+    withImuRecordType(format.encoding, [&]<typename Record>() {
+      const auto all = records<Record>();
+      decoded = std::min(out.size(), all.size() - std::min(all.size(), cursor));
+      for(std::size_t i = 0; i < decoded; ++i)
+        out[i] = all[cursor + i].decode(format);
+    });
+    cursor += decoded;
+    return decoded;
+  }
+
+  /**
+   * @brief Move the `read()` cursor back to the first record.
+   */
+  void rewind() { cursor = 0; }
+
+private:
+  void unmap()
+  {
+#if defined(PUARA_GESTURES_HAS_MMAP)
+    if(data != nullptr)
+      ::munmap(const_cast<std::byte*>(data), length);
+#else
+    copy.clear();
+#endif
+    data = nullptr;
+    length = 0;
+    count = 0;
+  }
+
+  const std::byte* data{};
+  std::size_t length = 0;
+  std::size_t count = 0;
+  std::size_t cursor = 0;
+  ImuRecordingHeader format;
+#if !defined(PUARA_GESTURES_HAS_MMAP)
+  std::vector<std::byte> copy;
+#endif
+};
+}
@@ -0,0 +1,286 @@
+/**
+* @file imuReplay.h
+* @brief Streaming CSV reader and a replay loop for recorded IMU sessions.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+* @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+*/
+#pragma once
+
+#include <puara/utils/imuRecording.h>
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace puara_gestures::utils
+{
+/**
+ * @class CsvImuReader
+ * @brief Reads IMU samples from a CSV recording in chunks.
+ *
+ * @details
+ * The header row is parsed once to map the `timestamp`, `accl_*`, `gyro_*`
+ * and `magn_*` (or `mag_*`) columns to sample fields; other columns are
+ * skipped and missing ones read as 0. The file is then read in blocks of
+ * `bufferSize` bytes and each row is split and converted in place with
+ * `std::from_chars`, so memory use does not grow with the recording length.
+ * Rows that do not parse, end before the last mapped column or do not fit in
+ * the buffer are skipped and counted in `skippedRows`.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::utils::CsvImuReader reader("session.csv", 1000.0); // ms timestamps
+ * std::array<puara_gestures::utils::ImuSample, 256> chunk;
+ * while(std::size_t n = reader.read(chunk))
+ *   process(std::span(chunk).first(n));
+ * @endcode
+ *
+ * Host only: it uses `<cstdio>` and floating-point `std::from_chars`.
+ */
+class CsvImuReader
+{
+public:
+  /**
+   * @param path CSV file with a header row.
+   * @param microsPerTimeUnit Microseconds per unit of the `timestamp`
+   *        column: 1000 for milliseconds, 1e6 for seconds.
+   * @param bufferSize Size of the read buffer; rows must be shorter.
+   */
+  explicit CsvImuReader(
+      const char* path, double microsPerTimeUnit = 1000.0, std::size_t bufferSize = 1 << 16)
+      : file(std::fopen(path, "rb"))
+      , timeScale(microsPerTimeUnit)
+      , buffer(bufferSize)
+  {
+    if(file != nullptr && !readHeader())
+      close();
+  }
+
+  CsvImuReader(const CsvImuReader&) = delete;
+  CsvImuReader& operator=(const CsvImuReader&) = delete;
+  ~CsvImuReader() { close(); }
+
+  /**
+   * @brief Whether the file was opened and has a header row.
+   */
+  bool isOpen() const { return file != nullptr; }
+
+  /**
+   * @brief Number of rows that could not be parsed.
+   */
+  std::size_t skippedRows = 0;
+
+  /**
+   * @brief Read the next samples.
+   * @param out Receives up to `out.size()` samples.
+   * @return Number of samples read, 0 at the end of the file.
+   */
+  std::size_t read(std::span<ImuSample> out)
+  {
+    std::size_t count = 0;
+    while(count < out.size() && isOpen())
+    {
+      const char* line = buffer.data() + begin;
+      const auto* newline
+          = static_cast<const char*>(std::memchr(line, '\n', end - begin));
+      if(newline == nullptr)
+      {
+        if(refill())
+          continue;
+        // Last row without a final newline; refill() moved it to the front.
+        if(begin < end && !discardingRow
+           && parseRow(buffer.data() + begin, buffer.data() + end, out[count]))
+          ++count;
+        close();
+        break;
+      }
+      begin = newline - buffer.data() + 1;
+      if(discardingRow)
+      {
+        // End of a row that did not fit in the buffer.
+        discardingRow = false;
+        continue;
+      }
+      if(parseRow(line, newline, out[count]))
+        ++count;
+    }
+    return count;
+  }
+
+private:
+  // Column slots: 0 is the timestamp, 1-9 the accl, gyro and magn axes.
+  static int slotOf(std::string_view name)
+  {
+    constexpr std::string_view names[] = {"timestamp", "accl_x", "accl_y", "accl_z",
+                                          "gyro_x",    "gyro_y", "gyro_z", "magn_x",
+                                          "magn_y",    "magn_z"};
+    for(int slot = 0; slot < 10; ++slot)
+      if(name == names[slot])
+        return slot;
+    // Some recordings name the magnetometer columns mag_x, mag_y and mag_z.
+    if(name.size() == 5 && name.starts_with("mag_") && name[4] >= 'x' && name[4] <= 'z')
+      return 7 + (name[4] - 'x');
+    return -1;
+  }
+
+  bool readHeader()
+  {
+    if(!refill())
+      return false;
+    const char* line = buffer.data();
+    const auto* newline = static_cast<const char*>(std::memchr(line, '\n', end));
+    if(newline == nullptr)
+      return false;
+    for(const char* field = line; field <= newline;)
+    {
+      const char* comma = field;
+      while(comma < newline && *comma != ',')
+        ++comma;
+      std::string_view name(field, comma - field);
+      if(!name.empty() && name.back() == '\r')
+        name.remove_suffix(1);
+      columns.push_back(static_cast<int8_t>(slotOf(name)));
+      if(columns.back() >= 0)
+        requiredColumns = columns.size();
+      field = comma + 1;
+    }
+    begin = newline - line + 1;
+    return true;
+  }
+
+  // Keep the unread bytes and fill the rest of the buffer.
+  bool refill()
+  {
+    if(begin == 0 && end == buffer.size())
+    {
+      // A row longer than the buffer: drop what was read of it, and the rest
+      // up to the next newline.
+      if(!discardingRow)
+        ++skippedRows;
+      discardingRow = true;
+      end = 0;
+    }
+    std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+    end -= begin;
+    begin = 0;
+    const std::size_t got = std::fread(buffer.data() + end, 1, buffer.size() - end, file);
+    end += got;
+    return got > 0;
+  }
+
+  bool parseRow(const char* line, const char* lineEnd, ImuSample& sample)
+  {
+    if(lineEnd > line && lineEnd[-1] == '\r')
+      --lineEnd;
+    if(lineEnd == line)
+      return false;
+
+    double values[10]{};
+    const char* field = line;
+    std::size_t column = 0;
+    for(; column < columns.size() && field <= lineEnd; ++column)
+    {
+      const char* comma = field;
+      while(comma < lineEnd && *comma != ',')
+        ++comma;
+      if(columns[column] >= 0)
+      {
+        const auto result = std::from_chars(field, comma, values[columns[column]]);
+        if(result.ec != std::errc{} || result.ptr != comma)
+        {
+          ++skippedRows;
+          return false;
+        }
+      }
+      field = comma + 1;
+    }
+    if(column < requiredColumns)
+    {
+      // The row ends before the last mapped column.
+      ++skippedRows;
+      return false;
+    }
+
+    sample.timestampMicros = static_cast<uint64_t>(std::llround(values[0] * timeScale));
+    sample.imu = Imu9Axis{
+        {values[1], values[2], values[3]},
+        {values[4], values[5], values[6]},
+        {values[7], values[8], values[9]}};
+    return true;
+  }
+
+  void close()
+  {
+    if(file != nullptr)
+      std::fclose(file);
+    file = nullptr;
+  }
+
+  std::FILE* file{};
+  double timeScale{};
+  std::vector<char> buffer;
+  std::size_t begin = 0;
+  std::size_t end = 0;
+  std::vector<int8_t> columns;
+  // Columns up to and including the last one mapped to a sample field.
+  std::size_t requiredColumns = 0;
+  bool discardingRow = false;
+};
+
+/**
+ * @brief Stream every sample of a reader through a set of descriptors.
+ *
+ * Samples are read `ChunkSize` at a time into a stack buffer. A sink callable
+ * with `const ImuSample&` (including a generic `const auto&` lambda) is called
+ * with each sample in order; any other sink receives each chunk as a
+ * `std::span<const ImuSample>` (for block APIs).
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::utils::CsvImuReader reader("session.csv");
+ * puara_gestures::Shake3D shake;
+ * puara_gestures::Jab3D jab;
+ * puara_gestures::utils::replay(
+ *     reader,
+ *     [&](const auto& s) { shake.updateAt(s.imu.accl, s.timestampMicros); },
+ *     [&](const auto& s) { jab.update(s.imu.accl); });
+ * @endcode
+ *
+ * @tparam ChunkSize Samples per read.
+ * @param reader Any type with `std::size_t read(std::span<ImuSample>)`:
+ *        `CsvImuReader`, `BinaryImuReader` or `MappedImuRecording`.
+ * @param sinks Descriptor callbacks.
+ * @return Number of samples replayed.
+ */
+template <std::size_t ChunkSize = 256, typename Reader, typename... Sinks>
+std::size_t replay(Reader& reader, Sinks&&... sinks)
+{
+  ImuSample chunk[ChunkSize];
+  std::size_t total = 0;
+  while(const std::size_t count = reader.read(chunk))
+  {
+    const std::span<const ImuSample> samples(chunk, count);
+    (
+        [&](auto& sink) {
+          // Checked first: probing a generic lambda with a span would
+          // instantiate its body with the wrong type.
+          if constexpr(std::is_invocable_v<decltype(sink), const ImuSample&>)
+            for(const auto& sample : samples)
+              sink(sample);
+          else
+            sink(samples);
+        }(sinks),
+        ...);
+    total += count;
+  }
+  return total;
+}
+}
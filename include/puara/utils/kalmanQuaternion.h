@@ -1,34 +1,56 @@
 /**
 * @file kalmanQuaternion.h
-* @brief Simplified Kalman-style quaternion filter for 9-DoF IMU orientation.
+* @brief Multiplicative extended Kalman filter (orientation and gyro bias) for 9-DoF IMU orientation.
 * @see https://github.com/Puara/puara-gestures
 * @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
 */
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <boost/math/constants/constants.hpp>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <puara/structs.h>
 #include <puara/utils/chrono.h>
+#include <puara/utils/fastmath.h>
+#include <span>
 
 /**
- * @class KalmanQuaternionFilter
- * @brief Simplified Kalman-style quaternion filter for 9-DoF IMU orientation.
+ * @class KalmanQuaternionFilterT
+ * @brief Multiplicative extended Kalman filter for 9-DoF IMU orientation.
  *
  * @ingroup puara_gestures_utils
  * @details
- * This implementation performs gyro-based quaternion prediction and then
- * blends toward an accel/magnetometer-based orientation measurement.
- * It is intentionally compact and similar in usage style to the Madgwick and
- * Mahony filters in this project.
+ * The filter keeps the orientation as a quaternion and estimates a 6-state
+ * error around it: a small rotation (in the body frame) and the gyroscope
+ * bias, with their full 6x6 covariance. Each update:
+ * @li integrates the bias-corrected gyro rate into the quaternion and
+ *     propagates the covariance;
+ * @li corrects with the gravity direction measured by the accelerometer (three
+ *     scalar updates), trusting it less when the acceleration magnitude moves
+ *     away from the running gravity magnitude, e.g. during a jab;
+ * @li corrects the heading with the magnetometer, as a single update around
+ *     the vertical axis, so magnetic disturbances do not tilt the estimate;
+ * @li folds the estimated error into the quaternion and the bias.
+ *
+ * The first sample aligns the orientation with the accelerometer and
+ * magnetometer directly. Everything is fixed-size and on the stack, with no
+ * trigonometry after that first sample.
  *
  * Usage:
- * @li The class stores orientation as `puara_gestures::Quaternion`.
- * @li Input data is accepted through `puara_gestures::Imu9Axis`.
+ * @li The class stores orientation as `puara_gestures::QuaternionT<T>`.
+ * @li Input data is accepted through `puara_gestures::Imu9AxisT<T>`.
+ * @li `KalmanQuaternionFilter` is the double-precision filter; `KalmanQuaternionFilterT<float>`
+ *     keeps the whole update in single precision for targets without a double FPU.
+ *     Convert samples with `static_cast<Imu9AxisT<float>>(imu)`.
  * @li Gyroscope values are assumed to be in radians/sec by default.
  * @li Use `gyroDegrees = true` when gyro values are in degrees/sec.
+ * @li Accelerometer and magnetometer units do not matter, only directions.
+ * @li `Math` selects the square root and Euler angle functions. The update is
+ *     dominated by the covariance algebra, which no policy changes, so
+ *     `fastmath::FastMath` mainly speeds up `getEuler*()` (see fastmath.h).
  *
  * Example:
  * @code
@@ -49,59 +71,71 @@
 
 namespace puara_gestures {
 
-struct KalmanQuaternionFilter {
-    // Simplified Kalman-style quaternion fusion.
-    // This implementation uses gyro prediction and an adaptive blend
-    // toward an accel/magnetometer-based orientation estimate.
-    // A true quaternion EKF is much larger; this keeps the interface
-    // compact and similar to the other AHRS filters.
-    double processNoise{};
-    double measurementNoise{};
-    Quaternion quaternion{};
+template <typename T = double, typename Math = fastmath::StdMath>
+struct KalmanQuaternionFilterT {
+    // Gyro rate noise, in (rad/s)^2 per second of integration.
+    T processNoise{};
+    // Noise of the normalized accelerometer and magnetometer directions.
+    T measurementNoise{};
+    // Gyro bias random walk, in (rad/s)^2 per second.
+    T biasNoise{};
+    QuaternionT<T> quaternion{};
+    // Estimated gyro bias, in rad/s, subtracted from the gyro readings.
+    Coord3DT<T> gyroBias{};
+    // Error covariance, row-major: attitude error (rad) then gyro bias (rad/s).
+    std::array<T, 36> covariance{};
+    // Running accelerometer magnitude at rest, in the accelerometer's units.
+    T gravityNorm{};
     uint64_t lastUpdateMicros{};
 
-    explicit KalmanQuaternionFilter(double processNoise_ = 0.001, double measurementNoise_ = 0.01)
+    explicit KalmanQuaternionFilterT(T processNoise_ = T(0.001), T measurementNoise_ = T(0.01),
+                                     T biasNoise_ = T(1e-6))
         : processNoise(processNoise_)
         , measurementNoise(measurementNoise_)
-        , quaternion{1.0, 0.0, 0.0, 0.0}
+        , biasNoise(biasNoise_)
+        , quaternion{T(1.0), T(0.0), T(0.0), T(0.0)}
         , lastUpdateMicros(0)
     {
-        if (processNoise < 0.0) {
-            processNoise = 0.0;
+        if (processNoise < T(0.0)) {
+            processNoise = T(0.0);
         }
-        if (measurementNoise < 0.0) {
-            measurementNoise = 0.0;
+        if (biasNoise < T(0.0)) {
+            biasNoise = T(0.0);
         }
-        if (processNoise + measurementNoise <= 0.0) {
-            measurementNoise = 1e-6;
+        if (measurementNoise <= T(0.0)) {
+            measurementNoise = T(1e-6);
         }
+        resetCovariance();
     }
 
     void reset() {
-        quaternion = {1.0, 0.0, 0.0, 0.0};
+        quaternion = {T(1.0), T(0.0), T(0.0), T(0.0)};
+        gyroBias = {};
+        gravityNorm = T(0.0);
+        resetCovariance();
         lastUpdateMicros = 0;
     }
 
-    bool update(const Imu9Axis& imu, bool gyroDegrees = false) {
+    bool update(const Imu9AxisT<T>& imu, bool gyroDegrees = false) {
         return updateWithTimestamp(imu, utils::getCurrentTimeMicroseconds(), gyroDegrees);
     }
 
-    const Quaternion& getQuaternion() const {
+    const QuaternionT<T>& getQuaternion() const {
         return quaternion;
     }
 
-    void getEulerRadians(double& roll, double& pitch, double& yaw) const {
-        const double w = quaternion.w;
-        const double x = quaternion.x;
-        const double y = quaternion.y;
-        const double z = quaternion.z;
+    void getEulerRadians(T& roll, T& pitch, T& yaw) const {
+        const T w = quaternion.w;
+        const T x = quaternion.x;
+        const T y = quaternion.y;
+        const T z = quaternion.z;
 
-        roll = std::atan2(2.0 * (w * x + y * z), 1.0 - 2.0 * (x * x + y * y));
-        pitch = std::asin(std::clamp(2.0 * (w * y - z * x), -1.0, 1.0));
-        yaw = std::atan2(2.0 * (w * z + x * y), 1.0 - 2.0 * (y * y + z * z));
+        roll = Math::atan2(T(2.0) * (w * x + y * z), T(1.0) - T(2.0) * (x * x + y * y));
+        pitch = Math::asin(std::clamp(T(2.0) * (w * y - z * x), -T(1.0), T(1.0)));
+        yaw = Math::atan2(T(2.0) * (w * z + x * y), T(1.0) - T(2.0) * (y * y + z * z));
     }
 
-    void getEulerDegrees(double& roll, double& pitch, double& yaw) const {
+    void getEulerDegrees(T& roll, T& pitch, T& yaw) const {
         getEulerRadians(roll, pitch, yaw);
         roll *= RadToDeg;
         pitch *= RadToDeg;
@@ -109,83 +143,277 @@ struct KalmanQuaternionFilter {
     }
   // updateWithTimestamp is exposed for testing with synthetic timestamps, but
   // typical usage is to call update() with real-time data.
-    bool updateWithTimestamp(const Imu9Axis& imu, uint64_t currentMicros, bool gyroDegrees) {
+    bool updateWithTimestamp(const Imu9AxisT<T>& imu, uint64_t currentMicros, bool gyroDegrees) {
         if (currentMicros == 0) {
             return false;
         }
         if (lastUpdateMicros == 0) {
+            lastUpdateMicros = currentMicros;
+            align(imu);
+            return false;
+        }
+        if (currentMicros < lastUpdateMicros) {
+            // The clock went backwards (e.g. a restarted sensor): restart the
+            // time base rather than integrating a wrapped-around interval.
             lastUpdateMicros = currentMicros;
             return false;
         }
 
-        double deltatSeconds = double(currentMicros - lastUpdateMicros) * 1.0e-6;
+        const T deltatSeconds = T(double(currentMicros - lastUpdateMicros) * 1.0e-6);
         lastUpdateMicros = currentMicros;
         return updateInternal(imu, deltatSeconds, gyroDegrees);
     }
 
+    // Block version of updateWithTimestamp for recorded sessions or drained sensor FIFOs:
+    // out[i] receives the orientation after imu[i] at micros[i]. Returns the number of
+    // samples processed, the smallest of the three sizes.
+    std::size_t updateWithTimestamp(std::span<const Imu9AxisT<T>> imu,
+                                    std::span<const uint64_t> micros,
+                                    std::span<QuaternionT<T>> out,
+                                    bool gyroDegrees = false) {
+        const std::size_t count = std::min({imu.size(), micros.size(), out.size()});
+        for (std::size_t i = 0; i < count; ++i) {
+            updateWithTimestamp(imu[i], micros[i], gyroDegrees);
+            out[i] = quaternion;
+        }
+        return count;
+    }
+
 private:
-    bool updateInternal(const Imu9Axis& imu, double deltatSeconds, bool gyroDegrees) {
-        if (deltatSeconds <= 0.0) {
+    // Initial standard deviations: 0.1 rad of attitude, 0.05 rad/s of bias.
+    static constexpr T InitialAttitudeVariance = T(0.01);
+    static constexpr T InitialBiasVariance = T(0.0025);
+    // How fast the accelerometer loses weight as its magnitude departs from
+    // gravity: at 10% off, its noise is doubled.
+    static constexpr T AccelRejection = T(100.0);
+
+    void resetCovariance() {
+        covariance.fill(T(0.0));
+        for (int i = 0; i < 3; ++i) {
+            covariance[i * 7] = InitialAttitudeVariance;
+            covariance[(i + 3) * 7] = InitialBiasVariance;
+        }
+    }
+
+    // First sample: take roll and pitch from gravity, and yaw from the
+    // magnetometer when there is one.
+    void align(const Imu9AxisT<T>& imu) {
+        const T norm = std::hypot(imu.accl.x, imu.accl.y, imu.accl.z);
+        if (norm == T(0.0)) {
+            return;
+        }
+        gravityNorm = norm;
+        QuaternionT<T> measured;
+        if (estimateQuaternionFromAccelMag(imu.accl.x, imu.accl.y, imu.accl.z,
+                                           imu.magn.x, imu.magn.y, imu.magn.z,
+                                           measured)) {
+            quaternion = measured;
+        } else {
+            quaternion = quaternionFromEuler(std::atan2(imu.accl.y, imu.accl.z),
+                                             std::atan2(-imu.accl.x,
+                                                        std::hypot(imu.accl.y, imu.accl.z)),
+                                             T(0.0));
+        }
+        normalizeQuaternion(quaternion);
+    }
+
+    bool updateInternal(const Imu9AxisT<T>& imu, T deltatSeconds, bool gyroDegrees) {
+        if (deltatSeconds <= T(0.0)) {
             return false;
         }
 
-        double gx = imu.gyro.x;
-        double gy = imu.gyro.y;
-        double gz = imu.gyro.z;
+        T gx = imu.gyro.x;
+        T gy = imu.gyro.y;
+        T gz = imu.gyro.z;
         if (gyroDegrees) {
             gx *= DegToRad;
             gy *= DegToRad;
             gz *= DegToRad;
         }
+        gx -= gyroBias.x;
+        gy -= gyroBias.y;
+        gz -= gyroBias.z;
+
+        T transition[3][3];
+        predictQuaternion(gx, gy, gz, deltatSeconds, transition);
+        propagateCovariance(transition, deltatSeconds);
+
+        // Error state accumulated over the sequential scalar updates.
+        T dx[6] = {};
+        const QuaternionT<T>& q = quaternion;
+
+        // Gravity direction predicted in the body frame: third row of R(q).
+        const T gravity[3] = {
+            T(2.0) * (q.x * q.z - q.w * q.y),
+            T(2.0) * (q.y * q.z + q.w * q.x),
+            T(1.0) - T(2.0) * (q.x * q.x + q.y * q.y)};
+
+        const T accelNormSq = imu.accl.x * imu.accl.x + imu.accl.y * imu.accl.y
+                              + imu.accl.z * imu.accl.z;
+        if (accelNormSq > T(0.0)) {
+            const T invAccelNorm = Math::rsqrt(accelNormSq);
+            const T accelNorm = accelNormSq * invAccelNorm;
+            if (gravityNorm <= T(0.0)) {
+                gravityNorm = accelNorm;
+            }
+            const T deviation = accelNorm / gravityNorm - T(1.0);
+            const T noise = measurementNoise * (T(1.0) + AccelRejection * deviation * deviation);
+            // Slow average over the samples close to gravity, so sustained
+            // offsets (units, calibration) are learned but motion is not.
+            if (std::abs(deviation) < T(0.1)) {
+                gravityNorm += T(0.01) * (accelNorm - gravityNorm);
+            }
+
+            // Measurement a/|a| = gravity + [gravity x] dtheta.
+            const T measured[3] = {imu.accl.x * invAccelNorm, imu.accl.y * invAccelNorm,
+                                   imu.accl.z * invAccelNorm};
+            const T rows[3][3] = {{T(0.0), -gravity[2], gravity[1]},
+                                  {gravity[2], T(0.0), -gravity[0]},
+                                  {-gravity[1], gravity[0], T(0.0)}};
+            for (int i = 0; i < 3; ++i) {
+                scalarUpdate(rows[i], measured[i] - gravity[i], noise, dx);
+            }
+        }
 
-        predictQuaternion(gx, gy, gz, deltatSeconds);
-
-        Quaternion measured;
-        if (!estimateQuaternionFromAccelMag(imu.accl.x, imu.accl.y, imu.accl.z,
-                                           imu.magn.x, imu.magn.y, imu.magn.z,
-                                           measured)) {
-            return true;
+        // Heading: magnetometer rotated to the earth frame should point
+        // along +x horizontally. Only the rotation about the vertical is
+        // corrected, which is gravity^T dtheta in the body frame.
+        const T mx = imu.magn.x;
+        const T my = imu.magn.y;
+        const T mz = imu.magn.z;
+        const T magNormSq = mx * mx + my * my + mz * mz;
+        if (magNormSq > T(0.0)) {
+            const T ex = (T(1.0) - T(2.0) * (q.y * q.y + q.z * q.z)) * mx
+                         + T(2.0) * (q.x * q.y - q.w * q.z) * my
+                         + T(2.0) * (q.x * q.z + q.w * q.y) * mz;
+            const T ey = T(2.0) * (q.x * q.y + q.w * q.z) * mx
+                         + (T(1.0) - T(2.0) * (q.x * q.x + q.z * q.z)) * my
+                         + T(2.0) * (q.y * q.z - q.w * q.x) * mz;
+            const T horizontalSq = ex * ex + ey * ey;
+            // Skip when the field is nearly vertical: the heading is undefined.
+            if (horizontalSq > T(0.0025) * magNormSq) {
+                // Sine of the heading error: continuous all the way round, so
+                // a heading close to 180 degrees off cannot flip the correction.
+                const T heading = ey * Math::rsqrt(horizontalSq);
+                const T ratioSq = horizontalSq / magNormSq;
+                scalarUpdate(gravity, -heading, measurementNoise / ratioSq, dx);
+            }
         }
 
-        double gain = processNoise / (processNoise + measurementNoise);
-        gain = std::clamp(gain, 0.0, 1.0);
-        quaternion = slerp(quaternion, measured, gain);
+        // Fold the error into the quaternion (q <- q * [1, dtheta / 2]) and the bias.
+        const T hx = T(0.5) * dx[0];
+        const T hy = T(0.5) * dx[1];
+        const T hz = T(0.5) * dx[2];
+        quaternion = QuaternionT<T>{
+            q.w - q.x * hx - q.y * hy - q.z * hz,
+            q.x + q.w * hx + q.y * hz - q.z * hy,
+            q.y + q.w * hy - q.x * hz + q.z * hx,
+            q.z + q.w * hz + q.x * hy - q.y * hx};
         normalizeQuaternion(quaternion);
+        gyroBias.x += dx[3];
+        gyroBias.y += dx[4];
+        gyroBias.z += dx[5];
 
         return true;
     }
 
-    void predictQuaternion(double gx, double gy, double gz, double deltat) {
-        // Gyro integration step: propagate the quaternion forward using angular velocity.
-        // This is the prediction phase of the simplified Kalman-style filter.
-        double q0 = quaternion.w;
-        double q1 = quaternion.x;
-        double q2 = quaternion.y;
-        double q3 = quaternion.z;
-
-        double qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
-        double qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
-        double qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
-        double qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
-
-        q0 += qDot1 * deltat;
-        q1 += qDot2 * deltat;
-        q2 += qDot3 * deltat;
-        q3 += qDot4 * deltat;
-
-        quaternion.w = q0;
-        quaternion.x = q1;
-        quaternion.y = q2;
-        quaternion.z = q3;
+    // Rotation by the angle vector w * dt, q <- q * [cos(a/2), sin(a/2) w/|w|],
+    // with the series of cos(a/2) and sin(a/2)/a (error below 1e-5 up to one
+    // radian per step). `transition` receives the inverse rotation, which
+    // carries the attitude error from the previous body frame to the new one.
+    void predictQuaternion(T gx, T gy, T gz, T deltat, T (&transition)[3][3]) {
+        const T ax = gx * deltat;
+        const T ay = gy * deltat;
+        const T az = gz * deltat;
+        const T angle2 = ax * ax + ay * ay + az * az;
+        const T c = T(1.0) - angle2 * (T(1.0) / T(8.0)) * (T(1.0) - angle2 * (T(1.0) / T(48.0)));
+        const T s = T(0.5) - angle2 * (T(1.0) / T(48.0)) * (T(1.0) - angle2 * (T(1.0) / T(80.0)));
+        const T rx = s * ax;
+        const T ry = s * ay;
+        const T rz = s * az;
+
+        const QuaternionT<T> q = quaternion;
+        quaternion.w = q.w * c - q.x * rx - q.y * ry - q.z * rz;
+        quaternion.x = q.w * rx + q.x * c + q.y * rz - q.z * ry;
+        quaternion.y = q.w * ry - q.x * rz + q.y * c + q.z * rx;
+        quaternion.z = q.w * rz + q.x * ry - q.y * rx + q.z * c;
         normalizeQuaternion(quaternion);
+
+        const T n = T(2.0) / (c * c + rx * rx + ry * ry + rz * rz);
+        transition[0][0] = T(1.0) - n * (ry * ry + rz * rz);
+        transition[0][1] = n * (rx * ry + c * rz);
+        transition[0][2] = n * (rx * rz - c * ry);
+        transition[1][0] = n * (rx * ry - c * rz);
+        transition[1][1] = T(1.0) - n * (rx * rx + rz * rz);
+        transition[1][2] = n * (ry * rz + c * rx);
+        transition[2][0] = n * (rx * rz + c * ry);
+        transition[2][1] = n * (ry * rz - c * rx);
+        transition[2][2] = T(1.0) - n * (rx * rx + ry * ry);
+    }
+
+    // P <- F P F^T + Q, with F = [[f, -I dt], [0, I]].
+    void propagateCovariance(const T (&f)[3][3], T dt) {
+        T* P = covariance.data();
+
+        // FP = F P
+        T FP[36];
+        for (int c = 0; c < 6; ++c) {
+            for (int r = 0; r < 3; ++r) {
+                FP[r * 6 + c] = f[r][0] * P[c] + f[r][1] * P[6 + c] + f[r][2] * P[12 + c]
+                                - dt * P[(r + 3) * 6 + c];
+            }
+            for (int r = 3; r < 6; ++r) {
+                FP[r * 6 + c] = P[r * 6 + c];
+            }
+        }
+        // P = FP F^T
+        for (int r = 0; r < 6; ++r) {
+            const T* row = FP + r * 6;
+            for (int c = 0; c < 3; ++c) {
+                P[r * 6 + c] = row[0] * f[c][0] + row[1] * f[c][1] + row[2] * f[c][2]
+                               - dt * row[c + 3];
+            }
+            for (int c = 3; c < 6; ++c) {
+                P[r * 6 + c] = row[c];
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            P[i * 7] += processNoise * dt;
+            P[(i + 3) * 7] += biasNoise * dt;
+        }
+    }
+
+    // One scalar measurement whose Jacobian only involves the attitude error:
+    // innovation = h . dtheta + noise.
+    void scalarUpdate(const T (&h)[3], T innovation, T noise, T (&dx)[6]) {
+        T* P = covariance.data();
+        T PH[6];
+        for (int i = 0; i < 6; ++i) {
+            PH[i] = P[i * 6] * h[0] + P[i * 6 + 1] * h[1] + P[i * 6 + 2] * h[2];
+        }
+        const T S = h[0] * PH[0] + h[1] * PH[1] + h[2] * PH[2] + noise;
+        if (!(S > T(0.0))) {
+            return;
+        }
+        const T invS = T(1.0) / S;
+        const T residual = (innovation - (h[0] * dx[0] + h[1] * dx[1] + h[2] * dx[2])) * invS;
+        for (int i = 0; i < 6; ++i) {
+            dx[i] += PH[i] * residual;
+        }
+        for (int r = 0; r < 6; ++r) {
+            const T k = PH[r] * invS;
+            for (int c = 0; c < 6; ++c) {
+                P[r * 6 + c] -= k * PH[c];
+            }
+        }
     }
 
-    static bool estimateQuaternionFromAccelMag(double ax, double ay, double az,
-                                               double mx, double my, double mz,
-                                               Quaternion& quaternionOut) {
+    static bool estimateQuaternionFromAccelMag(T ax, T ay, T az,
+                                               T mx, T my, T mz,
+                                               QuaternionT<T>& quaternionOut) {
         // Normalize accelerometer data to extract the gravity direction.
-        double norm = std::hypot(ax, ay, az);
-        if (norm == 0.0) {
+        T norm = std::hypot(ax, ay, az);
+        if (norm == T(0.0)) {
             return false;
         }
         ax /= norm;
@@ -193,36 +421,36 @@ private:
         az /= norm;
 
         // Compute roll and pitch from the gravity vector.
-        double roll = std::atan2(ay, az);
-        double pitch = std::atan2(-ax, std::hypot(ay, az));
+        T roll = std::atan2(ay, az);
+        T pitch = std::atan2(-ax, std::hypot(ay, az));
 
-        double sinRoll = std::sin(roll);
-        double cosRoll = std::cos(roll);
-        double sinPitch = std::sin(pitch);
-        double cosPitch = std::cos(pitch);
+        T sinRoll = std::sin(roll);
+        T cosRoll = std::cos(roll);
+        T sinPitch = std::sin(pitch);
+        T cosPitch = std::cos(pitch);
 
         // Rotate the magnetometer measurements into the horizontal plane.
         // This removes the effect of tilt and allows yaw to be computed.
-        double mx2 = mx * cosPitch + my * sinPitch * sinRoll + mz * sinPitch * cosRoll;
-        double my2 = my * cosRoll - mz * sinRoll;
-        if (mx2 == 0.0 && my2 == 0.0) {
+        T mx2 = mx * cosPitch + my * sinPitch * sinRoll + mz * sinPitch * cosRoll;
+        T my2 = my * cosRoll - mz * sinRoll;
+        if (mx2 == T(0.0) && my2 == T(0.0)) {
             return false;
         }
 
-        double yaw = std::atan2(-my2, mx2);
+        T yaw = std::atan2(-my2, mx2);
         quaternionOut = quaternionFromEuler(roll, pitch, yaw);
         return true;
     }
 
-    static Quaternion quaternionFromEuler(double roll, double pitch, double yaw) {
-        double cr = std::cos(roll * 0.5);
-        double sr = std::sin(roll * 0.5);
-        double cp = std::cos(pitch * 0.5);
-        double sp = std::sin(pitch * 0.5);
-        double cy = std::cos(yaw * 0.5);
-        double sy = std::sin(yaw * 0.5);
+    static QuaternionT<T> quaternionFromEuler(T roll, T pitch, T yaw) {
+        T cr = std::cos(roll * T(0.5));
+        T sr = std::sin(roll * T(0.5));
+        T cp = std::cos(pitch * T(0.5));
+        T sp = std::sin(pitch * T(0.5));
+        T cy = std::cos(yaw * T(0.5));
+        T sy = std::sin(yaw * T(0.5));
 
-        return Quaternion{
+        return QuaternionT<T>{
             cr * cp * cy + sr * sp * sy,
             sr * cp * cy - cr * sp * sy,
             cr * sp * cy + sr * cp * sy,
@@ -230,58 +458,24 @@ private:
         };
     }
 
-    static Quaternion slerp(const Quaternion& a, const Quaternion& b, double t) {
-        // Spherical linear interpolation between two quaternion orientations.
-        // This blends the predicted orientation and the measured orientation smoothly.
-        double cosTheta = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
-        Quaternion target = b;
-        if (cosTheta < 0.0) {
-            target.w = -target.w;
-            target.x = -target.x;
-            target.y = -target.y;
-            target.z = -target.z;
-            cosTheta = -cosTheta;
-        }
-
-        if (cosTheta > 0.9995) {
-            Quaternion result{
-                a.w + t * (target.w - a.w),
-                a.x + t * (target.x - a.x),
-                a.y + t * (target.y - a.y),
-                a.z + t * (target.z - a.z)
-            };
-            normalizeQuaternion(result);
-            return result;
-        }
-
-        double theta = std::acos(cosTheta);
-        double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
-        double aFactor = std::sin((1.0 - t) * theta) / sinTheta;
-        double bFactor = std::sin(t * theta) / sinTheta;
-
-        return Quaternion{
-            a.w * aFactor + target.w * bFactor,
-            a.x * aFactor + target.x * bFactor,
-            a.y * aFactor + target.y * bFactor,
-            a.z * aFactor + target.z * bFactor
-        };
-    }
-
-    static void normalizeQuaternion(Quaternion& q) {
-        double norm = std::hypot(std::hypot(q.w, q.x), std::hypot(q.y, q.z));
-        if (norm == 0.0) {
-            q = {1.0, 0.0, 0.0, 0.0};
+    static void normalizeQuaternion(QuaternionT<T>& q) {
+        const T normSq = q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z;
+        if (normSq == T(0.0)) {
+            q = {T(1.0), T(0.0), T(0.0), T(0.0)};
             return;
         }
-        q.w /= norm;
-        q.x /= norm;
-        q.y /= norm;
-        q.z /= norm;
+        const T invNorm = Math::rsqrt(normSq);
+        q.w *= invNorm;
+        q.x *= invNorm;
+        q.y *= invNorm;
+        q.z *= invNorm;
     }
 
-    static constexpr double DegToRad = boost::math::constants::degree<double>();
-    static constexpr double RadToDeg = boost::math::constants::radian<double>();
+    static constexpr T DegToRad = boost::math::constants::degree<T>();
+    static constexpr T RadToDeg = boost::math::constants::radian<T>();
 };
 
+using KalmanQuaternionFilter = KalmanQuaternionFilterT<double>;
+
 } // namespace puara_gestures
 
@@ -9,9 +9,39 @@
 #pragma once
 
 #include <puara/utils/chrono.h>
-  
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
 namespace puara_gestures::utils
 {
+/**
+ * @brief How LeakyIntegrator applies the leak over time.
+ */
+enum class LeakMode
+{
+  /**
+   * @brief Apply the full leak at most once per `1 / frequency` seconds.
+   *
+   * Samples that arrive sooner are added without leaking. This is the
+   * historical behavior and the default.
+   */
+  Gated,
+
+  /**
+   * @brief Apply `leak ^ (dt * frequency)` on every sample.
+   *
+   * `leak` is the fraction kept after one nominal period of `1 / frequency`
+   * seconds, whatever the actual sample rate. With `frequency <= 0` the leak
+   * is applied once per sample, like the gated mode.
+   *
+   * Every entry point honors it: `integrate()` takes `dt` from the clock,
+   * `integrateAt()` from the timestamps and `integrateDt()` as given.
+   */
+  Continuous
+};
+
 /**
  * @class LeakyIntegrator
  * @brief Input smoothing with leak and timing control.
@@ -29,6 +59,19 @@ namespace puara_gestures::utils
  *
  *  In this example the integrator keeps half of the previous output on each step.
  *  A `leak` of 0.0 ignores history, and 1.0 fully retains it.
+ *
+ *  With a positive `frequency`, `integrate()` reads the clock to time the
+ *  leak. To process recorded data, or to read the clock once per frame for
+ *  many integrators, pass the sample time instead:
+ *
+ * @code
+ *   puara_gestures::utils::LeakyIntegrator integrator(0.0, 0.0, 0.5, 100, 0);
+ *   integrator.mode = puara_gestures::utils::LeakMode::Continuous;
+ *
+ *   // Half of the value is kept every 10 ms, whatever the sample rate.
+ *   integrator.integrateAt(1.0, sampleTimeMicros);
+ *   integrator.integrateDt(1.0, 0.0025); // or the time since the previous sample
+ * @endcode
  */
 class LeakyIntegrator
 {
@@ -58,14 +101,20 @@ public:
    */
   unsigned long long timer{};
 
+  /**
+   * @brief How the leak is applied over time.
+   */
+  LeakMode mode = LeakMode::Gated;
+
   explicit LeakyIntegrator(
       double currentValue = 0, double oldValue = 0, double leakValue = 0.5,
-      int freq = 100, unsigned long long timerValue = 0)
+      int freq = 100, unsigned long long timerValue = 0, LeakMode leakMode = LeakMode::Gated)
       : current_value(currentValue)
       , old_value(oldValue)
       , leak(leakValue)
       , frequency(freq)
       , timer(timerValue)
+      , mode(leakMode)
   {
   }
 
@@ -73,7 +122,10 @@ public:
    * @brief Integrate a new sample using the configured leak and frequency.
    *
    * This behaves like an attenuator: each new reading is combined with a
-   * fraction of the previous value, controlled by `leak`.
+   * fraction of the previous value, controlled by `leak`. The clock is only
+   * read when `freq` is positive. In `LeakMode::Continuous`, the leak follows
+   * the clock time elapsed since the previous sample and `timerValue` is not
+   * used.
    *
    * @param reading New value to add into the integrator.
    * @param custom_leak Leak factor between 0 and 1.
@@ -85,40 +137,150 @@ public:
       double reading, double oldValue, double leakValue, int freq,
       unsigned long long& timerValue)
   {
-    const auto current_time = utils::getCurrentTimeMicroseconds();
+    const unsigned long long current_time
+        = freq > 0 ? utils::getCurrentTimeMicroseconds() : 0;
+    if(mode == LeakMode::Continuous)
+    {
+      const double dtSeconds = freq > 0 ? elapsedSeconds(current_time) : 0.0;
+      return leakContinuous(reading, oldValue, leakValue, freq, dtSeconds);
+    }
+    return gate(reading, oldValue, leakValue, freq, timerValue, current_time);
+  }
+
+  double integrate(double reading, double leakValue, unsigned long long& timerValue)
+  {
+    return this->integrate(reading, old_value, leakValue, frequency, timerValue);
+  }
+
+  double integrate(double reading, double leakValue)
+  {
+    return this->integrate(reading, old_value, leakValue, frequency, timer);
+  }
+
+  double integrate(double reading)
+  {
+    return this->integrate(reading, old_value, leak, frequency, timer);
+  }
+
+  /**
+   * @brief Integrate a sample taken at a known time, without reading the clock.
+   *
+   * In `LeakMode::Gated`, the timestamp replaces the clock reading of
+   * `integrate()`. In `LeakMode::Continuous`, the leak is derived from the
+   * time elapsed since the previous timestamped sample (none for the first).
+   *
+   * A timestamp earlier than the previous one (a new recording, a device
+   * reset) restarts the time base: the sample is taken as the first one
+   * instead of leaking over a wrapped-around interval.
+   *
+   * @param reading New value to add into the integrator.
+   * @param leakValue Leak factor between 0 and 1.
+   * @param timestampMicros Sample time in microseconds, from any monotonic origin.
+   * @return The updated integrator output.
+   */
+  double integrateAt(double reading, double leakValue, uint64_t timestampMicros)
+  {
+    const bool restart = hasTimestamp && timestampMicros < lastTimestampMicros;
+    const double dtSeconds = elapsedSeconds(timestampMicros);
+    if(mode == LeakMode::Continuous)
+      return leakContinuous(reading, old_value, leakValue, frequency, dtSeconds);
+
+    if(restart)
+      timer = timestampMicros / 1000LL;
+    return gate(reading, old_value, leakValue, frequency, timer, timestampMicros);
+  }
+
+  double integrateAt(double reading, uint64_t timestampMicros)
+  {
+    return integrateAt(reading, leak, timestampMicros);
+  }
+
+  /**
+   * @brief Integrate a sample taken `dtSeconds` after the previous one.
+   *
+   * In `LeakMode::Gated`, the durations are accumulated into an internal
+   * clock that replaces the clock reading of `integrate()`. A negative
+   * duration counts as zero.
+   *
+   * @param reading New value to add into the integrator.
+   * @param leakValue Leak factor between 0 and 1.
+   * @param dtSeconds Time since the previous sample, in seconds.
+   * @return The updated integrator output.
+   */
+  double integrateDt(double reading, double leakValue, double dtSeconds)
+  {
+    if(!(dtSeconds > 0.0))
+      dtSeconds = 0.0;
+    if(mode == LeakMode::Continuous)
+      return leakContinuous(reading, old_value, leakValue, frequency, dtSeconds);
 
+    elapsedMicros += static_cast<uint64_t>(std::llround(dtSeconds * 1.0e6));
+    return gate(reading, old_value, leakValue, frequency, timer, elapsedMicros);
+  }
+
+  double integrateDt(double reading, double dtSeconds)
+  {
+    return integrateDt(reading, leak, dtSeconds);
+  }
+
+private:
+  double gate(
+      double reading, double oldValue, double leakValue, int freq,
+      unsigned long long& timerValue, unsigned long long currentMicros)
+  {
     if(freq <= 0)
     {
       current_value = reading + (oldValue * leakValue);
     }
-    else if((current_time / 1000LL) - (1000 / frequency) < timerValue)
+    else if((currentMicros / 1000LL) < timerValue + (1000 / frequency))
     {
       current_value = reading + old_value;
     }
     else
     {
       current_value = reading + (oldValue * leakValue);
-      timer = (current_time / 1000LL);
+      timer = (currentMicros / 1000LL);
     }
     old_value = current_value;
     return current_value;
   }
 
-  double integrate(double reading, double leakValue, unsigned long long& timerValue)
+  // Seconds since the previous timestamp; 0 for the first one and when the
+  // clock went backwards, which restarts the time base.
+  double elapsedSeconds(uint64_t timestampMicros)
   {
-    return this->integrate(reading, old_value, leakValue, frequency, timerValue);
+    const double dtSeconds = hasTimestamp && timestampMicros >= lastTimestampMicros
+                                 ? double(timestampMicros - lastTimestampMicros) * 1.0e-6
+                                 : 0.0;
+    lastTimestampMicros = timestampMicros;
+    hasTimestamp = true;
+    return dtSeconds;
   }
 
-  double integrate(double reading, double leakValue)
+  double leakContinuous(
+      double reading, double oldValue, double leakValue, int freq, double dtSeconds)
   {
-    return this->integrate(reading, old_value, leakValue, frequency, timer);
+    // At a steady sample rate the exponent does not change, so pow() only
+    // runs when the leak or the interval does.
+    const double exponent = freq > 0 ? dtSeconds * freq : 1.0;
+    if(leakValue != cachedLeak || exponent != cachedExponent)
+    {
+      cachedLeak = leakValue;
+      cachedExponent = exponent;
+      cachedCoefficient = std::pow(leakValue, exponent);
+    }
+    current_value = reading + oldValue * cachedCoefficient;
+    old_value = current_value;
+    return current_value;
   }
 
-  double integrate(double reading)
-  {
-    return this->integrate(reading, old_value, leak, frequency, timer);
-  }
+  uint64_t lastTimestampMicros{};
+  bool hasTimestamp{};
+  uint64_t elapsedMicros{};
+
+  double cachedLeak = std::numeric_limits<double>::quiet_NaN();
+  double cachedExponent = std::numeric_limits<double>::quiet_NaN();
+  double cachedCoefficient = 1.0;
 };
 
 }
-
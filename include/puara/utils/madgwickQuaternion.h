@@ -9,12 +9,15 @@
 #include <algorithm>
 #include <boost/math/constants/constants.hpp>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <puara/structs.h>
 #include <puara/utils/chrono.h>
+#include <puara/utils/fastmath.h>
+#include <span>
 
 /**
- * @class MadgwickQuaternionFilter
+ * @class MadgwickQuaternionFilterT
  * @brief MadgwickQuaternionFilter for 9-DoF IMU orientation estimation.
  *
  * @details This header defines a lightweight Madgwick AHRS filter that consumes 9-DoF
@@ -25,10 +28,16 @@
  *
  * @ingroup puara_gestures_utils
  * Usage:
- * @li The class stores orientation as `puara_gestures::Quaternion`.
- * @li Input data is accepted through `puara_gestures::Imu9Axis`.
+ * @li The class stores orientation as `puara_gestures::QuaternionT<T>`.
+ * @li Input data is accepted through `puara_gestures::Imu9AxisT<T>`.
+ * @li `MadgwickQuaternionFilter` is the double-precision filter; `MadgwickQuaternionFilterT<float>`
+ *     keeps the whole update in single precision for targets without a double FPU.
+ *     Convert samples with `static_cast<Imu9AxisT<float>>(imu)`.
  * @li By default, gyroscope data is expected in radians/sec.
  * @li Use `gyroDegrees = true` when gyro values are in degrees/sec.
+ * @li `Math` selects the square root and Euler angle functions. `fastmath::FastMath`
+ *     only speeds up the Euler angle getters: an update costs the same as with
+ *     `StdMath` on a CPU with a hardware square root (see fastmath.h).
  *
  * Example:
  * @code{.cpp}
@@ -55,35 +64,36 @@
 
 namespace puara_gestures {
 
-struct MadgwickQuaternionFilter {
+template <typename T = double, typename Math = fastmath::StdMath>
+struct MadgwickQuaternionFilterT {
     // beta : Fusion gain for the Madgwick algorithm.
     // Larger values make the filter correct drift faster,
     // while smaller values make the output smoother.
     // Default is 0.1.
-    double beta{0.1};
-    Quaternion quaternion;
+    T beta{T(0.1)};
+    QuaternionT<T> quaternion;
     uint64_t lastUpdateMicros = 0;
 
-    explicit MadgwickQuaternionFilter(double beta_ = 0.1)
-        : beta(beta_), quaternion{1.0, 0.0, 0.0, 0.0}, lastUpdateMicros(0)
+    explicit MadgwickQuaternionFilterT(T beta_ = T(0.1))
+        : beta(beta_), quaternion{T(1.0), T(0.0), T(0.0), T(0.0)}, lastUpdateMicros(0)
     {
     }
 
     void reset() {
-        quaternion = {1.0, 0.0, 0.0, 0.0};
+        quaternion = {T(1.0), T(0.0), T(0.0), T(0.0)};
         lastUpdateMicros = 0;
     }
 
     // Simple public entry point using the portable timer.
     // The filter computes the elapsed interval automatically.
-    bool update(const Imu9Axis& imu, bool gyroDegrees = false) {
+    bool update(const Imu9AxisT<T>& imu, bool gyroDegrees = false) {
         const uint64_t currentMicros = utils::getCurrentTimeMicroseconds();
         return updateWithTimestamp(imu, currentMicros, gyroDegrees);
     }
 
     // updateWithTimestamp allows the caller to provide a synthetic timestamp for testing
     // but user code will typically call update() with real-time data which in turn calls this function.
-    bool updateWithTimestamp(const Imu9Axis& imu, uint64_t currentMicros, bool gyroDegrees = false) {
+    bool updateWithTimestamp(const Imu9AxisT<T>& imu, uint64_t currentMicros, bool gyroDegrees = false) {
         if (currentMicros == 0) {
             return false;
         }
@@ -92,16 +102,31 @@ struct MadgwickQuaternionFilter {
             return false; // first sample only sets the baseline time.
         }
 
-        double deltatSeconds = double(currentMicros - lastUpdateMicros) * 1.0e-6;
+        const T deltatSeconds = T(double(currentMicros - lastUpdateMicros) * 1.0e-6);
         lastUpdateMicros = currentMicros;
         return updateInternal(imu, deltatSeconds, gyroDegrees);
     }
 
+    // Block version of updateWithTimestamp for recorded sessions or drained sensor FIFOs:
+    // out[i] receives the orientation after imu[i] at micros[i]. Returns the number of
+    // samples processed, the smallest of the three sizes.
+    std::size_t updateWithTimestamp(std::span<const Imu9AxisT<T>> imu,
+                                    std::span<const uint64_t> micros,
+                                    std::span<QuaternionT<T>> out,
+                                    bool gyroDegrees = false) {
+        const std::size_t count = std::min({imu.size(), micros.size(), out.size()});
+        for (std::size_t i = 0; i < count; ++i) {
+            updateWithTimestamp(imu[i], micros[i], gyroDegrees);
+            out[i] = quaternion;
+        }
+        return count;
+    }
+
 private:
-    bool updateInternal(const Imu9Axis& imu, double deltatSeconds, bool gyroDegrees = false) {
-        double gx = imu.gyro.x;
-        double gy = imu.gyro.y;
-        double gz = imu.gyro.z;
+    bool updateInternal(const Imu9AxisT<T>& imu, T deltatSeconds, bool gyroDegrees = false) {
+        T gx = imu.gyro.x;
+        T gy = imu.gyro.y;
+        T gz = imu.gyro.z;
         if (gyroDegrees) {
             gx *= DegToRad;
             gy *= DegToRad;
@@ -114,22 +139,22 @@ private:
     }
 
 public:
-    const Quaternion& getQuaternion() const {
+    const QuaternionT<T>& getQuaternion() const {
         return quaternion;
     }
 
-    void getEulerRadians(double& roll, double& pitch, double& yaw) const {
-        const double w = quaternion.w;
-        const double x = quaternion.x;
-        const double y = quaternion.y;
-        const double z = quaternion.z;
+    void getEulerRadians(T& roll, T& pitch, T& yaw) const {
+        const T w = quaternion.w;
+        const T x = quaternion.x;
+        const T y = quaternion.y;
+        const T z = quaternion.z;
 
-        roll = std::atan2(2.0 * (w * x + y * z), 1.0 - 2.0 * (x * x + y * y));
-        pitch = std::asin(std::clamp(2.0 * (w * y - z * x), -1.0, 1.0));
-        yaw = std::atan2(2.0 * (w * z + x * y), 1.0 - 2.0 * (y * y + z * z));
+        roll = Math::atan2(T(2.0) * (w * x + y * z), T(1.0) - T(2.0) * (x * x + y * y));
+        pitch = Math::asin(std::clamp(T(2.0) * (w * y - z * x), -T(1.0), T(1.0)));
+        yaw = Math::atan2(T(2.0) * (w * z + x * y), T(1.0) - T(2.0) * (y * y + z * z));
     }
 
-    void getEulerDegrees(double& roll, double& pitch, double& yaw) const {
+    void getEulerDegrees(T& roll, T& pitch, T& yaw) const {
         getEulerRadians(roll, pitch, yaw);
         roll *= RadToDeg;
         pitch *= RadToDeg;
@@ -137,37 +162,37 @@ public:
     }
 
 private:
-    static constexpr double DegToRad = boost::math::constants::degree<double>();
-    static constexpr double RadToDeg = boost::math::constants::radian<double>();
+    static constexpr T DegToRad = boost::math::constants::degree<T>();
+    static constexpr T RadToDeg = boost::math::constants::radian<T>();
 
-    static double invSqrt(double value) {
-        return 1.0 / std::sqrt(value);
+    static T invSqrt(T value) {
+        return Math::rsqrt(value);
     }
 
-    bool update(double gx, double gy, double gz,
-                double ax, double ay, double az,
-                double mx, double my, double mz,
-                double deltat) {
-        if (deltat <= 0.0) {
+    bool update(T gx, T gy, T gz,
+                T ax, T ay, T az,
+                T mx, T my, T mz,
+                T deltat) {
+        if (deltat <= T(0.0)) {
             return false;
         }
 
-        if (mx == 0.0 && my == 0.0 && mz == 0.0) {
+        if (mx == T(0.0) && my == T(0.0) && mz == T(0.0)) {
             // If magnetometer data is missing, fall back to the 6-DoF IMU-only update.
             return updateIMU(gx, gy, gz, ax, ay, az, deltat);
         }
 
-        if ((ax == 0.0 && ay == 0.0 && az == 0.0) ||
-            (mx == 0.0 && my == 0.0 && mz == 0.0)) {
+        if ((ax == T(0.0) && ay == T(0.0) && az == T(0.0)) ||
+            (mx == T(0.0) && my == T(0.0) && mz == T(0.0))) {
             // Invalid sensor data: either accel or magnetometer is all zeros.
             return false;
         }
 
-        // Quaternion components are used directly in the gradient descent correction.
-        double q0 = quaternion.w;
-        double q1 = quaternion.x;
-        double q2 = quaternion.y;
-        double q3 = quaternion.z;
+        // QuaternionT<T> components are used directly in the gradient descent correction.
+        T q0 = quaternion.w;
+        T q1 = quaternion.x;
+        T q2 = quaternion.y;
+        T q3 = quaternion.z;
 
         // See the Madgwick paper for the detailed algorithm steps:
         // An efficient orientation filter for inertial and inertial/magnetic sensor arrays
@@ -175,30 +200,30 @@ private:
         // April 30, 2010
         // http://www.x-io.co.uk/open-source-imu-and-ahrs-algorithms/
 
-        double recipNorm = 0.0;
-        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
-        double qDot1 = 0.0, qDot2 = 0.0, qDot3 = 0.0, qDot4 = 0.0;
-        double hx = 0.0, hy = 0.0, _2bx = 0.0, _2bz = 0.0;
-        double _2q0mx = 0.0, _2q0my = 0.0, _2q0mz = 0.0, _2q1mx = 0.0;
-        double _2q0 = 2.0 * q0;
-        double _2q1 = 2.0 * q1;
-        double _2q2 = 2.0 * q2;
-        double _2q3 = 2.0 * q3;
-        double _2q0q2 = 2.0 * q0 * q2;
-        double _2q0q3 = 2.0 * q0 * q3;
-        double _2q1q2 = 2.0 * q1 * q2;
-        double _2q1q3 = 2.0 * q1 * q3;
-        double _2q2q3 = 2.0 * q2 * q3;
-        double q0q0 = q0 * q0;
-        double q0q1 = q0 * q1;
-        double q0q2 = q0 * q2;
-        double q0q3 = q0 * q3;
-        double q1q1 = q1 * q1;
-        double q1q2 = q1 * q2;
-        double q1q3 = q1 * q3;
-        double q2q2 = q2 * q2;
-        double q2q3 = q2 * q3;
-        double q3q3 = q3 * q3;
+        T recipNorm = T(0.0);
+        T s0 = T(0.0), s1 = T(0.0), s2 = T(0.0), s3 = T(0.0);
+        T qDot1 = T(0.0), qDot2 = T(0.0), qDot3 = T(0.0), qDot4 = T(0.0);
+        T hx = T(0.0), hy = T(0.0), _2bx = T(0.0), _2bz = T(0.0);
+        T _2q0mx = T(0.0), _2q0my = T(0.0), _2q0mz = T(0.0), _2q1mx = T(0.0);
+        T _2q0 = T(2.0) * q0;
+        T _2q1 = T(2.0) * q1;
+        T _2q2 = T(2.0) * q2;
+        T _2q3 = T(2.0) * q3;
+        T _2q0q2 = T(2.0) * q0 * q2;
+        T _2q0q3 = T(2.0) * q0 * q3;
+        T _2q1q2 = T(2.0) * q1 * q2;
+        T _2q1q3 = T(2.0) * q1 * q3;
+        T _2q2q3 = T(2.0) * q2 * q3;
+        T q0q0 = q0 * q0;
+        T q0q1 = q0 * q1;
+        T q0q2 = q0 * q2;
+        T q0q3 = q0 * q3;
+        T q1q1 = q1 * q1;
+        T q1q2 = q1 * q2;
+        T q1q3 = q1 * q3;
+        T q2q2 = q2 * q2;
+        T q2q3 = q2 * q3;
+        T q3q3 = q3 * q3;
 
         recipNorm = invSqrt(ax * ax + ay * ay + az * az);
         ax *= recipNorm;
@@ -210,51 +235,51 @@ private:
         my *= recipNorm;
         mz *= recipNorm;
 
-        _2q0mx = 2.0 * q0 * mx;
-        _2q0my = 2.0 * q0 * my;
-        _2q0mz = 2.0 * q0 * mz;
-        _2q1mx = 2.0 * q1 * mx;
+        _2q0mx = T(2.0) * q0 * mx;
+        _2q0my = T(2.0) * q0 * my;
+        _2q0mz = T(2.0) * q0 * mz;
+        _2q1mx = T(2.0) * q1 * mx;
         hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1mx * q3 - mx * q2q2 - mx * q3q3;
         hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
         _2bx = std::sqrt(hx * hx + hy * hy);
         _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
-        _2bx *= 2.0;
-        _2bz *= 2.0;
+        _2bx *= T(2.0);
+        _2bz *= T(2.0);
 
-        double _4bx = 2.0 * _2bx;
-        double _4bz = 2.0 * _2bz;
+        T _4bx = T(2.0) * _2bx;
+        T _4bz = T(2.0) * _2bz;
 
-        s0 = -_2q2 * (2.0 * q1q3 - _2q0q2 - ax)
-             + _2q1 * (2.0 * q0q1 + _2q2q3 - ay)
-             - _2bz * q2 * (_2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
+        s0 = -_2q2 * (T(2.0) * q1q3 - _2q0q2 - ax)
+             + _2q1 * (T(2.0) * q0q1 + _2q2q3 - ay)
+             - _2bz * q2 * (_2bx * (T(0.5) - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
              + (-_2bx * q3 + _2bz * q1) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my)
-             + _2bx * q2 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz);
+             + _2bx * q2 * (_2bx * (q0q2 + q1q3) + _2bz * (T(0.5) - q1q1 - q2q2) - mz);
 
-        s1 = _2q3 * (2.0 * q1q3 - _2q0q2 - ax)
-             + _2q0 * (2.0 * q0q1 + _2q2q3 - ay)
-             - 4.0 * q1 * (1.0 - 2.0 * q1q1 - 2.0 * q2q2 - az)
-             + _2bz * q3 * (_2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
+        s1 = _2q3 * (T(2.0) * q1q3 - _2q0q2 - ax)
+             + _2q0 * (T(2.0) * q0q1 + _2q2q3 - ay)
+             - T(4.0) * q1 * (T(1.0) - T(2.0) * q1q1 - T(2.0) * q2q2 - az)
+             + _2bz * q3 * (_2bx * (T(0.5) - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
              + (_2bx * q2 + _2bz * q0) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my)
-             + (_2bx * q3 - _4bz * q1) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz);
+             + (_2bx * q3 - _4bz * q1) * (_2bx * (q0q2 + q1q3) + _2bz * (T(0.5) - q1q1 - q2q2) - mz);
 
-        s2 = -_2q0 * (2.0 * q1q3 - _2q0q2 - ax)
-             + _2q3 * (2.0 * q0q1 + _2q2q3 - ay)
-             - 4.0 * q2 * (1.0 - 2.0 * q1q1 - 2.0 * q2q2 - az)
-             + (-_4bx * q2 - _2bz * q0) * (_2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
+        s2 = -_2q0 * (T(2.0) * q1q3 - _2q0q2 - ax)
+             + _2q3 * (T(2.0) * q0q1 + _2q2q3 - ay)
+             - T(4.0) * q2 * (T(1.0) - T(2.0) * q1q1 - T(2.0) * q2q2 - az)
+             + (-_4bx * q2 - _2bz * q0) * (_2bx * (T(0.5) - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
              + (_2bx * q1 + _2bz * q3) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my)
-             + (_2bx * q0 - _4bz * q2) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz);
+             + (_2bx * q0 - _4bz * q2) * (_2bx * (q0q2 + q1q3) + _2bz * (T(0.5) - q1q1 - q2q2) - mz);
 
-        s3 = _2q1 * (2.0 * q1q3 - _2q0q2 - ax)
-             + _2q2 * (2.0 * q0q1 + _2q2q3 - ay)
-             + (-_4bx * q3 + _2bz * q1) * (_2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
+        s3 = _2q1 * (T(2.0) * q1q3 - _2q0q2 - ax)
+             + _2q2 * (T(2.0) * q0q1 + _2q2q3 - ay)
+             + (-_4bx * q3 + _2bz * q1) * (_2bx * (T(0.5) - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
              + (-_2bx * q0 + _2bz * q2) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my)
-             + _2bx * q1 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz);
+             + _2bx * q1 * (_2bx * (q0q2 + q1q3) + _2bz * (T(0.5) - q1q1 - q2q2) - mz);
 
         // The vector [s0, s1, s2, s3] is the gradient of the objective function.
         // Normalizing it makes the correction independent of sensor magnitude.
         {
-            const double sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
-            if (sNorm > 0.0) {
+            const T sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+            if (sNorm > T(0.0)) {
                 recipNorm = invSqrt(sNorm);
                 s0 *= recipNorm;
                 s1 *= recipNorm;
@@ -263,10 +288,10 @@ private:
             }
         }
 
-        qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz) - beta * s0;
-        qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy) - beta * s1;
-        qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx) - beta * s2;
-        qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx) - beta * s3;
+        qDot1 = T(0.5) * (-q1 * gx - q2 * gy - q3 * gz) - beta * s0;
+        qDot2 = T(0.5) * (q0 * gx + q2 * gz - q3 * gy) - beta * s1;
+        qDot3 = T(0.5) * (q0 * gy - q1 * gz + q3 * gx) - beta * s2;
+        qDot4 = T(0.5) * (q0 * gz + q1 * gy - q2 * gx) - beta * s3;
 
         q0 += qDot1 * deltat;
         q1 += qDot2 * deltat;
@@ -282,58 +307,58 @@ private:
         return true;
     }
 
-    bool updateIMU(double gx, double gy, double gz,
-                   double ax, double ay, double az,
-                   double deltat) {
-        if (deltat <= 0.0) {
+    bool updateIMU(T gx, T gy, T gz,
+                   T ax, T ay, T az,
+                   T deltat) {
+        if (deltat <= T(0.0)) {
             return false;
         }
-        if (ax == 0.0 && ay == 0.0 && az == 0.0) {
+        if (ax == T(0.0) && ay == T(0.0) && az == T(0.0)) {
             return false;
         }
 
-        double q0 = quaternion.w;
-        double q1 = quaternion.x;
-        double q2 = quaternion.y;
-        double q3 = quaternion.z;
-
-        double recipNorm;
-        double s0, s1, s2, s3;
-        double qDot1, qDot2, qDot3, qDot4;
-        double _2q0 = 2.0 * q0;
-        double _2q1 = 2.0 * q1;
-        double _2q2 = 2.0 * q2;
-        double _2q3 = 2.0 * q3;
-        double _4q0 = 4.0 * q0;
-        double _4q1 = 4.0 * q1;
-        double _4q2 = 4.0 * q2;
-        double _8q1 = 8.0 * q1;
-        double _8q2 = 8.0 * q2;
-        double q0q0 = q0 * q0;
-        double q1q1 = q1 * q1;
-        double q2q2 = q2 * q2;
-        double q3q3 = q3 * q3;
+        T q0 = quaternion.w;
+        T q1 = quaternion.x;
+        T q2 = quaternion.y;
+        T q3 = quaternion.z;
+
+        T recipNorm;
+        T s0, s1, s2, s3;
+        T qDot1, qDot2, qDot3, qDot4;
+        T _2q0 = T(2.0) * q0;
+        T _2q1 = T(2.0) * q1;
+        T _2q2 = T(2.0) * q2;
+        T _2q3 = T(2.0) * q3;
+        T _4q0 = T(4.0) * q0;
+        T _4q1 = T(4.0) * q1;
+        T _4q2 = T(4.0) * q2;
+        T _8q1 = T(8.0) * q1;
+        T _8q2 = T(8.0) * q2;
+        T q0q0 = q0 * q0;
+        T q1q1 = q1 * q1;
+        T q2q2 = q2 * q2;
+        T q3q3 = q3 * q3;
 
         recipNorm = invSqrt(ax * ax + ay * ay + az * az);
         ax *= recipNorm;
         ay *= recipNorm;
         az *= recipNorm;
 
-        qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
-        qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
-        qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
-        qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+        qDot1 = T(0.5) * (-q1 * gx - q2 * gy - q3 * gz);
+        qDot2 = T(0.5) * (q0 * gx + q2 * gz - q3 * gy);
+        qDot3 = T(0.5) * (q0 * gy - q1 * gz + q3 * gx);
+        qDot4 = T(0.5) * (q0 * gz + q1 * gy - q2 * gx);
 
         // Gradient descent from the accelerometer-only objective function.
         // This is used when magnetometer measurements are unavailable.
         s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
-        s1 = _4q1 * q3q3 - _2q3 * ax + 4.0 * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
-        s2 = 4.0 * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
-        s3 = 4.0 * q1q1 * q3 - _2q1 * ax + 4.0 * q2q2 * q3 - _2q2 * ay;
+        s1 = _4q1 * q3q3 - _2q3 * ax + T(4.0) * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        s2 = T(4.0) * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        s3 = T(4.0) * q1q1 * q3 - _2q1 * ax + T(4.0) * q2q2 * q3 - _2q2 * ay;
 
         {
-            const double sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
-            if (sNorm > 0.0) {
+            const T sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+            if (sNorm > T(0.0)) {
                 recipNorm = invSqrt(sNorm);
                 s0 *= recipNorm;
                 s1 *= recipNorm;
@@ -362,4 +387,6 @@ private:
     }
 };
 
+using MadgwickQuaternionFilter = MadgwickQuaternionFilterT<double>;
+
 } // namespace puara_gestures
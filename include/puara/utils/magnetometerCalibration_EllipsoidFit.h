@@ -0,0 +1,260 @@
+/**
+* @file magnetometerCalibration_EllipsoidFit.h
+* @brief Streaming ellipsoid-fit magnetometer calibration.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <puara/structs.h>
+#include <puara/utils/includeEigen.h>
+
+
+namespace puara_gestures::utils
+{
+
+/**
+ * @class Streaming_Magnetometer_Calibration
+ * @brief Online magnetometer calibration by a general ellipsoid fit.
+ *
+ * @details Each sample is folded into the 10x10 scatter matrix of its quadric
+ * terms (x², y², z², xy, xz, yz, x, y, z, 1) and then dropped, so the memory
+ * use is constant (about 1 kB) however long the calibration runs, where
+ * `Embedded_Magnetometer_Calibration` keeps up to 512 raw samples.
+ *
+ * `generateMagnetometerMatrices()` can be called at any time, e.g. once a
+ * second while the user waves the device around. It re-centres and rescales
+ * the statistics exactly, takes the quadric of least algebraic error (the
+ * eigenvector of the smallest eigenvalue of the 10x10 matrix), and turns it
+ * into a hard-iron bias and a full symmetric 3x3 soft-iron matrix, so rotated
+ * and sheared ellipsoids are corrected, not only axis-aligned ones. All Eigen
+ * types are fixed-size: nothing is allocated after construction.
+ *
+ * The fit needs samples spread over the whole sphere of orientations. When
+ * they only cover a band or a cap, the best quadric may not be an ellipsoid;
+ * the solve then fails and the previous matrices are kept.
+ *
+ * Example:
+ * @code{.cpp}
+ *   puara_gestures::utils::Streaming_Magnetometer_Calibration calibrator;
+ *
+ *   // for every magnetometer reading during the calibration gesture:
+ *   calibrator.addSample(imu.magn);
+ *
+ *   if (calibrator.generateMagnetometerMatrices()) {
+ *       calibrator.applyMagnetometerCalibration(imu);
+ *       // calibrator.myCalIMU.magn now contains calibrated magnetometer values
+ *   }
+ * @endcode
+ */
+class Streaming_Magnetometer_Calibration
+{
+public:
+  using Scatter = Eigen::Matrix<double, 10, 10>;
+  using Terms = Eigen::Matrix<double, 10, 1>;
+
+  /// Fewest samples for which a solve is attempted, one per free parameter.
+  static constexpr std::size_t MinSamples = 9;
+
+  Imu9Axis myCalIMU;
+  Eigen::Matrix3d softIronMatrix;
+  Eigen::Vector3d hardIronBias;
+  /// `[S | -S b]`, the calibration as one affine transform, used by `apply()`.
+  /// Call `updateTransform()` after setting `softIronMatrix` or `hardIronBias`.
+  Eigen::Matrix<double, 3, 4> transform;
+  double calibrationRadius = 1.0;
+
+  /// Sum of terms(p - origin) * terms(p - origin)^T over the samples.
+  Scatter scatter;
+  /// First sample; the statistics are kept relative to it for precision.
+  Eigen::Vector3d origin;
+  std::size_t sampleCount = 0;
+
+  Streaming_Magnetometer_Calibration() { reset(); }
+
+  /**
+   * @brief Forget the samples and go back to the identity calibration.
+   */
+  void reset()
+  {
+    scatter.setZero();
+    origin.setZero();
+    sampleCount = 0;
+    softIronMatrix.setIdentity();
+    hardIronBias.setZero();
+    updateTransform();
+  }
+
+  void addSample(const Coord3D& sample)
+  {
+    if(sampleCount == 0)
+      origin = Eigen::Vector3d(sample.x, sample.y, sample.z);
+
+    const Terms t = terms(Eigen::Vector3d(sample.x, sample.y, sample.z) - origin);
+    scatter.noalias() += t * t.transpose();
+    ++sampleCount;
+  }
+
+  /**
+   * @brief Add a block of samples. Returns the number of samples added.
+   */
+  std::size_t addSamples(std::span<const Coord3D> samples)
+  {
+    for(const auto& sample : samples)
+      addSample(sample);
+    return samples.size();
+  }
+
+  /**
+   * @brief Fit an ellipsoid to the samples added so far.
+   * @return 1 when `hardIronBias` and `softIronMatrix` were updated, 0 when
+   * there are too few samples or they do not describe an ellipsoid.
+   */
+  int generateMagnetometerMatrices()
+  {
+    if(sampleCount < MinSamples)
+      return 0;
+
+    // Move the origin to the centroid and scale to unit RMS distance, so the
+    // eigenvector below does not depend on the units or the size of the bias.
+    const double n = static_cast<double>(sampleCount);
+    const Eigen::Vector3d centroid = scatter.block<3, 1>(6, 9) / n;
+    const Scatter toCentroid = shift(centroid);
+    const Scatter centred = toCentroid * scatter * toCentroid.transpose();
+    const double meanSquare = (centred(0, 9) + centred(1, 9) + centred(2, 9)) / n;
+    if(!(meanSquare > std::numeric_limits<double>::min()))
+      return 0;
+    const double scale = 1.0 / std::sqrt(meanSquare);
+    Terms weights;
+    weights << scale * scale, scale * scale, scale * scale, scale * scale, scale * scale,
+        scale * scale, scale, scale, scale, 1.0;
+    const Scatter normalized = weights.asDiagonal() * centred * weights.asDiagonal();
+
+    const Eigen::SelfAdjointEigenSolver<Scatter> solver(normalized);
+    if(solver.info() != Eigen::Success)
+      return 0;
+    Terms v = solver.eigenvectors().col(0);
+
+    // x^T A x + 2 b^T x + c = 0, in the normalized coordinates.
+    Eigen::Matrix3d A;
+    A << v(0), v(3) * 0.5, v(4) * 0.5, v(3) * 0.5, v(1), v(5) * 0.5, v(4) * 0.5, v(5) * 0.5,
+        v(2);
+    if(A.trace() < 0.0)
+    {
+      A = -A;
+      v = -v;
+    }
+    const Eigen::Vector3d b = v.segment<3>(6) * 0.5;
+
+    const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> shape(A);
+    const Eigen::Vector3d eigenvalues = shape.eigenvalues();
+    if(!(eigenvalues(0) > 1e-9 * eigenvalues(2)))
+      return 0;
+
+    // Centre and squared size: (x - c)^T A (x - c) = k.
+    const Eigen::Vector3d center = -shape.eigenvectors()
+                                   * (shape.eigenvectors().transpose() * b)
+                                         .cwiseQuotient(eigenvalues);
+    const double k = center.dot(A * center) - v(9);
+    if(!(k > 0.0))
+      return 0;
+
+    // W = sqrt(A / k) maps the ellipsoid onto the unit sphere without rotating it.
+    const Eigen::Vector3d roots = (eigenvalues / k).cwiseSqrt();
+    const Eigen::Matrix3d W
+        = shape.eigenvectors() * roots.asDiagonal() * shape.eigenvectors().transpose();
+
+    hardIronBias = origin + centroid + center / scale;
+    softIronMatrix = W * (scale * calibrationRadius);
+    updateTransform();
+    return 1;
+  }
+
+  void applyMagnetometerCalibration(const Imu9Axis& myRawIMU)
+  {
+    const Eigen::Vector3d raw(myRawIMU.magn.x, myRawIMU.magn.y, myRawIMU.magn.z);
+    const Eigen::Vector3d calibrated = softIronMatrix * (raw - hardIronBias);
+    myCalIMU.magn.x = calibrated(0);
+    myCalIMU.magn.y = calibrated(1);
+    myCalIMU.magn.z = calibrated(2);
+  }
+
+  /**
+   * @brief Block version of applyMagnetometerCalibration(), through the fused
+   * `transform`. `in` and `out` may be the same samples, in which case only
+   * the magnetometer readings are written.
+   * @return The number of samples calibrated, the smaller of the two sizes.
+   */
+  std::size_t apply(std::span<const Imu9Axis> in, std::span<Imu9Axis> out) const
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    const bool copy = in.data() != out.data();
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      const Eigen::Vector3d calibrated
+          = transform.leftCols<3>() * Eigen::Vector3d(in[i].magn.x, in[i].magn.y, in[i].magn.z)
+            + transform.col(3);
+      if(copy)
+      {
+        out[i].accl = in[i].accl;
+        out[i].gyro = in[i].gyro;
+      }
+      out[i].magn = {calibrated(0), calibrated(1), calibrated(2)};
+    }
+    return count;
+  }
+
+  /**
+   * @brief Recompute `transform` from `softIronMatrix` and `hardIronBias`.
+   */
+  void updateTransform()
+  {
+    transform.leftCols<3>() = softIronMatrix;
+    transform.col(3) = -(softIronMatrix * hardIronBias);
+  }
+
+private:
+  static Terms terms(const Eigen::Vector3d& p)
+  {
+    Terms t;
+    t << p.x() * p.x(), p.y() * p.y(), p.z() * p.z(), p.x() * p.y(), p.x() * p.z(),
+        p.y() * p.z(), p.x(), p.y(), p.z(), 1.0;
+    return t;
+  }
+
+  // Linear map from terms(p) to terms(p - c).
+  static Scatter shift(const Eigen::Vector3d& c)
+  {
+    // Axes of the quadratic terms, in the order of terms().
+    static constexpr std::array<std::array<int, 2>, 6> axes{
+        {{0, 0}, {1, 1}, {2, 2}, {0, 1}, {0, 2}, {1, 2}}};
+
+    Scatter T = Scatter::Zero();
+    for(int row = 0; row < 6; ++row)
+    {
+      const int i = axes[row][0];
+      const int j = axes[row][1];
+      // (p_i - c_i)(p_j - c_j) = p_i p_j - c_j p_i - c_i p_j + c_i c_j
+      T(row, row) = 1.0;
+      T(row, 6 + i) -= c(j);
+      T(row, 6 + j) -= c(i);
+      T(row, 9) = c(i) * c(j);
+    }
+    for(int i = 0; i < 3; ++i)
+    {
+      T(6 + i, 6 + i) = 1.0;
+      T(6 + i, 9) = -c(i);
+    }
+    T(9, 9) = 1.0;
+    return T;
+  }
+};
+
+}
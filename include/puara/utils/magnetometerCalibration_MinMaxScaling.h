@@ -12,6 +12,8 @@
 #include <array>
 #include <cmath>
 #include <limits>
+#include <span>
+#include <vector>
 #include <puara/structs.h>
 #include <puara/utils/includeEigen.h>
 
@@ -26,6 +28,9 @@ namespace puara_gestures::utils
  * @details This implementation preserves the same public API as the desktop
  * calibration path, but avoids heavy dynamic Eigen workloads by using a
  * simplified hard-iron / soft-iron estimate and a fixed sample count.
+ * The bias and matrix are fixed-size Eigen types, so neither calibrating nor
+ * applying the calibration allocates; `apply()` calibrates a block of samples
+ * with the fused transform `m' = S m - S b`, computed once per calibration.
  *
  * Example:
  * @code{.cpp}
@@ -53,16 +58,17 @@ public:
 
   Imu9Axis myCalIMU;
   std::vector<Coord3D> rawMagData;
-  Eigen::MatrixXd softIronMatrix;
-  Eigen::VectorXd hardIronBias;
+  Eigen::Matrix3d softIronMatrix;
+  Eigen::Vector3d hardIronBias;
+  /// `[S | -S b]`, the calibration as one affine transform, used by `apply()`.
+  /// Call `updateTransform()` after setting `softIronMatrix` or `hardIronBias`.
+  Eigen::Matrix<double, 3, 4> transform;
   bool enforceRadialEqualization = false;
   double calibrationRadius = 1.0;
   size_t maxSamples = MaxSamples;
 
   Embedded_Magnetometer_Calibration()
       : rawMagData()
-      , softIronMatrix(3, 3)
-      , hardIronBias(3)
       , enforceRadialEqualization(false)
       , calibrationRadius(1.0)
       , maxSamples(MaxSamples)
@@ -70,12 +76,11 @@ public:
     rawMagData.reserve(maxSamples);
     softIronMatrix.setIdentity();
     hardIronBias.setZero();
+    updateTransform();
   }
 
   explicit Embedded_Magnetometer_Calibration(size_t sampleCount)
       : rawMagData()
-      , softIronMatrix(3, 3)
-      , hardIronBias(3)
       , enforceRadialEqualization(false)
       , calibrationRadius(1.0)
       , maxSamples(sampleCount > 0 ? sampleCount : 1)
@@ -83,41 +88,48 @@ public:
     rawMagData.reserve(maxSamples);
     softIronMatrix.setIdentity();
     hardIronBias.setZero();
+    updateTransform();
   }
 
   void applyMagnetometerCalibration(const Imu9Axis& myRawIMU)
   {
-    myCalIMU.magn.x = softIronMatrix(0, 0) * (myRawIMU.magn.x - hardIronBias(0))
-                      + softIronMatrix(0, 1) * (myRawIMU.magn.y - hardIronBias(1))
-                      + softIronMatrix(0, 2) * (myRawIMU.magn.z - hardIronBias(2));
-
-    myCalIMU.magn.y = softIronMatrix(1, 0) * (myRawIMU.magn.x - hardIronBias(0))
-                      + softIronMatrix(1, 1) * (myRawIMU.magn.y - hardIronBias(1))
-                      + softIronMatrix(1, 2) * (myRawIMU.magn.z - hardIronBias(2));
-
-    myCalIMU.magn.z = softIronMatrix(2, 0) * (myRawIMU.magn.x - hardIronBias(0))
-                      + softIronMatrix(2, 1) * (myRawIMU.magn.y - hardIronBias(1))
-                      + softIronMatrix(2, 2) * (myRawIMU.magn.z - hardIronBias(2));
+    myCalIMU.magn = equalize(softIronMatrix * (toVector(myRawIMU.magn) - hardIronBias));
+  }
 
-    // Optional radial equalization to enforce a consistent magnitude across orientations
-    // based off calibrationRadius.
-    if(enforceRadialEqualization)
+  /**
+   * @brief Block version of applyMagnetometerCalibration(): out[i] receives
+   * in[i] with its magnetometer reading calibrated; `myCalIMU` is not touched.
+   * `in` and `out` may be the same samples, in which case only the
+   * magnetometer readings are written.
+   *
+   * Each sample costs a single affine transform through `transform`. Nothing
+   * is allocated.
+   * @return The number of samples calibrated, the smaller of the two sizes.
+   */
+  std::size_t apply(std::span<const Imu9Axis> in, std::span<Imu9Axis> out) const
+  {
+    const std::size_t count = std::min(in.size(), out.size());
+    const bool copy = in.data() != out.data();
+    for(std::size_t i = 0; i < count; ++i)
     {
-      Eigen::Vector3d calibrated{
-          myCalIMU.magn.x,
-          myCalIMU.magn.y,
-          myCalIMU.magn.z,
-      };
-      double r = calibrated.norm();
-      if(r > std::numeric_limits<double>::epsilon())
+      const Eigen::Vector3d raw = toVector(in[i].magn);
+      if(copy)
       {
-        double scale = calibrationRadius / r;
-        calibrated *= scale;
-        myCalIMU.magn.x = calibrated(0);
-        myCalIMU.magn.y = calibrated(1);
-        myCalIMU.magn.z = calibrated(2);
+        out[i].accl = in[i].accl;
+        out[i].gyro = in[i].gyro;
       }
+      out[i].magn = equalize(transform.leftCols<3>() * raw + transform.col(3));
     }
+    return count;
+  }
+
+  /**
+   * @brief Recompute `transform` from `softIronMatrix` and `hardIronBias`.
+   */
+  void updateTransform()
+  {
+    transform.leftCols<3>() = softIronMatrix;
+    transform.col(3) = -(softIronMatrix * hardIronBias);
   }
 
   int generateMagnetometerMatrices(const Coord3D* samples, size_t count)
@@ -174,12 +186,31 @@ public:
     soft *= calibrationRadius / meanRadius;
     hardIronBias = bias;
     softIronMatrix = soft;
+    updateTransform();
 
     enforceRadialEqualization = true;
 
     return 1;
   }
 
+private:
+  static Eigen::Vector3d toVector(const Coord3D& c) { return {c.x, c.y, c.z}; }
+
+  // Optional radial equalization to enforce a consistent magnitude across
+  // orientations based off calibrationRadius.
+  Coord3D equalize(const Eigen::Vector3d& calibrated) const
+  {
+    if(enforceRadialEqualization)
+    {
+      const double r = calibrated.norm();
+      if(r > std::numeric_limits<double>::epsilon())
+      {
+        const Eigen::Vector3d scaled = calibrated * (calibrationRadius / r);
+        return {scaled(0), scaled(1), scaled(2)};
+      }
+    }
+    return {calibrated(0), calibrated(1), calibrated(2)};
+  }
 };
 
 }
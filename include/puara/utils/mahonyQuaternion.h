@@ -6,13 +6,17 @@
 */
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <puara/structs.h>
 #include <puara/utils/chrono.h>
+#include <puara/utils/fastmath.h>
+#include <span>
 
 /**
- * @class MahonyQuaternionFilter 
+ * @class MahonyQuaternionFilterT
  * @brief MahonyQuaternionFilter for 9-DoF IMU orientation estimation.
  *
  * @details A lightweight Mahony AHRS filter for 9-DoF IMU data. This 
@@ -22,10 +26,17 @@
  *
  * @ingroup puara_gestures_utils
  * Usage:
- * @li The class stores orientation as `puara_gestures::Quaternion`.
- * @li Input data is accepted through `puara_gestures::Imu9Axis`.
+ * @li The class stores orientation as `puara_gestures::QuaternionT<T>`.
+ * @li Input data is accepted through `puara_gestures::Imu9AxisT<T>`.
+ * @li `MahonyQuaternionFilter` is the double-precision filter; `MahonyQuaternionFilterT<float>`
+ *     keeps the whole update in single precision for targets without a double FPU.
+ *     Convert samples with `static_cast<Imu9AxisT<float>>(imu)`.
  * @li Gyroscope values are assumed to be in radians/sec by default.
  * @li Use `gyroDegrees = true` when gyro values are in degrees/sec.
+ * @li `Math` selects the square root and Euler angle functions. With
+ *     `fastmath::FastMath`, `getEuler*()` use polynomial `atan2`/`asin`;
+ *     `fastmath::FastMathNoHardwareSqrt` also approximates the normalization,
+ *     which only pays off without a hardware square root (see fastmath.h).
  *
  * Example:
  * @code{.cpp}
@@ -46,52 +57,53 @@
 
 namespace puara_gestures {
 
-struct MahonyQuaternionFilter {
+template <typename T = double, typename Math = fastmath::StdMath>
+struct MahonyQuaternionFilterT {
     // Kp and Ki are the proportional and integral gains for the Mahony AHRS.
     // Kp controls fast correction from accelerometer/magnetometer error.
     // Ki accumulates slow gyroscope bias drift correction over time.
-    double twoKp;
-    double twoKi;
+    T twoKp;
+    T twoKi;
 
-    Quaternion quaternion;
-    Quaternion integralFB;
+    QuaternionT<T> quaternion;
+    QuaternionT<T> integralFB;
     uint64_t lastUpdateMicros = 0;
 
-    explicit MahonyQuaternionFilter(double kp = 1.0, double ki = 0.0)
-        : twoKp(2.0 * kp)
-        , twoKi(2.0 * ki)
-        , quaternion{1.0, 0.0, 0.0, 0.0}
-        , integralFB{0.0, 0.0, 0.0, 0.0}
+    explicit MahonyQuaternionFilterT(T kp = T(1.0), T ki = T(0.0))
+        : twoKp(T(2.0) * kp)
+        , twoKi(T(2.0) * ki)
+        , quaternion{T(1.0), T(0.0), T(0.0), T(0.0)}
+        , integralFB{T(0.0), T(0.0), T(0.0), T(0.0)}
         , lastUpdateMicros(0)
     {
     }
 
     void reset() {
-        quaternion = {1.0, 0.0, 0.0, 0.0};
-        integralFB = {0.0, 0.0, 0.0, 0.0};
+        quaternion = {T(1.0), T(0.0), T(0.0), T(0.0)};
+        integralFB = {T(0.0), T(0.0), T(0.0), T(0.0)};
         lastUpdateMicros = 0;
     }
 
-    bool update(const Imu9Axis& imu, bool gyroDegrees = false) {
+    bool update(const Imu9AxisT<T>& imu, bool gyroDegrees = false) {
         return updateWithTimestamp(imu, utils::getCurrentTimeMicroseconds(), gyroDegrees);
     }
 
-    const Quaternion& getQuaternion() const {
+    const QuaternionT<T>& getQuaternion() const {
         return quaternion;
     }
 
-    void getEulerRadians(double& roll, double& pitch, double& yaw) const {
-        const double w = quaternion.w;
-        const double x = quaternion.x;
-        const double y = quaternion.y;
-        const double z = quaternion.z;
+    void getEulerRadians(T& roll, T& pitch, T& yaw) const {
+        const T w = quaternion.w;
+        const T x = quaternion.x;
+        const T y = quaternion.y;
+        const T z = quaternion.z;
 
-        roll = std::atan2(2.0 * (w * x + y * z), 1.0 - 2.0 * (x * x + y * y));
-        pitch = std::asin(clamp(2.0 * (w * y - z * x), -1.0, 1.0));
-        yaw = std::atan2(2.0 * (w * z + x * y), 1.0 - 2.0 * (y * y + z * z));
+        roll = Math::atan2(T(2.0) * (w * x + y * z), T(1.0) - T(2.0) * (x * x + y * y));
+        pitch = Math::asin(clamp(T(2.0) * (w * y - z * x), -T(1.0), T(1.0)));
+        yaw = Math::atan2(T(2.0) * (w * z + x * y), T(1.0) - T(2.0) * (y * y + z * z));
     }
 
-    void getEulerDegrees(double& roll, double& pitch, double& yaw) const {
+    void getEulerDegrees(T& roll, T& pitch, T& yaw) const {
         getEulerRadians(roll, pitch, yaw);
         roll *= RadToDeg;
         pitch *= RadToDeg;
@@ -100,7 +112,7 @@ struct MahonyQuaternionFilter {
 
     // updateWithTimestamp allows the caller to provide a synthetic timestamp for testing
     // but user code will typically call update() with real-time data which in turn calls this function.
-    bool updateWithTimestamp(const Imu9Axis& imu, uint64_t currentMicros, bool gyroDegrees) {
+    bool updateWithTimestamp(const Imu9AxisT<T>& imu, uint64_t currentMicros, bool gyroDegrees) {
         if (currentMicros == 0) {
             return false;
         }
@@ -109,16 +121,31 @@ struct MahonyQuaternionFilter {
             return false;
         }
 
-        double deltatSeconds = double(currentMicros - lastUpdateMicros) * 1.0e-6;
+        const T deltatSeconds = T(double(currentMicros - lastUpdateMicros) * 1.0e-6);
         lastUpdateMicros = currentMicros;
         return updateInternal(imu, deltatSeconds, gyroDegrees);
     }
 
+    // Block version of updateWithTimestamp for recorded sessions or drained sensor FIFOs:
+    // out[i] receives the orientation after imu[i] at micros[i]. Returns the number of
+    // samples processed, the smallest of the three sizes.
+    std::size_t updateWithTimestamp(std::span<const Imu9AxisT<T>> imu,
+                                    std::span<const uint64_t> micros,
+                                    std::span<QuaternionT<T>> out,
+                                    bool gyroDegrees = false) {
+        const std::size_t count = std::min({imu.size(), micros.size(), out.size()});
+        for (std::size_t i = 0; i < count; ++i) {
+            updateWithTimestamp(imu[i], micros[i], gyroDegrees);
+            out[i] = quaternion;
+        }
+        return count;
+    }
+
 private:
-    bool updateInternal(const Imu9Axis& imu, double deltatSeconds, bool gyroDegrees) {
-        double gx = imu.gyro.x;
-        double gy = imu.gyro.y;
-        double gz = imu.gyro.z;
+    bool updateInternal(const Imu9AxisT<T>& imu, T deltatSeconds, bool gyroDegrees) {
+        T gx = imu.gyro.x;
+        T gy = imu.gyro.y;
+        T gz = imu.gyro.z;
         if (gyroDegrees) {
             gx *= DegToRad;
             gy *= DegToRad;
@@ -131,37 +158,37 @@ private:
                                 deltatSeconds);
     }
 
-    bool updateQuaternion(double gx, double gy, double gz,
-                          double ax, double ay, double az,
-                          double mx, double my, double mz,
-                          double deltat) {
-        if (deltat <= 0.0) {
+    bool updateQuaternion(T gx, T gy, T gz,
+                          T ax, T ay, T az,
+                          T mx, T my, T mz,
+                          T deltat) {
+        if (deltat <= T(0.0)) {
             return false;
         }
 
         // Current quaternion state is the prior orientation estimate.
-        double q0 = quaternion.w;
-        double q1 = quaternion.x;
-        double q2 = quaternion.y;
-        double q3 = quaternion.z;
-
-        double recipNorm;
-        double vx, vy, vz;
-        double wx, wy, wz;
-        double ex, ey, ez;
-        double q0q0 = q0 * q0;
-        double q0q1 = q0 * q1;
-        double q0q2 = q0 * q2;
-        double q0q3 = q0 * q3;
-        double q1q1 = q1 * q1;
-        double q1q2 = q1 * q2;
-        double q1q3 = q1 * q3;
-        double q2q2 = q2 * q2;
-        double q2q3 = q2 * q3;
-        double q3q3 = q3 * q3;
-
-        double accelNormSq = ax * ax + ay * ay + az * az;
-         if (accelNormSq <= 0.0) {
+        T q0 = quaternion.w;
+        T q1 = quaternion.x;
+        T q2 = quaternion.y;
+        T q3 = quaternion.z;
+
+        T recipNorm;
+        T vx, vy, vz;
+        T wx, wy, wz;
+        T ex, ey, ez;
+        T q0q0 = q0 * q0;
+        T q0q1 = q0 * q1;
+        T q0q2 = q0 * q2;
+        T q0q3 = q0 * q3;
+        T q1q1 = q1 * q1;
+        T q1q2 = q1 * q2;
+        T q1q3 = q1 * q3;
+        T q2q2 = q2 * q2;
+        T q2q3 = q2 * q3;
+        T q3q3 = q3 * q3;
+
+        T accelNormSq = ax * ax + ay * ay + az * az;
+         if (accelNormSq <= T(0.0)) {
              return false;
          }
         recipNorm = invSqrt(accelNormSq);
@@ -169,7 +196,7 @@ private:
         ay *= recipNorm;
         az *= recipNorm;
 
-        if (mx == 0.0 && my == 0.0 && mz == 0.0) {
+        if (mx == T(0.0) && my == T(0.0) && mz == T(0.0)) {
             // Use the IMU-only path when magnetometer data is unavailable.
             return updateQuaternionIMU(gx, gy, gz, ax, ay, az, deltat);
         }
@@ -179,23 +206,23 @@ private:
         my *= recipNorm;
         mz *= recipNorm;
 
-        double _2q0mx = 2.0 * q0 * mx;
-        double _2q0my = 2.0 * q0 * my;
-        double _2q0mz = 2.0 * q0 * mz;
-        double _2q1mx = 2.0 * q1 * mx;
-        double hx = mx * (0.5 - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2);
-        double hy = mx * (q1q2 + q0q3) + my * (0.5 - q1q1 - q3q3) + mz * (q2q3 - q0q1);
-        double bx = std::sqrt(hx * hx + hy * hy);
-        double bz = mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5 - q1q1 - q2q2);
+        T _2q0mx = T(2.0) * q0 * mx;
+        T _2q0my = T(2.0) * q0 * my;
+        T _2q0mz = T(2.0) * q0 * mz;
+        T _2q1mx = T(2.0) * q1 * mx;
+        T hx = mx * (T(0.5) - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2);
+        T hy = mx * (q1q2 + q0q3) + my * (T(0.5) - q1q1 - q3q3) + mz * (q2q3 - q0q1);
+        T bx = std::sqrt(hx * hx + hy * hy);
+        T bz = mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (T(0.5) - q1q1 - q2q2);
 
         // Compute the expected direction of gravity and magnetic flux in body frame
         // as predicted by the current quaternion estimate.
-        vx = 2.0 * (q1q3 - q0q2);
-        vy = 2.0 * (q0q1 + q2q3);
+        vx = T(2.0) * (q1q3 - q0q2);
+        vy = T(2.0) * (q0q1 + q2q3);
         vz = q0q0 - q1q1 - q2q2 + q3q3;
-        wx = 2.0 * bx * (0.5 - q2q2 - q3q3) + 2.0 * bz * (q1q3 - q0q2);
-        wy = 2.0 * bx * (q1q2 - q0q3) + 2.0 * bz * (q0q1 + q2q3);
-        wz = 2.0 * bx * (q0q2 + q1q3) + 2.0 * bz * (0.5 - q1q1 - q2q2);
+        wx = T(2.0) * bx * (T(0.5) - q2q2 - q3q3) + T(2.0) * bz * (q1q3 - q0q2);
+        wy = T(2.0) * bx * (q1q2 - q0q3) + T(2.0) * bz * (q0q1 + q2q3);
+        wz = T(2.0) * bx * (q0q2 + q1q3) + T(2.0) * bz * (T(0.5) - q1q1 - q2q2);
 
         // Compute the error between measured and estimated directions.
         // The cross products produce a corrective feedback vector in body frame.
@@ -203,7 +230,7 @@ private:
         ey = (az * vx - ax * vz) + (mz * wx - mx * wz);
         ez = (ax * vy - ay * vx) + (mx * wy - my * wx);
 
-        if (twoKi > 0.0) {
+        if (twoKi > T(0.0)) {
             // Integral feedback compensates for long-term gyro drift.
             integralFB.x += twoKi * ex * deltat;
             integralFB.y += twoKi * ey * deltat;
@@ -212,17 +239,17 @@ private:
             gy += integralFB.y;
             gz += integralFB.z;
         } else {
-            integralFB = {0.0, 0.0, 0.0, 0.0};
+            integralFB = {T(0.0), T(0.0), T(0.0), T(0.0)};
         }
 
         gx += twoKp * ex;
         gy += twoKp * ey;
         gz += twoKp * ez;
 
-        double qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
-        double qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
-        double qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
-        double qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+        T qDot1 = T(0.5) * (-q1 * gx - q2 * gy - q3 * gz);
+        T qDot2 = T(0.5) * (q0 * gx + q2 * gz - q3 * gy);
+        T qDot3 = T(0.5) * (q0 * gy - q1 * gz + q3 * gx);
+        T qDot4 = T(0.5) * (q0 * gz + q1 * gy - q2 * gx);
 
         q0 += qDot1 * deltat;
         q1 += qDot2 * deltat;
@@ -238,28 +265,28 @@ private:
         return true;
     }
 
-    bool updateQuaternionIMU(double gx, double gy, double gz,
-                             double ax, double ay, double az,
-                             double deltat) {
-        if (deltat <= 0.0) {
+    bool updateQuaternionIMU(T gx, T gy, T gz,
+                             T ax, T ay, T az,
+                             T deltat) {
+        if (deltat <= T(0.0)) {
             return false;
         }
 
-        double q0 = quaternion.w;
-        double q1 = quaternion.x;
-        double q2 = quaternion.y;
-        double q3 = quaternion.z;
+        T q0 = quaternion.w;
+        T q1 = quaternion.x;
+        T q2 = quaternion.y;
+        T q3 = quaternion.z;
 
-        double recipNorm;
-        double vx = 2.0 * (q1 * q3 - q0 * q2);
-        double vy = 2.0 * (q0 * q1 + q2 * q3);
-        double vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+        T recipNorm;
+        T vx = T(2.0) * (q1 * q3 - q0 * q2);
+        T vy = T(2.0) * (q0 * q1 + q2 * q3);
+        T vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
 
-        double ex = (ay * vz - az * vy);
-        double ey = (az * vx - ax * vz);
-        double ez = (ax * vy - ay * vx);
+        T ex = (ay * vz - az * vy);
+        T ey = (az * vx - ax * vz);
+        T ez = (ax * vy - ay * vx);
 
-        if (twoKi > 0.0) {
+        if (twoKi > T(0.0)) {
             // Integral feedback compensates for long-term gyro drift.
             integralFB.x += twoKi * ex * deltat;
             integralFB.y += twoKi * ey * deltat;
@@ -268,17 +295,17 @@ private:
             gy += integralFB.y;
             gz += integralFB.z;
         } else {
-            integralFB = {0.0, 0.0, 0.0, 0.0};
+            integralFB = {T(0.0), T(0.0), T(0.0), T(0.0)};
         }
 
         gx += twoKp * ex;
         gy += twoKp * ey;
         gz += twoKp * ez;
 
-        double qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
-        double qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
-        double qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
-        double qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+        T qDot1 = T(0.5) * (-q1 * gx - q2 * gy - q3 * gz);
+        T qDot2 = T(0.5) * (q0 * gx + q2 * gz - q3 * gy);
+        T qDot3 = T(0.5) * (q0 * gy - q1 * gz + q3 * gx);
+        T qDot4 = T(0.5) * (q0 * gz + q1 * gy - q2 * gx);
 
         q0 += qDot1 * deltat;
         q1 += qDot2 * deltat;
@@ -294,17 +321,19 @@ private:
         return true;
     }
 
-    static double clamp(double value, double lo, double hi) {
+    static T clamp(T value, T lo, T hi) {
         return value < lo ? lo : (value > hi ? hi : value);
     }
 
-    static double invSqrt(double value) {
-        return 1.0 / std::sqrt(value);
+    static T invSqrt(T value) {
+        return Math::rsqrt(value);
     }
 
-    static constexpr double DegToRad = 0.017453292519943295;
-    static constexpr double RadToDeg = 57.29577951308232;
+    static constexpr T DegToRad = T(0.017453292519943295);
+    static constexpr T RadToDeg = T(57.29577951308232);
 };
 
+using MahonyQuaternionFilter = MahonyQuaternionFilterT<double>;
+
 } // namespace puara_gestures
 
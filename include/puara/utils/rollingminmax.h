@@ -11,18 +11,58 @@
 #include <puara/structs.h>
 #include <puara/utils/circularbuffer.h>
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
 namespace puara_gestures::utils
 {
 
-template <typename T>
+/**
+ * @brief Strategy used by RollingMinMax to keep track of the window extrema.
+ */
+enum class RollingMinMaxMode
+{
+  /**
+   * @brief Rescan the whole window on every update.
+   *
+   * Costs O(window) per sample. Cheap for the short windows used by `Jab`.
+   */
+  Rescan,
+
+  /**
+   * @brief Monotonic wedge (Lemire) deques.
+   *
+   * Costs O(1) amortized per sample regardless of the window length, at the
+   * price of two extra index/value arrays sized to the window.
+   */
+  MonotonicWedge
+};
+
+template <typename T, std::size_t N = 0>
 /**
  * @brief Tracks the min and max values over the last N updates.
  *
- * @details RollingMinMax stores at most `buffer_size` values and recomputes the
- * minimum and maximum each time a new value is added.
+ * @details RollingMinMax stores at most `buffer_size` values and reports the
+ * minimum and maximum of that window each time a new value is added.
  * This is useful for sliding-window feature extraction in gesture or
  * sensor processing, where you want the current range of recent values.
  *
+ * The default `RollingMinMaxMode::Rescan` mode recomputes the range from the
+ * stored history on every update. For long windows, pass
+ * `RollingMinMaxMode::MonotonicWedge` to keep two monotonic deques instead
+ * (Lemire's streaming min/max algorithm): every sample is pushed and popped
+ * at most once, so the per-sample cost no longer depends on the window
+ * length. Both modes return identical results.
+ *
+ * When the window length is known at compile time, pass it as `N`: the
+ * history and the wedges then live in inline arrays (see
+ * `CircularBuffer<T, N>`) and the tracker never allocates. Storage for both
+ * modes is embedded in that case, whichever one is selected.
+ *
  * Example:
  * @code{.cpp}
  *   puara_gestures::utils::RollingMinMax<int> window(3);
@@ -32,14 +72,34 @@ template <typename T>
  *
  *   // range.min == 4, range.max == 10
  *   // window.current_value holds the same range after the last update
+ *
+ *   // Same results, O(1) amortized per sample for a 1000-sample window.
+ *   puara_gestures::utils::RollingMinMax<double> longWindow(
+ *       1000, puara_gestures::utils::RollingMinMaxMode::MonotonicWedge);
  * @endcode
  *
  */
 class RollingMinMax
 {
 public:
-  explicit RollingMinMax(size_t buffer_size = 10)
-      : buf(buffer_size)
+  explicit RollingMinMax(
+      size_t buffer_size = 10, RollingMinMaxMode mode = RollingMinMaxMode::Rescan)
+    requires(N == 0)
+      : buf(mode == RollingMinMaxMode::Rescan ? buffer_size : 0)
+      , minWedge(mode == RollingMinMaxMode::MonotonicWedge ? windowFor(buffer_size) : 0)
+      , maxWedge(mode == RollingMinMaxMode::MonotonicWedge ? windowFor(buffer_size) : 0)
+      , window(windowFor(buffer_size))
+      , updateMode(mode)
+  {
+  }
+
+  /**
+   * @brief Construct a tracker over a compile-time window of `N` samples.
+   */
+  explicit RollingMinMax(RollingMinMaxMode mode = RollingMinMaxMode::Rescan)
+    requires(N > 0)
+      : window(N)
+      , updateMode(mode)
   {
   }
 
@@ -58,21 +118,134 @@ public:
    */
   puara_gestures::MinMax<T> update(T value)
   {
+    if(updateMode == RollingMinMaxMode::MonotonicWedge)
+    {
+      current_value.min = minWedge.push(value, sampleIndex, window);
+      current_value.max = maxWedge.push(value, sampleIndex, window);
+      ++sampleIndex;
+      return current_value;
+    }
+
     puara_gestures::MinMax<T> ret{.min = value, .max = value};
-    buf.add(value);
-    for (const T sample : buf.buffer)
+    if constexpr(N == 0)
+    {
+      // A runtime window is a plain ring over `buf`; the order of the stored
+      // samples does not matter for their range.
+      if(!buf.empty())
+      {
+        buf[bufHead] = value;
+        bufHead = (bufHead + 1 == buf.size()) ? 0 : bufHead + 1;
+        bufCount = std::min(bufCount + 1, buf.size());
+      }
+      for(std::size_t i = 0; i < bufCount; ++i)
+        include(ret, buf[i]);
+    }
+    else
     {
-      if (sample < ret.min)
-        ret.min = sample;
-      if (sample > ret.max)
-        ret.max = sample;
+      buf.add(value);
+      for(auto segment : buf.segments())
+        for(const T sample : segment)
+          include(ret, sample);
     }
     current_value = ret;
     return ret;
   }
 
+  /**
+   * @brief Get the strategy selected at construction.
+   */
+  RollingMinMaxMode mode() const { return updateMode; }
+
 private:
-  CircularBuffer<T> buf;
+  // An empty window still reports the latest sample, like a window of one.
+  static std::size_t windowFor(std::size_t buffer_size)
+  {
+    return buffer_size > 0 ? buffer_size : 1;
+  }
+
+  static void include(puara_gestures::MinMax<T>& range, T sample)
+  {
+    if (sample < range.min)
+      range.min = sample;
+    if (sample > range.max)
+      range.max = sample;
+  }
+
+  /**
+   * @brief Fixed-capacity deque of samples kept in monotonic order.
+   *
+   * With `Before = std::less`, values increase from front to back and the
+   * front is the window minimum; with `std::greater` the front is the maximum.
+   * Storage is allocated once (or inline when `N > 0`), so `push()` never
+   * touches the heap.
+   */
+  template <typename Before>
+  class MonotonicWedge
+  {
+  public:
+    MonotonicWedge() = default;
+
+    explicit MonotonicWedge(std::size_t capacity)
+        : entries(capacity)
+    {
+    }
+
+    /**
+     * @brief Push a sample and return the extremum of the current window.
+     *
+     * @param value New sample.
+     * @param index Running sample index; unsigned wrap-around is harmless.
+     * @param window Number of samples covered by the window.
+     */
+    T push(T value, std::size_t index, std::size_t window)
+    {
+      // Drop the front entry once it slides out of the window.
+      if(count > 0 && index - entries[head].index >= window)
+      {
+        head = next(head);
+        --count;
+      }
+
+      // Entries that the new sample dominates can never be the extremum again.
+      while(count > 0 && !Before{}(entries[slot(count - 1)].value, value))
+        --count;
+
+      entries[slot(count)] = Entry{value, index};
+      ++count;
+      return entries[head].value;
+    }
+
+  private:
+    struct Entry
+    {
+      T value;
+      std::size_t index;
+    };
+
+    std::size_t next(std::size_t position) const
+    {
+      return (position + 1 == entries.size()) ? 0 : position + 1;
+    }
+
+    std::size_t slot(std::size_t offset) const
+    {
+      const std::size_t position = head + offset;
+      return (position >= entries.size()) ? position - entries.size() : position;
+    }
+
+    std::conditional_t<N == 0, std::vector<Entry>, std::array<Entry, N>> entries{};
+    std::size_t head = 0;
+    std::size_t count = 0;
+  };
+
+  std::conditional_t<N == 0, std::vector<T>, CircularBuffer<T, N>> buf;
+  std::size_t bufHead = 0;  // N == 0 only
+  std::size_t bufCount = 0; // N == 0 only
+  MonotonicWedge<std::less<T>> minWedge;
+  MonotonicWedge<std::greater<T>> maxWedge;
+  std::size_t window;
+  std::size_t sampleIndex = 0;
+  RollingMinMaxMode updateMode;
 };
 
-}
\ No newline at end of file
+}
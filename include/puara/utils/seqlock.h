@@ -0,0 +1,153 @@
+/**
+* @file seqlock.h
+* @brief Versioned value with one writer and any number of lock-free readers.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+* @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace puara_gestures::utils
+{
+/**
+ * @class Seqlock
+ * @brief Publishes snapshots of a descriptor's output to many reader threads.
+ *
+ * @details
+ * The writer (the thread updating the descriptor) never waits: `write()`
+ * marks the value as changing by making the sequence number odd, stores it,
+ * and makes the sequence even again. A reader copies the value and keeps the
+ * copy only if the sequence was even and unchanged around it, so it always
+ * gets one complete `write()`; otherwise it retries. Readers do not write
+ * anything shared, so any number of them (render, OSC, logging threads) can
+ * read at once without slowing the writer down.
+ *
+ * The value is stored as atomic words, so the concurrent copies are
+ * well-defined (and clean under ThreadSanitizer) rather than a benign race.
+ * This is why `T` has to be trivially copyable: output structs such as
+ * `Coord3D`, `ButtonState` or `TouchArrayState` are.
+ *
+ * Compared to `TripleBuffer`, a seqlock serves any number of readers, but a
+ * reader may have to retry while a write is in progress.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::utils::Seqlock<puara_gestures::ButtonState> buttonOutput;
+ *
+ * // 1 kHz update thread
+ * button.update(digitalRead(BUTTON_PIN));
+ * buttonOutput.write(button.state());
+ *
+ * // any other thread
+ * puara_gestures::ButtonState state = buttonOutput.read();
+ * @endcode
+ *
+ * @tparam T Trivially copyable value type.
+ */
+template <typename T>
+class Seqlock
+{
+  static_assert(std::is_trivially_copyable_v<T>, "Seqlock needs a trivially copyable type");
+
+public:
+  /**
+   * @param initial Value read before the first `write()`, at version 0.
+   */
+  explicit Seqlock(const T& initial = T{})
+  {
+    uint64_t buffer[words]{};
+    std::memcpy(buffer, &initial, sizeof(T));
+    for(std::size_t i = 0; i < words; ++i)
+      data[i].store(buffer[i], std::memory_order_relaxed);
+  }
+
+  Seqlock(const Seqlock&) = delete;
+  Seqlock& operator=(const Seqlock&) = delete;
+
+  /**
+   * @brief Publish a new value. Single writer.
+   */
+  void write(const T& value)
+  {
+    uint64_t buffer[words]{};
+    std::memcpy(buffer, &value, sizeof(T));
+    const uint64_t s = sequence.load(std::memory_order_relaxed);
+    sequence.store(s + 1, std::memory_order_relaxed);
+    // Release stores: a reader that sees any new word also sees the odd
+    // sequence stored before it.
+    for(std::size_t i = 0; i < words; ++i)
+      data[i].store(buffer[i], std::memory_order_release);
+    sequence.store(s + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copy the value if no write is in progress. Any thread.
+   * @param out Receives the value when the read succeeds.
+   * @return false, leaving `out` unchanged, if a write overlapped the copy.
+   */
+  bool tryRead(T& out) const
+  {
+    uint64_t version;
+    return tryRead(out, version);
+  }
+
+  /**
+   * @brief Copy the latest value, retrying while a write is in progress.
+   * Any thread.
+   */
+  T read() const
+  {
+    T out;
+    read(out);
+    return out;
+  }
+
+  /**
+   * @brief Copy the latest value and tell which `write()` it came from.
+   * Any thread.
+   * @return The version of the value copied to `out` (see `version()`).
+   */
+  uint64_t read(T& out) const
+  {
+    uint64_t version;
+    for(int attempt = 0; !tryRead(out, version); ++attempt)
+      if(attempt >= 16)
+        std::this_thread::yield();
+    return version;
+  }
+
+  /**
+   * @brief Number of values written so far. A reader can compare it with
+   * the version returned by its last `read()` to skip unchanged values.
+   */
+  uint64_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+  bool tryRead(T& out, uint64_t& version) const
+  {
+    const uint64_t before = sequence.load(std::memory_order_acquire);
+    if(before & 1)
+      return false;
+    uint64_t buffer[words];
+    for(std::size_t i = 0; i < words; ++i)
+      buffer[i] = data[i].load(std::memory_order_acquire);
+    if(sequence.load(std::memory_order_relaxed) != before)
+      return false;
+    std::memcpy(&out, buffer, sizeof(T));
+    version = before / 2;
+    return true;
+  }
+
+  static constexpr std::size_t words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  alignas(64) std::atomic<uint64_t> sequence{0};
+  std::atomic<uint64_t> data[words];
+};
+}
@@ -8,13 +8,50 @@
 */
 #pragma once
 
-#include <list>
-#include <numeric>
 #include <puara/structs.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
 
 namespace puara_gestures::utils
 {
+/**
+ * @brief Estimator used by Smooth to summarize the recent values.
+ */
+enum class SmoothMode
+{
+  /**
+   * @brief Arithmetic mean of the last `size` values (the default).
+   */
+  Mean,
+
+  /**
+   * @brief Exponential moving average with `alpha = 2 / (size + 1)`.
+   *
+   * Same center of mass as a `size`-sample mean, without keeping a history.
+   */
+  Exponential,
+
+  /**
+   * @brief Median of the last `size` values. Rejects isolated spikes.
+   *
+   * NaN readings rank above every number while they are in the window.
+   */
+  Median,
+
+  /**
+   * @brief Causal Savitzky–Golay filter: a least-squares quadratic fitted to
+   * the last `size` values, evaluated at the newest one.
+   *
+   * Smooths noise while following ramps and peaks with less lag than the
+   * mean. Falls back to the mean until three values are available.
+   */
+  SavitzkyGolay
+};
+
 /**
  * @class Smooth
  * @brief Simple rolling average smoother for recent numeric values.
@@ -23,6 +60,15 @@ namespace puara_gestures::utils
  * The public field `size` defines how many values are kept. When the window
  * is full, the oldest reading is dropped as a new value arrives.
  *
+ * The history is a ring buffer allocated once for `size` values, so
+ * `smooth()` does not allocate once the window is set up (changing `size`
+ * reallocates it on the next update). The running sum uses Neumaier
+ * compensation so that the mean does not drift over long sessions.
+ *
+ * Other estimators can be selected with `SmoothMode` behind the same
+ * `smooth()` call: an exponential moving average, a median, or a
+ * Savitzky–Golay quadratic fit.
+ *
  * Example:
  * @code{.cpp}
  *   // Keep a short history of 5 values and smooth noisy readings.
@@ -42,17 +88,15 @@ namespace puara_gestures::utils
  *
  *   // After five updates, the oldest samples are dropped and the average
  *   // always reflects the most recent `size` values.
+ *
+ *   // Median of the last 5 values instead of the mean.
+ *   puara_gestures::utils::Smooth despiker(5, puara_gestures::utils::SmoothMode::Median);
  * @endcode
  *
  */
 class Smooth
 {
 public:
-  /**
-   * @brief History of the most recent values.
-   */
-  std::list<double> list;
-
   /**
    * @brief Number of recent values to average.
    */
@@ -62,11 +106,13 @@ public:
    * @brief Constructor for Smooth.
    *
    * @param Size Number of previous values to include in the average.
+   * @param Mode Estimator applied to the window.
    */
-  explicit Smooth(std::size_t Size = 50)
+  explicit Smooth(std::size_t Size = 50, SmoothMode Mode = SmoothMode::Mean)
       : size(Size)
-      , sum(0.0)
+      , smoothMode(Mode)
   {
+    resizeWindow();
   }
 
   /**
@@ -74,12 +120,27 @@ public:
    */
   double smooth(double reading)
   {
+    if (smoothMode == SmoothMode::Exponential)
+      return smoothExponential(reading);
+
     updateList(reading);
-    if (list.empty())
+    if (count == 0)
     {
       return 0.0;
     }
-    return (sum / static_cast<double>(list.size()));
+
+    switch (smoothMode)
+    {
+      case SmoothMode::Median:
+        return median();
+      case SmoothMode::SavitzkyGolay:
+        if (count >= 3)
+          return savitzkyGolay();
+        break;
+      default:
+        break;
+    }
+    return mean();
   }
 
   /**
@@ -87,14 +148,29 @@ public:
    */
   void updateList(double reading)
   {
-    list.push_front(reading);
-    sum += reading;
+    if (window.size() != size)
+      resizeWindow();
+    if (size == 0)
+      return;
 
-    while (list.size() > static_cast<std::size_t>(size))
+    if (count == size)
     {
-      sum -= list.back();
-      list.pop_back();
+      const double oldest = window[head];
+      accumulate(-oldest);
+      if (smoothMode == SmoothMode::Median)
+        sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), oldest, medianOrder));
     }
+    else
+    {
+      ++count;
+    }
+
+    window[head] = reading;
+    head = (head + 1 == size) ? 0 : head + 1;
+    accumulate(reading);
+    if (smoothMode == SmoothMode::Median)
+      sorted.insert(
+          std::upper_bound(sorted.begin(), sorted.end(), reading, medianOrder), reading);
   }
 
   /**
@@ -102,12 +178,174 @@ public:
    */
   void clear()
   {
-    list.clear();
+    head = 0;
+    count = 0;
     sum = 0.0;
+    compensation = 0.0;
+    sorted.clear();
+    average = 0.0;
+    hasAverage = false;
+    weightsCount = 0;
   }
 
+  /**
+   * @brief Select another estimator. Clears the history.
+   */
+  void setMode(SmoothMode Mode)
+  {
+    smoothMode = Mode;
+    clear();
+    resizeWindow();
+  }
+
+  /**
+   * @brief Get the selected estimator.
+   */
+  SmoothMode mode() const { return smoothMode; }
+
+  /**
+   * @brief True when no value has been smoothed since construction or `clear()`.
+   */
+  bool empty() const { return count == 0 && !hasAverage; }
+
 private:
+  double smoothExponential(double reading)
+  {
+    if (size == 0)
+      return 0.0;
+    if (!hasAverage)
+    {
+      average = reading;
+      hasAverage = true;
+      return average;
+    }
+    const double alpha = 2.0 / (static_cast<double>(size) + 1.0);
+    average += alpha * (reading - average);
+    return average;
+  }
+
+  double mean() const { return (sum + compensation) / static_cast<double>(count); }
+
+  // Orders NaN after every number, so the sorted window stays ordered and
+  // the binary search in updateList() finds the expiring value (a NaN
+  // included) whatever the input.
+  static bool medianOrder(double a, double b)
+  {
+    return a < b || (!std::isnan(a) && std::isnan(b));
+  }
+
+  double median() const
+  {
+    const std::size_t mid = count / 2;
+    if (count % 2 == 1)
+      return sorted[mid];
+    return 0.5 * (sorted[mid - 1] + sorted[mid]);
+  }
+
+  double savitzkyGolay()
+  {
+    if (weightsCount != count)
+      computeWeights();
+
+    // weights[0] applies to the oldest stored value; the window is walked as
+    // two contiguous runs instead of wrapping every index.
+    const std::size_t oldest = (count == size) ? head : 0;
+    const std::size_t firstRun = std::min(count, size - oldest);
+    double result = 0.0;
+    for (std::size_t i = 0; i < firstRun; ++i)
+      result += weights[i] * window[oldest + i];
+    for (std::size_t i = firstRun; i < count; ++i)
+      result += weights[i] * window[i - firstRun];
+    return result;
+  }
+
+  /**
+   * Least-squares quadratic over x = -(count - 1) ... 0, evaluated at x = 0:
+   * the smoothed value is row 0 of (X^T X)^-1 X^T applied to the window.
+   */
+  void computeWeights()
+  {
+    double s[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const double x = static_cast<double>(i) - static_cast<double>(count - 1);
+      double p = 1.0;
+      for (double& moment : s)
+      {
+        moment += p;
+        p *= x;
+      }
+    }
+
+    // Row 0 of the inverse of the symmetric moment matrix [[s0 s1 s2][s1 s2 s3][s2 s3 s4]].
+    const double c00 = s[2] * s[4] - s[3] * s[3];
+    const double c01 = s[2] * s[3] - s[1] * s[4];
+    const double c02 = s[1] * s[3] - s[2] * s[2];
+    const double det = s[0] * c00 + s[1] * c01 + s[2] * c02;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const double x = static_cast<double>(i) - static_cast<double>(count - 1);
+      weights[i] = (c00 + c01 * x + c02 * x * x) / det;
+    }
+    weightsCount = count;
+  }
+
+  // Neumaier's variant of Kahan summation: also exact when |value| > |sum|.
+  void accumulate(double value)
+  {
+    const double total = sum + value;
+    if (std::abs(sum) >= std::abs(value))
+      compensation += (sum - total) + value;
+    else
+      compensation += (value - total) + sum;
+    sum = total;
+  }
+
+  // Allocate the window for `size` values, keeping the most recent ones.
+  void resizeWindow()
+  {
+    const std::size_t kept = std::min(count, size);
+    std::vector<double> resized(size);
+    for (std::size_t age = 0; age < kept; ++age)
+    {
+      const std::size_t position = (head + window.size() - 1 - age) % window.size();
+      resized[kept - 1 - age] = window[position];
+    }
+    window.swap(resized);
+    count = kept;
+    head = (size > 0) ? kept % size : 0;
+
+    sum = 0.0;
+    compensation = 0.0;
+    sorted.clear();
+    for (std::size_t i = 0; i < count; ++i)
+      accumulate(window[i]);
+
+    if (smoothMode == SmoothMode::Median)
+    {
+      sorted.reserve(size);
+      sorted.assign(window.begin(), window.begin() + static_cast<std::ptrdiff_t>(count));
+      std::sort(sorted.begin(), sorted.end(), medianOrder);
+    }
+    if (smoothMode == SmoothMode::SavitzkyGolay)
+      weights.resize(size);
+    weightsCount = 0;
+  }
+
+  SmoothMode smoothMode = SmoothMode::Mean;
+  std::vector<double> window;
+  std::size_t head = 0;
+  std::size_t count = 0;
   double sum = 0.0;
+  double compensation = 0.0;
+
+  std::vector<double> sorted;
+  std::vector<double> weights;
+  std::size_t weightsCount = 0;
+
+  double average = 0.0;
+  bool hasAverage = false;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,171 @@
+/**
+* @file spscRing.h
+* @brief Fixed-capacity, lock-free single-producer/single-consumer ring buffer.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+* @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+*/
+#pragma once
+
+#include <puara/structs.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+namespace puara_gestures::utils
+{
+/**
+ * @class SpscRing
+ * @brief Lock-free queue between one producer and one consumer.
+ *
+ * @details
+ * The storage is an inline array, so pushing and popping never allocate.
+ * The producer only writes `head` and the consumer only writes `tail`; each
+ * publishes its index with a release store that the other side reads with an
+ * acquire load. The queue is therefore safe to use from two threads (or from
+ * an interrupt and the main loop) without a mutex, as long as only one thread
+ * pushes and only one thread pops.
+ *
+ * When the queue is full, `push()` fails and the element is not stored: the
+ * producer is never blocked by a slow consumer. Every operation finishes in a
+ * bounded number of steps (the queue is wait-free), and each side keeps a
+ * cached copy of the other side's index so that the shared index is only
+ * read again when the cached one says the queue is full or empty.
+ *
+ * The span overloads move a whole block with one index update, which is
+ * cheaper than element by element when samples arrive in bursts.
+ *
+ * Example:
+ * @code{.cpp}
+ * puara_gestures::utils::SpscRing<int, 8> queue;
+ *
+ * // producer
+ * queue.push(42);
+ *
+ * // consumer
+ * int value;
+ * while(queue.pop(value))
+ *   handle(value);
+ * @endcode
+ *
+ * @tparam T Element type, copy-assignable.
+ * @tparam Capacity Maximum number of queued elements, a power of two.
+ */
+template <typename T, std::size_t Capacity>
+class SpscRing
+{
+  static_assert(
+      Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+      "SpscRing capacity must be a power of two");
+
+public:
+  /**
+   * @brief Maximum number of queued elements.
+   */
+  static constexpr std::size_t capacity() { return Capacity; }
+
+  /**
+   * @brief Append an element. Producer side only.
+   * @return false, without storing the element, when the queue is full.
+   */
+  bool push(const T& value)
+  {
+    const std::size_t h = head.load(std::memory_order_relaxed);
+    if(h - tailCache == Capacity)
+    {
+      tailCache = tail.load(std::memory_order_acquire);
+      if(h - tailCache == Capacity)
+        return false;
+    }
+    slots[h & (Capacity - 1)] = value;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Append as many elements of `values` as fit. Producer side only.
+   * @return Number of elements stored, from the front of `values`.
+   */
+  std::size_t push(std::span<const T> values)
+  {
+    const std::size_t h = head.load(std::memory_order_relaxed);
+    if(h - tailCache + values.size() > Capacity)
+      tailCache = tail.load(std::memory_order_acquire);
+    const std::size_t count = std::min(values.size(), Capacity - (h - tailCache));
+    for(std::size_t i = 0; i < count; ++i)
+      slots[(h + i) & (Capacity - 1)] = values[i];
+    head.store(h + count, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @brief Remove the oldest element. Consumer side only.
+   * @param value Receives the element.
+   * @return false when the queue is empty.
+   */
+  bool pop(T& value)
+  {
+    const std::size_t t = tail.load(std::memory_order_relaxed);
+    if(t == headCache)
+    {
+      headCache = head.load(std::memory_order_acquire);
+      if(t == headCache)
+        return false;
+    }
+    value = slots[t & (Capacity - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove up to `values.size()` of the oldest elements. Consumer side
+   * only.
+   * @return Number of elements written to the front of `values`.
+   */
+  std::size_t pop(std::span<T> values)
+  {
+    const std::size_t t = tail.load(std::memory_order_relaxed);
+    if(headCache - t < values.size())
+      headCache = head.load(std::memory_order_acquire);
+    const std::size_t count = std::min(values.size(), headCache - t);
+    for(std::size_t i = 0; i < count; ++i)
+      values[i] = slots[(t + i) & (Capacity - 1)];
+    tail.store(t + count, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @brief Number of queued elements. Exact from either side when the other
+   * side is idle; otherwise a snapshot.
+   */
+  std::size_t size() const
+  {
+    // tail first: head can only have moved further by the time it is read.
+    const std::size_t t = tail.load(std::memory_order_acquire);
+    return head.load(std::memory_order_acquire) - t;
+  }
+
+  bool empty() const { return size() == 0; }
+
+private:
+  std::array<T, Capacity> slots{};
+
+  // Separate cache lines, so the producer and consumer do not invalidate
+  // each other's index on every operation. Each index shares its line with
+  // its owner's cached copy of the other index.
+  alignas(64) std::atomic<std::size_t> head{0};
+  std::size_t tailCache = 0;
+  alignas(64) std::atomic<std::size_t> tail{0};
+  std::size_t headCache = 0;
+};
+
+/**
+ * @brief Queue of raw IMU samples, e.g. from a network or sensor-reading
+ * thread to the thread running the descriptors.
+ */
+template <std::size_t Capacity = 256>
+using Imu9AxisRing = SpscRing<Imu9Axis, Capacity>;
+}
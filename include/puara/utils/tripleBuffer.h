@@ -0,0 +1,106 @@
+/**
+* @file tripleBuffer.h
+* @brief Wait-free publication of the latest value from one thread to another.
+* @see https://github.com/Puara/puara-gestures
+* @author Société des Arts Technologiques (SAT) - https://sat.qc.ca
+* @author Input Devices and Music Interaction Laboratory (IDMIL) - https://www.idmil.org
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace puara_gestures::utils
+{
+/**
+ * @class TripleBuffer
+ * @brief Hands the most recent value of `T` from one writer to one reader.
+ *
+ * @details
+ * Where `SpscRing` keeps every element, a triple buffer keeps only the latest:
+ * it suits descriptor outputs that a display or network thread samples at its
+ * own rate. Three copies of `T` rotate between the writer, the reader and a
+ * shared middle slot. Publishing swaps the writer's slot with the middle one,
+ * and the reader swaps the middle slot with its own when a new value is
+ * there, each with a single atomic exchange. Neither side ever waits or
+ * retries, and the reader always sees a complete value, however large `T` is.
+ *
+ * Example:
+ * @code{.cpp}
+ * struct Outputs { puara_gestures::Coord3D shake, jab; };
+ * puara_gestures::utils::TripleBuffer<Outputs> outputs;
+ *
+ * // processing thread
+ * outputs.write({shake.current_value(), jab.current_value()});
+ *
+ * // display thread
+ * if(outputs.update())
+ *   draw(outputs.read());
+ * @endcode
+ *
+ * @tparam T Value type, copy-assignable.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+  /**
+   * @brief The writer's slot, to fill in place before `publish()`. Writer
+   * side only.
+   */
+  T& writeBuffer() { return slots[back].value; }
+
+  /**
+   * @brief Make the writer's slot the latest value. Writer side only.
+   */
+  void publish()
+  {
+    back = state.exchange(back | fresh, std::memory_order_acq_rel) & index;
+  }
+
+  /**
+   * @brief Copy `value` into the writer's slot and publish it. Writer side
+   * only.
+   */
+  void write(const T& value)
+  {
+    slots[back].value = value;
+    publish();
+  }
+
+  /**
+   * @brief Take the latest published value, if there is a new one. Reader
+   * side only.
+   * @return true when `read()` now returns a value it did not return before.
+   */
+  bool update()
+  {
+    if(!(state.load(std::memory_order_relaxed) & fresh))
+      return false;
+    front = state.exchange(front, std::memory_order_acq_rel) & index;
+    return true;
+  }
+
+  /**
+   * @brief The value taken by the last `update()`. Reader side only.
+   */
+  const T& read() const { return slots[front].value; }
+
+private:
+  static constexpr uint8_t index = 3;
+  static constexpr uint8_t fresh = 4;
+
+  // One cache line per slot, so writing one never invalidates another.
+  struct alignas(64) Slot
+  {
+    T value{};
+  };
+  Slot slots[3];
+
+  // Middle slot index, plus `fresh` when the writer published since the
+  // reader last took it.
+  alignas(64) std::atomic<uint8_t> state{1};
+  alignas(64) uint8_t back = 0;
+  alignas(64) uint8_t front = 2;
+};
+}
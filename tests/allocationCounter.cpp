@@ -0,0 +1,99 @@
+#include "allocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Global allocation functions that count every heap allocation, so that the
+// benchmarks can report allocations per sample and the tests can check that
+// a code path does not allocate. Only the counting is added; memory comes from
+// malloc/aligned_alloc as usual. Kept in its own translation unit so the
+// compiler does not inline it against the standard operator delete.
+
+namespace
+{
+std::atomic<std::size_t> allocations{0};
+
+void* allocate(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if(void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  const auto align = static_cast<std::size_t>(alignment);
+  const std::size_t rounded = ((size ? size : 1) + align - 1) / align * align;
+  if(void* p = std::aligned_alloc(align, rounded))
+    return p;
+  throw std::bad_alloc();
+}
+}
+
+std::size_t puara_tests::heapAllocationCount()
+{
+  return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+  return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+  return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return allocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
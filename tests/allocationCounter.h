@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+// Allocation counting shared by the test and benchmark executables that link
+// allocationCounter.cpp.
+
+namespace puara_tests
+{
+
+/**
+ * @brief Number of heap allocations made by the process so far.
+ *
+ * Counted by the global operator new replacements in allocationCounter.cpp,
+ * which cover the plain, array and aligned forms. Memory obtained directly
+ * from malloc (e.g. Eigen's dynamic storage) is not counted; build with
+ * `EIGEN_RUNTIME_NO_MALLOC` and `Eigen::internal::set_is_malloc_allowed()` to
+ * catch that.
+ */
+std::size_t heapAllocationCount();
+
+}
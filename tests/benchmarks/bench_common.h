@@ -0,0 +1,62 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include "allocationCounter.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+// Helpers shared by the puara_gestures_bench sources.
+
+namespace puara_bench
+{
+
+/**
+ * @brief Number of heap allocations made by the process so far.
+ *
+ * Counted by the global operator new replacements in allocationCounter.cpp.
+ */
+inline std::size_t allocationCount()
+{
+  return puara_tests::heapAllocationCount();
+}
+
+/**
+ * @brief Report the per-sample counters of a benchmark.
+ *
+ * Call after the benchmark loop. Sets `items_per_second` (samples/s), and the
+ * `time/sample` and `allocs/sample` counters.
+ *
+ * @param state The benchmark state.
+ * @param samplesPerIteration Number of samples processed by one iteration.
+ * @param allocationsBefore `allocationCount()` taken just before the loop.
+ */
+inline void reportPerSample(
+    benchmark::State& state, std::size_t samplesPerIteration,
+    std::size_t allocationsBefore)
+{
+  const auto allocations = allocationCount() - allocationsBefore;
+  const auto samples = static_cast<double>(state.iterations())
+                       * static_cast<double>(samplesPerIteration);
+
+  state.SetItemsProcessed(
+      state.iterations() * static_cast<benchmark::IterationCount>(samplesPerIteration));
+  state.counters["time/sample"] = benchmark::Counter(
+      static_cast<double>(samplesPerIteration),
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+  state.counters["allocs/sample"]
+      = samples > 0 ? static_cast<double>(allocations) / samples : 0.0;
+}
+
+/**
+ * @brief Path of a recording in `tests/data`.
+ */
+inline std::filesystem::path dataPath(std::string_view filename)
+{
+  const auto sourceDir = std::filesystem::path(__FILE__).parent_path();
+  return sourceDir.parent_path() / "data" / filename;
+}
+
+}
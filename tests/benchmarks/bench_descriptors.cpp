@@ -0,0 +1,643 @@
+#include "bench_common.h"
+
+#include <benchmark/benchmark.h>
+#include <puara/descriptors/brushRub.h>
+#include <puara/descriptors/brushRubBank.h>
+#include <puara/descriptors/button.h>
+#include <puara/descriptors/buttonBank.h>
+#include <puara/descriptors/gestureEngine.h>
+#include <puara/descriptors/jab.h>
+#include <puara/descriptors/jabBank.h>
+#include <puara/descriptors/shake.h>
+#include <puara/descriptors/shakeBank.h>
+#include <puara/descriptors/simple_tilt_roll.h>
+#include <puara/descriptors/touchArrayGestureDetector.h>
+#include <puara/utils.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace puara_gestures;
+
+// Per-sample update() calls against the block update(in, out) entry points.
+// Block sizes cover a typical sensor FIFO drain (32-256 samples).
+
+namespace
+{
+
+std::vector<Coord3D> accelBlock(std::size_t size)
+{
+  std::mt19937 rng(1234);
+  std::normal_distribution<double> dist(0.0, 4.0);
+  std::vector<Coord3D> values(size);
+  for(auto& v : values)
+    v = Coord3D{dist(rng), dist(rng), 9.81 + dist(rng)};
+  return values;
+}
+
+std::vector<Imu9Axis> imuBlock(std::size_t size)
+{
+  std::vector<Imu9Axis> values(size);
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    const double t = 0.01 * static_cast<double>(i);
+    values[i] = Imu9Axis{
+        {std::sin(t), 0.2 * std::cos(t), 9.81},
+        {10.0 * std::cos(t), 5.0, -3.0 * std::sin(t)},
+        {0.3, 0.1 * std::sin(t), 0.5}};
+  }
+  return values;
+}
+
+void blockSizes(benchmark::internal::Benchmark* b)
+{
+  b->RangeMultiplier(2)->Range(32, 256);
+}
+
+}
+
+template <typename Descriptor>
+static void BM_PerSample(benchmark::State& state)
+{
+  const auto in = accelBlock(static_cast<std::size_t>(state.range(0)));
+  Descriptor descriptor;
+  descriptor.frequency(0);
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(const auto& sample : in)
+      descriptor.update(sample);
+    benchmark::DoNotOptimize(descriptor.current_value());
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+
+template <typename Descriptor>
+static void BM_Block(benchmark::State& state)
+{
+  const auto in = accelBlock(static_cast<std::size_t>(state.range(0)));
+  std::vector<Coord3D> out(in.size());
+  Descriptor descriptor;
+  descriptor.frequency(0);
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    descriptor.update(in, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+
+BENCHMARK_TEMPLATE(BM_PerSample, Shake3D)->Apply(blockSizes);
+BENCHMARK_TEMPLATE(BM_Block, Shake3D)->Apply(blockSizes);
+
+// Jab has no integrator frequency; give it the same interface as Shake3D here.
+struct JabBench : Jab3D
+{
+  void frequency(double) { }
+};
+BENCHMARK_TEMPLATE(BM_PerSample, JabBench)->Apply(blockSizes);
+BENCHMARK_TEMPLATE(BM_Block, JabBench)->Apply(blockSizes);
+
+static void BM_TiltRollPerSample(benchmark::State& state)
+{
+  const auto in = accelBlock(static_cast<std::size_t>(state.range(0)));
+  std::vector<Simple_Orientation> out(in.size());
+  Tilt_Roll tiltRoll;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t i = 0; i < in.size(); ++i)
+    {
+      tiltRoll.update(in[i]);
+      out[i] = tiltRoll.current_value();
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+BENCHMARK(BM_TiltRollPerSample)->Apply(blockSizes);
+
+static void BM_TiltRollBlock(benchmark::State& state)
+{
+  const auto in = accelBlock(static_cast<std::size_t>(state.range(0)));
+  std::vector<Simple_Orientation> out(in.size());
+  Tilt_Roll tiltRoll;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    tiltRoll.update(in, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+BENCHMARK(BM_TiltRollBlock)->Apply(blockSizes);
+
+static void BM_ButtonPerSample(benchmark::State& state)
+{
+  std::vector<int> in(static_cast<std::size_t>(state.range(0)));
+  for(std::size_t i = 0; i < in.size(); ++i)
+    in[i] = (i / 8) % 2;
+  std::vector<ButtonState> out(in.size());
+  Button button;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t i = 0; i < in.size(); ++i)
+    {
+      button.update(in[i]);
+      out[i] = button.state();
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+BENCHMARK(BM_ButtonPerSample)->Apply(blockSizes);
+
+static void BM_ButtonBlock(benchmark::State& state)
+{
+  std::vector<int> in(static_cast<std::size_t>(state.range(0)));
+  for(std::size_t i = 0; i < in.size(); ++i)
+    in[i] = (i / 8) % 2;
+  std::vector<ButtonState> out(in.size());
+  Button button;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    button.update(in, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+BENCHMARK(BM_ButtonBlock)->Apply(blockSizes);
+
+// buttonBank.h
+// 32 buttons scanned at 1 kHz, a few of them tapped now and then: one Button
+// per input (each reading the clock) against one ButtonBank fed the scan word.
+// Each iteration is one scan.
+constexpr std::size_t kButtons = 32;
+constexpr std::size_t kButtonScans = 1024;
+
+static std::vector<uint32_t> buttonScans()
+{
+  std::vector<uint32_t> scans(kButtonScans);
+  for(std::size_t s = 0; s < kButtonScans; ++s)
+    for(std::size_t b = 0; b < kButtons; b += 5)
+      scans[s] |= uint32_t((s + 37 * b) % 300 < 40) << b;
+  return scans;
+}
+
+static void BM_ButtonPerInput(benchmark::State& state)
+{
+  const auto scans = buttonScans();
+  std::array<Button, kButtons> buttons;
+  std::size_t scan = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t b = 0; b < kButtons; ++b)
+      buttons[b].update(int((scans[scan] >> b) & 1));
+    scan = (scan + 1) % kButtonScans;
+    benchmark::DoNotOptimize(buttons.data());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_ButtonPerInput);
+
+static void BM_ButtonBank(benchmark::State& state)
+{
+  const auto scans = buttonScans();
+  ButtonBank<kButtons> bank;
+  uint64_t micros = 0;
+  std::size_t scan = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    bank.updateAt(scans[scan], micros += 1000);
+    scan = (scan + 1) % kButtonScans;
+    ButtonEvent event;
+    while(bank.events.pop(event))
+      benchmark::DoNotOptimize(event);
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_ButtonBank);
+
+template <typename Filter>
+static void BM_FilterPerSample(benchmark::State& state)
+{
+  const auto in = imuBlock(static_cast<std::size_t>(state.range(0)));
+  std::vector<Quaternion> out(in.size());
+  Filter filter;
+  uint64_t micros = 1000;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t i = 0; i < in.size(); ++i)
+    {
+      filter.updateWithTimestamp(in[i], micros += 10000, true);
+      out[i] = filter.getQuaternion();
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+
+template <typename Filter>
+static void BM_FilterBlock(benchmark::State& state)
+{
+  const auto in = imuBlock(static_cast<std::size_t>(state.range(0)));
+  std::vector<uint64_t> micros(in.size());
+  std::vector<Quaternion> out(in.size());
+  Filter filter;
+  uint64_t now = 1000;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    for(auto& t : micros)
+      t = now += 10000;
+    state.ResumeTiming();
+    filter.updateWithTimestamp(in, micros, out, true);
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+
+BENCHMARK_TEMPLATE(BM_FilterPerSample, MadgwickQuaternionFilter)->Apply(blockSizes);
+BENCHMARK_TEMPLATE(BM_FilterBlock, MadgwickQuaternionFilter)->Apply(blockSizes);
+BENCHMARK_TEMPLATE(BM_FilterPerSample, MahonyQuaternionFilter)->Apply(blockSizes);
+BENCHMARK_TEMPLATE(BM_FilterBlock, MahonyQuaternionFilter)->Apply(blockSizes);
+BENCHMARK_TEMPLATE(BM_FilterPerSample, KalmanQuaternionFilter)->Apply(blockSizes);
+BENCHMARK_TEMPLATE(BM_FilterBlock, KalmanQuaternionFilter)->Apply(blockSizes);
+
+// shakeBank.h / jabBank.h
+// One Shake3D/Jab3D per device against the structure-of-arrays banks.
+constexpr std::size_t kDevices = 64;
+
+template <typename Descriptor>
+static void BM_PerDevice(benchmark::State& state)
+{
+  const auto in = accelBlock(kDevices);
+  std::vector<Descriptor> descriptors(kDevices);
+  for(auto& descriptor : descriptors)
+    descriptor.frequency(0);
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t d = 0; d < kDevices; ++d)
+      descriptors[d].update(in[d]);
+    benchmark::DoNotOptimize(descriptors.data());
+  }
+  puara_bench::reportPerSample(state, kDevices, allocations);
+}
+BENCHMARK_TEMPLATE(BM_PerDevice, Shake3D);
+BENCHMARK_TEMPLATE(BM_PerDevice, JabBench);
+
+// The target sets -fno-trapping-math, which GCC needs to vectorize the bank;
+// it only beats the scalar loop with -march=native (AVX2).
+static void BM_ShakeBank(benchmark::State& state)
+{
+  const auto in = accelBlock(kDevices);
+  std::span<const Coord3D, kDevices> readings(in.data(), kDevices);
+  ShakeBank<kDevices> bank;
+  bank.frequency = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    bank.update(readings);
+    benchmark::DoNotOptimize(bank.values().data());
+  }
+  puara_bench::reportPerSample(state, kDevices, allocations);
+}
+BENCHMARK(BM_ShakeBank);
+
+static void BM_JabBank(benchmark::State& state)
+{
+  const auto in = accelBlock(kDevices);
+  std::span<const Coord3D, kDevices> readings(in.data(), kDevices);
+  JabBank<kDevices> bank;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    bank.update(readings);
+    benchmark::DoNotOptimize(bank.values().data());
+  }
+  puara_bench::reportPerSample(state, kDevices, allocations);
+}
+BENCHMARK(BM_JabBank);
+
+// brushRub.h / touchArrayGestureDetector.h
+// A finger position sweeping back and forth, and a 30-stripe touch array
+// with two blobs moving along it.
+static void BM_BrushRub(benchmark::State& state)
+{
+  std::vector<double> in(static_cast<std::size_t>(state.range(0)));
+  for(std::size_t i = 0; i < in.size(); ++i)
+    in[i] = 0.05 * static_cast<double>(i % 40 < 20 ? i % 40 : 40 - i % 40);
+  BrushRubDetector detector;
+  uint64_t micros = 1000;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(double position : in)
+      detector.updateAt(position, micros += 1000);
+    benchmark::DoNotOptimize(detector.brush.value);
+    benchmark::DoNotOptimize(detector.rub.value);
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+BENCHMARK(BM_BrushRub)->Apply(blockSizes);
+
+// The brush/rub integrators as they were before ValueIntegrator used CRTP:
+// same arithmetic, dispatched through a pure virtual integrate().
+namespace virtual_brush_rub
+{
+
+class ValueIntegrator
+{
+public:
+  virtual ~ValueIntegrator() = default;
+  double value{};
+  double prevValue{};
+
+  void updateAt(double newValue, uint64_t timestampMicros)
+  {
+    sampleTimestamp = timestampMicros;
+    const auto delta = newValue - prevValue;
+    prevValue = newValue;
+    if(delta == 0.0)
+    {
+      if(++counter < 10.0)
+        return;
+      if(value < 0.001)
+        value = 0;
+      else
+        integrate(delta);
+    }
+    else if(std::abs(delta) > 1.0)
+      integrate(0.0);
+    else
+    {
+      integrate(delta);
+      counter = 0;
+    }
+  }
+
+protected:
+  utils::LeakyIntegrator integrator{0.0f, 0.0f, 0.7f, 100, 0};
+  uint64_t sampleTimestamp{};
+  virtual void integrate(double input) = 0;
+
+private:
+  int counter{};
+};
+
+class Brush : public ValueIntegrator
+{
+  void integrate(double movement) override
+  {
+    value = integrator.integrateAt(movement * .15, sampleTimestamp);
+  }
+};
+
+class Rub : public ValueIntegrator
+{
+  void integrate(double movement) override
+  {
+    value = integrator.integrateAt(std::abs(movement * .15), sampleTimestamp);
+  }
+};
+
+struct BrushRubDetector
+{
+  Brush brush;
+  Rub rub;
+
+  void updateAt(double newData, uint64_t timestampMicros)
+  {
+    brush.updateAt(newData, timestampMicros);
+    rub.updateAt(newData, timestampMicros);
+  }
+};
+
+}
+
+static void BM_BrushRubVirtual(benchmark::State& state)
+{
+  std::vector<double> in(static_cast<std::size_t>(state.range(0)));
+  for(std::size_t i = 0; i < in.size(); ++i)
+    in[i] = 0.05 * static_cast<double>(i % 40 < 20 ? i % 40 : 40 - i % 40);
+  virtual_brush_rub::BrushRubDetector detector;
+  uint64_t micros = 1000;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(double position : in)
+      detector.updateAt(position, micros += 1000);
+    benchmark::DoNotOptimize(detector.brush.value);
+    benchmark::DoNotOptimize(detector.rub.value);
+  }
+  puara_bench::reportPerSample(state, state.range(0), allocations);
+}
+BENCHMARK(BM_BrushRubVirtual)->Apply(blockSizes);
+
+// brushRubBank.h
+// Eight fingers, one detector per finger against the structure-of-arrays
+// bank. Each iteration is one frame.
+constexpr std::size_t kFingers = 8;
+constexpr int kFingerFrames = 64;
+
+static std::vector<std::array<double, kFingers>> fingerFrames()
+{
+  std::vector<std::array<double, kFingers>> frames(kFingerFrames);
+  for(int f = 0; f < kFingerFrames; ++f)
+    for(std::size_t i = 0; i < kFingers; ++i)
+      frames[f][i] = 4.0 * static_cast<double>(i) + 0.25 * static_cast<double>((f + i) % 16);
+  return frames;
+}
+
+template <typename Detector>
+static void BM_BrushRubPerFinger(benchmark::State& state)
+{
+  const auto frames = fingerFrames();
+  std::array<Detector, kFingers> detectors;
+  uint64_t micros = 1000;
+  int frame = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    micros += 1000;
+    for(std::size_t i = 0; i < kFingers; ++i)
+      detectors[i].updateAt(frames[frame][i], micros);
+    frame = (frame + 1) % kFingerFrames;
+    benchmark::DoNotOptimize(detectors.data());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK_TEMPLATE(BM_BrushRubPerFinger, virtual_brush_rub::BrushRubDetector);
+BENCHMARK_TEMPLATE(BM_BrushRubPerFinger, BrushRubDetector);
+
+static void BM_BrushRubBank(benchmark::State& state)
+{
+  const auto frames = fingerFrames();
+  BrushRubBank<kFingers> bank;
+  uint64_t micros = 1000;
+  int frame = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    bank.updateAt(frames[frame], micros += 1000);
+    frame = (frame + 1) % kFingerFrames;
+    benchmark::DoNotOptimize(bank.brushValues().data());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_BrushRubBank);
+
+static void BM_TouchArrayGestureDetector(benchmark::State& state)
+{
+  constexpr int touchSize = 30;
+  constexpr int frames = 64;
+  std::vector<std::array<int, touchSize>> in(frames);
+  for(int f = 0; f < frames; ++f)
+  {
+    in[f].fill(0);
+    for(int w = 0; w < 3; ++w)
+    {
+      in[f][(f / 4 + w) % touchSize] = 1;
+      in[f][(touchSize - 1 - f / 4 - w + touchSize) % touchSize] = 1;
+    }
+  }
+  TouchArrayGestureDetector<4, 5> detector;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(auto& frame : in)
+      detector.update(frame.data(), touchSize);
+    benchmark::DoNotOptimize(detector.totalBrush);
+  }
+  puara_bench::reportPerSample(state, frames, allocations);
+}
+BENCHMARK(BM_TouchArrayGestureDetector);
+
+// A 120-stripe strip with three fingers, int frames against packed frames.
+constexpr int kLongTouchSize = 120;
+
+static std::vector<std::array<int, kLongTouchSize>> longTouchFrames()
+{
+  std::vector<std::array<int, kLongTouchSize>> frames(64);
+  for(std::size_t f = 0; f < frames.size(); ++f)
+  {
+    frames[f].fill(0);
+    for(std::size_t finger = 0; finger < 3; ++finger)
+      for(std::size_t w = 0; w < 5; ++w)
+        frames[f][(f / 4 + 40 * finger + w) % kLongTouchSize] = 1;
+  }
+  return frames;
+}
+
+static void BM_TouchArrayGestureDetectorLong(benchmark::State& state)
+{
+  auto in = longTouchFrames();
+  TouchArrayGestureDetector<4, 10> detector;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(auto& frame : in)
+      detector.update(frame.data(), kLongTouchSize);
+    benchmark::DoNotOptimize(detector.totalBrush);
+  }
+  puara_bench::reportPerSample(state, in.size(), allocations);
+}
+BENCHMARK(BM_TouchArrayGestureDetectorLong);
+
+static void BM_TouchArrayGestureDetectorBits(benchmark::State& state)
+{
+  constexpr int words = utils::bitWordCount(kLongTouchSize);
+  const auto frames = longTouchFrames();
+  std::vector<std::array<uint64_t, words>> in(frames.size());
+  for(std::size_t f = 0; f < frames.size(); ++f)
+    utils::packBits(frames[f].data(), kLongTouchSize, in[f].data());
+  TouchArrayGestureDetector<4, 10> detector;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(const auto& frame : in)
+      detector.update(frame.data(), kLongTouchSize);
+    benchmark::DoNotOptimize(detector.totalBrush);
+  }
+  puara_bench::reportPerSample(state, in.size(), allocations);
+}
+BENCHMARK(BM_TouchArrayGestureDetectorBits);
+
+// madgwickBank.h
+// One MadgwickQuaternionFilter per device against the structure-of-arrays bank.
+// The target sets -fno-math-errno, which GCC needs to vectorize the bank; add
+// -march=native for wider vectors.
+static void BM_MadgwickPerDevice(benchmark::State& state)
+{
+  const auto in = imuBlock(kDevices);
+  std::vector<MadgwickQuaternionFilter> filters(kDevices);
+  uint64_t micros = 1000;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    micros += 10000;
+    for(std::size_t d = 0; d < kDevices; ++d)
+      filters[d].updateWithTimestamp(in[d], micros, true);
+    benchmark::DoNotOptimize(filters.data());
+  }
+  puara_bench::reportPerSample(state, kDevices, allocations);
+}
+BENCHMARK(BM_MadgwickPerDevice);
+
+static void BM_MadgwickBank(benchmark::State& state)
+{
+  const auto in = imuBlock(kDevices);
+  std::span<const Imu9Axis, kDevices> readings(in.data(), kDevices);
+  MadgwickBank<kDevices> bank;
+  uint64_t micros = 1000;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    bank.updateWithTimestamp(readings, micros += 10000, true);
+    benchmark::DoNotOptimize(bank);
+  }
+  puara_bench::reportPerSample(state, kDevices, allocations);
+}
+BENCHMARK(BM_MadgwickBank);
+
+// gestureEngine.h
+// 128 devices, 32 samples each per round, ingested then processed with 1 to
+// 4 threads. Wall time: compare time/sample across thread counts for the
+// scaling per core (only meaningful with as many free cores).
+static void BM_GestureEngine(benchmark::State& state)
+{
+  constexpr std::size_t devices = 128;
+  constexpr std::size_t perRound = 32;
+  const auto in = imuBlock(perRound);
+  GestureEngine<> engine(static_cast<std::size_t>(state.range(0)));
+  for(std::size_t d = 0; d < devices; ++d)
+    engine.addDevice();
+
+  std::vector<utils::ImuSample> samples(perRound);
+  uint64_t micros = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t d = 0; d < devices; ++d)
+    {
+      for(std::size_t i = 0; i < perRound; ++i)
+        samples[i] = {micros += 1000, in[i]};
+      engine.ingest(d, samples);
+    }
+    benchmark::DoNotOptimize(engine.process());
+  }
+  puara_bench::reportPerSample(state, devices * perRound, allocations);
+}
+BENCHMARK(BM_GestureEngine)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
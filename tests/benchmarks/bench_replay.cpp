@@ -0,0 +1,413 @@
+#include "bench_common.h"
+
+#include <benchmark/benchmark.h>
+#include <puara/gestures.h>
+#include <puara/utils/imuReplay.h>
+#include <rapidcsv.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+using namespace puara_gestures;
+
+// Replay of the recordings in tests/data. Each iteration runs the whole
+// recording through a descriptor, with the recorded timestamps, so the
+// numbers reflect real motion instead of synthetic noise.
+
+namespace
+{
+
+struct Recording
+{
+  std::vector<uint64_t> micros;
+  std::vector<Imu9Axis> imu;
+
+  // Recording length, used to keep timestamps increasing across iterations.
+  uint64_t span() const { return micros.empty() ? 0 : micros.back() + 10'000; }
+};
+
+Recording loadRecording(const char* filename, double microsPerTimeUnit)
+{
+  utils::CsvImuReader reader(puara_bench::dataPath(filename).string().c_str(), microsPerTimeUnit);
+  Recording recording;
+  utils::replay(reader, [&](const utils::ImuSample& sample) {
+    recording.micros.push_back(sample.timestampMicros);
+    recording.imu.push_back(sample.imu);
+  });
+  return recording;
+}
+
+// Timestamps in milliseconds.
+const Recording& jabShakeRecording()
+{
+  static const Recording recording = loadRecording("imu_data_jab_shake.csv", 1000.0);
+  return recording;
+}
+
+// Timestamps in seconds.
+const Recording& rollRecording()
+{
+  static const Recording recording = loadRecording("imu_data_roll.csv", 1.0e6);
+  return recording;
+}
+
+const Recording& tiltRecording()
+{
+  static const Recording recording = loadRecording("imu_data_tilt.csv", 1.0e6);
+  return recording;
+}
+
+// The timestamp column of the roll and tilt recordings is the interval since
+// the previous row, in seconds; the filter accuracy benchmarks accumulate it.
+Recording accumulateTimestamps(Recording recording)
+{
+  uint64_t time = 1;
+  for(auto& micros : recording.micros)
+    micros = time += micros;
+  return recording;
+}
+
+// Timestamps in milliseconds.
+const Recording& magnetometerRecording()
+{
+  static const Recording recording
+      = loadRecording("magnetometer_raw_floats.csv", 1000.0);
+  return recording;
+}
+
+}
+
+// shake.h / jab.h / shakeBank.h / simple_tilt_roll.h
+static void BM_ReplayShake3D(benchmark::State& state)
+{
+  const auto& recording = jabShakeRecording();
+  Shake3D shake;
+  uint64_t offset = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t i = 0; i < recording.imu.size(); ++i)
+      shake.updateAt(recording.imu[i].accl, offset + recording.micros[i]);
+    offset += recording.span();
+    benchmark::DoNotOptimize(shake.current_value());
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+}
+BENCHMARK(BM_ReplayShake3D);
+
+static void BM_ReplayShakeBank(benchmark::State& state)
+{
+  const auto& recording = jabShakeRecording();
+  ShakeBank<1> bank;
+  uint64_t offset = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t i = 0; i < recording.imu.size(); ++i)
+    {
+      std::span<const Coord3D, 1> reading(&recording.imu[i].accl, 1);
+      bank.updateAt(reading, offset + recording.micros[i]);
+    }
+    offset += recording.span();
+    benchmark::DoNotOptimize(bank.values().data());
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+}
+BENCHMARK(BM_ReplayShakeBank);
+
+static void BM_ReplayJab3D(benchmark::State& state)
+{
+  const auto& recording = jabShakeRecording();
+  Jab3D jab;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(const auto& sample : recording.imu)
+      jab.update(sample.accl);
+    benchmark::DoNotOptimize(jab.current_value());
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+}
+BENCHMARK(BM_ReplayJab3D);
+
+static void BM_ReplayTiltRoll(benchmark::State& state)
+{
+  const auto& recording = jabShakeRecording();
+  Tilt_Roll tiltRoll;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(const auto& sample : recording.imu)
+      tiltRoll.update(sample.accl);
+    benchmark::DoNotOptimize(tiltRoll.current_value());
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+}
+BENCHMARK(BM_ReplayTiltRoll);
+
+// roll.h / tilt.h
+template <typename Descriptor>
+static double orientationAngle(
+    Descriptor& descriptor, const Imu9Axis& imu, double periodSeconds)
+{
+  if constexpr(std::is_same_v<Descriptor, Roll>)
+    return descriptor.roll(imu.accl, imu.gyro, imu.magn, periodSeconds);
+  else
+    return descriptor.tilt(imu.accl, imu.gyro, imu.magn, periodSeconds);
+}
+
+template <typename Descriptor>
+static void BM_ReplayOrientation(benchmark::State& state)
+{
+  const auto& recording
+      = std::is_same_v<Descriptor, Roll> ? rollRecording() : tiltRecording();
+  Descriptor descriptor;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(std::size_t i = 0; i < recording.imu.size(); ++i)
+    {
+      const double period
+          = i == 0 ? 0.01 : double(recording.micros[i] - recording.micros[i - 1]) * 1e-6;
+      const double angle = orientationAngle(descriptor, recording.imu[i], period);
+      benchmark::DoNotOptimize(descriptor.smooth(angle));
+    }
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+}
+BENCHMARK_TEMPLATE(BM_ReplayOrientation, Roll);
+BENCHMARK_TEMPLATE(BM_ReplayOrientation, Tilt);
+
+// madgwickQuaternion.h / mahonyQuaternion.h / kalmanQuaternion.h
+// Each filter runs in double and in float; the recording is converted to the
+// filter's scalar type before timing starts.
+template <typename Filter>
+static void BM_ReplayFilter(benchmark::State& state)
+{
+  using Scalar = decltype(Filter{}.quaternion.w);
+  const auto& recording = jabShakeRecording();
+  std::vector<Imu9AxisT<Scalar>> imu;
+  imu.reserve(recording.imu.size());
+  for(const auto& sample : recording.imu)
+    imu.push_back(static_cast<Imu9AxisT<Scalar>>(sample));
+  std::vector<uint64_t> micros(recording.micros.size());
+  std::vector<QuaternionT<Scalar>> out(recording.imu.size());
+  Filter filter;
+  uint64_t offset = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    for(std::size_t i = 0; i < micros.size(); ++i)
+      micros[i] = offset + recording.micros[i];
+    offset += recording.span();
+    state.ResumeTiming();
+    filter.updateWithTimestamp(imu, micros, out, false);
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+}
+BENCHMARK_TEMPLATE(BM_ReplayFilter, MadgwickQuaternionFilter);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, MadgwickQuaternionFilterT<float>);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, MadgwickQuaternionFilterT<float, fastmath::FastMath>);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, MadgwickQuaternionFilterT<float, fastmath::FastMathNoHardwareSqrt>);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, MahonyQuaternionFilter);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, MahonyQuaternionFilterT<float>);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, MahonyQuaternionFilterT<float, fastmath::FastMath>);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, MahonyQuaternionFilterT<float, fastmath::FastMathNoHardwareSqrt>);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, KalmanQuaternionFilter);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, KalmanQuaternionFilterT<float>);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, KalmanQuaternionFilterT<float, fastmath::FastMath>);
+BENCHMARK_TEMPLATE(BM_ReplayFilter, KalmanQuaternionFilterT<float, fastmath::FastMathNoHardwareSqrt>);
+
+// Accuracy of the filters on the roll and tilt recordings (argument 0 and 1),
+// held still or moved slowly, so the accelerometer gives the reference tilt.
+// The roll recording also has a gyro offset of about 7 degrees/s, which the
+// filters have to reject. `tilt_error_deg` is the RMS angle between the
+// filter's gravity direction and the accelerometer's, over one replay from a
+// fresh filter; the time columns measure the same replay.
+template <typename Filter>
+static double tiltErrorDegrees(const Filter& filter, const Imu9Axis& imu)
+{
+  const auto& q = filter.getQuaternion();
+  const double gx = 2.0 * (q.x * q.z - q.w * q.y);
+  const double gy = 2.0 * (q.y * q.z + q.w * q.x);
+  const double gz = 1.0 - 2.0 * (q.x * q.x + q.y * q.y);
+  const auto& a = imu.accl;
+  const double cosine
+      = (gx * a.x + gy * a.y + gz * a.z) / std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+  return std::acos(std::clamp(cosine, -1.0, 1.0)) * 57.29577951308232;
+}
+
+template <typename Filter>
+static void BM_ReplayFilterAccuracy(benchmark::State& state)
+{
+  static const Recording roll = accumulateTimestamps(rollRecording());
+  static const Recording tilt = accumulateTimestamps(tiltRecording());
+  const Recording& recording = state.range(0) == 0 ? roll : tilt;
+
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    Filter filter;
+    for(std::size_t i = 0; i < recording.imu.size(); ++i)
+      filter.updateWithTimestamp(recording.imu[i], recording.micros[i], true);
+    benchmark::DoNotOptimize(filter.quaternion);
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+
+  Filter filter;
+  double squares = 0.0;
+  for(std::size_t i = 0; i < recording.imu.size(); ++i)
+  {
+    filter.updateWithTimestamp(recording.imu[i], recording.micros[i], true);
+    const double error = tiltErrorDegrees(filter, recording.imu[i]);
+    squares += error * error;
+  }
+  state.counters["tilt_error_deg"] = std::sqrt(squares / double(recording.imu.size()));
+}
+BENCHMARK_TEMPLATE(BM_ReplayFilterAccuracy, MadgwickQuaternionFilter)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ReplayFilterAccuracy, MahonyQuaternionFilter)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ReplayFilterAccuracy, KalmanQuaternionFilter)->Arg(0)->Arg(1);
+
+// magnetometerCalibration_MinMaxScaling.h
+static void BM_ReplayMagnetometerCalibration(benchmark::State& state)
+{
+  const auto& recording = magnetometerRecording();
+  std::vector<Coord3D> samples(recording.imu.size());
+  for(std::size_t i = 0; i < samples.size(); ++i)
+    samples[i] = recording.imu[i].magn;
+
+  utils::Embedded_Magnetometer_Calibration calibration(samples.size());
+  calibration.generateMagnetometerMatrices(samples.data(), samples.size());
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(const auto& sample : recording.imu)
+    {
+      calibration.applyMagnetometerCalibration(sample);
+      benchmark::DoNotOptimize(calibration.myCalIMU.magn);
+    }
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+}
+BENCHMARK(BM_ReplayMagnetometerCalibration);
+
+// magnetometerCalibration_EllipsoidFit.h
+// The whole recording folded into the statistics, then one solve.
+static void BM_ReplayStreamingMagnetometerCalibration(benchmark::State& state)
+{
+  const auto& recording = magnetometerRecording();
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    utils::Streaming_Magnetometer_Calibration calibration;
+    for(const auto& sample : recording.imu)
+      calibration.addSample(sample.magn);
+    benchmark::DoNotOptimize(calibration.generateMagnetometerMatrices());
+  }
+  puara_bench::reportPerSample(state, recording.imu.size(), allocations);
+}
+BENCHMARK(BM_ReplayStreamingMagnetometerCalibration);
+
+// imuReplay.h
+// Reading the jab/shake recording: rapidcsv with a lookup per cell against
+// the streaming CSV reader and the binary format. Each
+// iteration reads the whole file and feeds every sample to Shake3D.
+static void BM_ReadRecordingRapidcsv(benchmark::State& state)
+{
+  const auto path = puara_bench::dataPath("imu_data_jab_shake.csv").string();
+  std::size_t rows = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    rapidcsv::Document doc(path, rapidcsv::LabelParams(0, -1));
+    rows = doc.GetRowCount();
+    Shake3D shake;
+    for(std::size_t r = 0; r < rows; ++r)
+      shake.updateAt(
+          Coord3D{
+              doc.GetCell<double>("accl_x", r), doc.GetCell<double>("accl_y", r),
+              doc.GetCell<double>("accl_z", r)},
+          static_cast<uint64_t>(doc.GetCell<double>("timestamp", r) * 1000.0));
+    benchmark::DoNotOptimize(shake.current_value());
+  }
+  puara_bench::reportPerSample(state, rows, allocations);
+}
+BENCHMARK(BM_ReadRecordingRapidcsv);
+
+template <typename Reader>
+static void BM_ReadRecording(benchmark::State& state)
+{
+  auto path = puara_bench::dataPath("imu_data_jab_shake.csv");
+  if constexpr(std::is_same_v<Reader, utils::BinaryImuReader>)
+  {
+    const auto binary = std::filesystem::temp_directory_path() / "puara_bench_jab_shake.imu";
+    utils::CsvImuReader csv(path.string().c_str());
+    utils::BinaryImuWriter writer(binary.string().c_str());
+    utils::replay(csv, [&](std::span<const utils::ImuSample> chunk) { writer.write(chunk); });
+    writer.close();
+    path = binary;
+  }
+
+  std::size_t samples = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    Reader reader(path.string().c_str());
+    Shake3D shake;
+    samples = utils::replay(reader, [&](const utils::ImuSample& s) {
+      shake.updateAt(s.imu.accl, s.timestampMicros);
+    });
+    benchmark::DoNotOptimize(shake.current_value());
+  }
+  puara_bench::reportPerSample(state, samples, allocations);
+}
+BENCHMARK_TEMPLATE(BM_ReadRecording, utils::CsvImuReader);
+BENCHMARK_TEMPLATE(BM_ReadRecording, utils::BinaryImuReader);
+
+// imuRecording.h
+// The same replay over a memory-mapped recording in each encoding: records
+// are decoded in place, with no read buffer. `bytes_per_sample` is the record
+// size, against about 160 bytes per CSV row.
+template <typename Record>
+static void BM_ReplayMappedRecording(benchmark::State& state)
+{
+  const auto binary = std::filesystem::temp_directory_path() / "puara_bench_mapped.imu";
+  {
+    utils::CsvImuReader csv(puara_bench::dataPath("imu_data_jab_shake.csv").string().c_str());
+    utils::ImuRecordingHeader format;
+    if constexpr(Record::encoding == utils::ImuEncoding::Float16)
+      format = utils::ImuRecordingHeader::float16();
+    else if constexpr(Record::encoding == utils::ImuEncoding::Int16)
+      format = utils::ImuRecordingHeader::int16(40.0, 20.0, 2.0);
+    utils::BinaryImuWriter writer(binary.string().c_str(), format);
+    utils::replay(csv, [&](std::span<const utils::ImuSample> chunk) { writer.write(chunk); });
+  }
+
+  utils::MappedImuRecording recording(binary.string().c_str());
+  const auto records = recording.records<Record>();
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    Shake3D shake;
+    for(const auto& record : records)
+    {
+      const auto sample = record.decode(recording.header());
+      shake.updateAt(sample.imu.accl, sample.timestampMicros);
+    }
+    benchmark::DoNotOptimize(shake.current_value());
+  }
+  puara_bench::reportPerSample(state, records.size(), allocations);
+  state.counters["bytes_per_sample"] = double(sizeof(Record));
+  std::filesystem::remove(binary);
+}
+BENCHMARK_TEMPLATE(BM_ReplayMappedRecording, utils::ImuRecord);
+BENCHMARK_TEMPLATE(BM_ReplayMappedRecording, utils::ImuRecordHalf);
+BENCHMARK_TEMPLATE(BM_ReplayMappedRecording, utils::ImuRecordInt16);
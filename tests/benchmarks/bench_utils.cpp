@@ -0,0 +1,738 @@
+#include "bench_common.h"
+
+#include <benchmark/benchmark.h>
+#include <puara/utils.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace puara_gestures::utils;
+namespace fastmath = puara_gestures::fastmath;
+
+namespace
+{
+
+constexpr std::size_t kSignalLength = 4096;
+
+const std::vector<double>& noiseSignal()
+{
+  static const std::vector<double> signal = [] {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> dist(-10.0, 10.0);
+    std::vector<double> values(kSignalLength);
+    for(auto& v : values)
+      v = dist(rng);
+    return values;
+  }();
+  return signal;
+}
+
+}
+
+// rollingminmax.h
+// The wedge mode should report a flat O(1) complexity while the rescan mode
+// grows linearly with the window length.
+template <RollingMinMaxMode Mode>
+static void BM_RollingMinMax(benchmark::State& state)
+{
+  const auto window = static_cast<std::size_t>(state.range(0));
+  const auto& signal = noiseSignal();
+  RollingMinMax<double> minmax(window, Mode);
+
+  std::size_t i = 0;
+  for(std::size_t n = 0; n < window; ++n)
+    minmax.update(signal[i++ % kSignalLength]);
+
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(minmax.update(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_RollingMinMax, RollingMinMaxMode::Rescan)
+    ->RangeMultiplier(4)
+    ->Range(16, 1024)
+    ->Complexity();
+BENCHMARK_TEMPLATE(BM_RollingMinMax, RollingMinMaxMode::MonotonicWedge)
+    ->RangeMultiplier(4)
+    ->Range(16, 1024)
+    ->Complexity();
+
+// rollingminmax.h with a compile-time window, as used by Jab.
+static void BM_RollingMinMaxFixed10(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  RollingMinMax<double, 10> minmax;
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(minmax.update(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_RollingMinMaxFixed10);
+
+// circularbuffer.h
+// Boost-backed runtime capacity against inline power-of-two storage.
+static void BM_CircularBufferAdd(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  CircularBuffer<double> buffer(16);
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(buffer.add(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_CircularBufferAdd);
+
+static void BM_CircularBufferFixedAdd(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  CircularBuffer<double, 16> buffer;
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(buffer.add(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_CircularBufferFixedAdd);
+
+// smooth.h
+// Default window used by Roll; no allocation once the window is set up.
+template <SmoothMode Mode>
+static void BM_Smooth(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  Smooth smoother(static_cast<std::size_t>(state.range(0)), Mode);
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(smoother.smooth(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK_TEMPLATE(BM_Smooth, SmoothMode::Mean)->Arg(50);
+BENCHMARK_TEMPLATE(BM_Smooth, SmoothMode::Exponential)->Arg(50);
+BENCHMARK_TEMPLATE(BM_Smooth, SmoothMode::Median)->Arg(50);
+BENCHMARK_TEMPLATE(BM_Smooth, SmoothMode::SavitzkyGolay)->Arg(50);
+
+// leakyintegrator.h
+// integrate() reads the clock on every sample; the timestamp and duration
+// overloads do not.
+static void BM_LeakyIntegratorClock(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  LeakyIntegrator integrator(0.0, 0.0, 0.5, 100, 0);
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(integrator.integrate(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_LeakyIntegratorClock);
+
+static void BM_LeakyIntegratorAt(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  LeakyIntegrator integrator(0.0, 0.0, 0.5, 100, 0);
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    const uint64_t timestamp = 1000 * i;
+    benchmark::DoNotOptimize(
+        integrator.integrateAt(signal[i++ % kSignalLength], timestamp));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_LeakyIntegratorAt);
+
+static void BM_LeakyIntegratorContinuous(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  LeakyIntegrator integrator(0.0, 0.0, 0.5, 100, 0, LeakMode::Continuous);
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(integrator.integrateDt(signal[i++ % kSignalLength], 0.001));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_LeakyIntegratorContinuous);
+
+// discretizer.h / maprange.h / threshold.h / wrap.h
+// Scalar helpers applied on every sample of a stream.
+static void BM_Discretizer(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  Discretizer<double> discretizer;
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    // Every other sample repeats the previous one.
+    benchmark::DoNotOptimize(discretizer.isNew(signal[(i++ / 2) % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_Discretizer);
+
+static void BM_MapRange(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  MapRange mapper;
+  mapper.inMin = -10.0;
+  mapper.inMax = 10.0;
+  mapper.outMin = 0.0;
+  mapper.outMax = 1.0;
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(mapper.range(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_MapRange);
+
+static void BM_Threshold(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  Threshold threshold(-5.0, 5.0);
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(threshold.update(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_Threshold);
+
+static void BM_Wrap(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  Wrap wrapper(-M_PI, M_PI);
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(wrapper.wrap(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_Wrap);
+
+static void BM_Unwrap(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  Unwrap unwrapper(-10.0, 10.0);
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(unwrapper.unwrap(signal[i++ % kSignalLength]));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_Unwrap);
+
+// fastmath.h
+// The math policies of the orientation code, one call per sample, in both
+// precisions. Inputs cover the whole domain of each function.
+template <typename Math, typename T>
+static void BM_MathRsqrt(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    const T x = static_cast<T>(signal[i++ % kSignalLength]);
+    benchmark::DoNotOptimize(Math::rsqrt(x * x + T(0.01)));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK_TEMPLATE(BM_MathRsqrt, fastmath::StdMath, float);
+BENCHMARK_TEMPLATE(BM_MathRsqrt, fastmath::FastMathNoHardwareSqrt, float);
+BENCHMARK_TEMPLATE(BM_MathRsqrt, fastmath::StdMath, double);
+BENCHMARK_TEMPLATE(BM_MathRsqrt, fastmath::FastMathNoHardwareSqrt, double);
+
+template <typename Math, typename T>
+static void BM_MathAtan2(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    const T y = static_cast<T>(signal[i % kSignalLength]);
+    const T x = static_cast<T>(signal[(i + 1) % kSignalLength]);
+    ++i;
+    benchmark::DoNotOptimize(Math::atan2(y, x));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK_TEMPLATE(BM_MathAtan2, fastmath::StdMath, float);
+BENCHMARK_TEMPLATE(BM_MathAtan2, fastmath::FastMath, float);
+BENCHMARK_TEMPLATE(BM_MathAtan2, fastmath::StdMath, double);
+BENCHMARK_TEMPLATE(BM_MathAtan2, fastmath::FastMath, double);
+
+template <typename Math, typename T>
+static void BM_MathAsin(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    const T x = static_cast<T>(signal[i++ % kSignalLength] * 0.1);
+    benchmark::DoNotOptimize(Math::asin(x));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK_TEMPLATE(BM_MathAsin, fastmath::StdMath, float);
+BENCHMARK_TEMPLATE(BM_MathAsin, fastmath::FastMath, float);
+BENCHMARK_TEMPLATE(BM_MathAsin, fastmath::StdMath, double);
+BENCHMARK_TEMPLATE(BM_MathAsin, fastmath::FastMath, double);
+
+// chrono.h
+static void BM_GetCurrentTimeMicroseconds(benchmark::State& state)
+{
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(getCurrentTimeMicroseconds());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_GetCurrentTimeMicroseconds);
+
+// utils.h
+// Array helpers used by TouchArrayGestureDetector, one 30-stripe touch frame
+// per sample.
+constexpr int kTouchSize = 30;
+
+static std::vector<int> touchFrame()
+{
+  std::vector<int> frame(kTouchSize);
+  for(int i = 0; i < kTouchSize; ++i)
+    frame[i] = (i % 7) < 3 ? 1 : 0;
+  return frame;
+}
+
+static void BM_ArrayAverage(benchmark::State& state)
+{
+  const auto frame = touchFrame();
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(arrayAverage(frame.data(), 0, kTouchSize));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_ArrayAverage);
+
+static void BM_BitShiftArrayL(benchmark::State& state)
+{
+  auto frame = touchFrame();
+  std::vector<int> shifted(kTouchSize);
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    bitShiftArrayL(frame.data(), shifted.data(), kTouchSize, 3);
+    benchmark::DoNotOptimize(shifted.data());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_BitShiftArrayL);
+
+// bitShift.h
+// A 32-byte raw touch buffer (256 stripes) at realistic realignment shifts,
+// legacy multi-pass shift against the single-pass shift at three word sizes.
+constexpr int kRawTouchBytes = 32;
+
+static void realignShifts(benchmark::internal::Benchmark* bench)
+{
+  for(int shift : {1, 3, 7, 13})
+    bench->Arg(shift);
+}
+
+static void BM_BitShiftArrayLRaw(benchmark::State& state)
+{
+  std::vector<int> raw(kRawTouchBytes);
+  for(int i = 0; i < kRawTouchBytes; ++i)
+    raw[i] = (i * 37) & 0xff;
+  std::vector<int> shifted(kRawTouchBytes);
+  const auto shift = static_cast<int>(state.range(0));
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    bitShiftArrayL(raw.data(), shifted.data(), kRawTouchBytes, shift);
+    benchmark::DoNotOptimize(shifted.data());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_BitShiftArrayLRaw)->Apply(realignShifts);
+
+template <typename T>
+static void BM_BitShiftLeft(benchmark::State& state)
+{
+  std::vector<T> raw(kRawTouchBytes / sizeof(T));
+  for(std::size_t i = 0; i < raw.size(); ++i)
+    raw[i] = static_cast<T>(0x9e3779b97f4a7c15ull * (i + 1));
+  const auto shift = static_cast<std::size_t>(state.range(0));
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    // Shifting the same buffer repeatedly; the cost does not depend on the bits.
+    bitShiftLeft(std::span(raw), shift);
+    benchmark::DoNotOptimize(raw.data());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK_TEMPLATE(BM_BitShiftLeft, uint8_t)->Apply(realignShifts);
+BENCHMARK_TEMPLATE(BM_BitShiftLeft, uint32_t)->Apply(realignShifts);
+BENCHMARK_TEMPLATE(BM_BitShiftLeft, uint64_t)->Apply(realignShifts);
+
+static void BM_BitShiftRight(benchmark::State& state)
+{
+  std::vector<uint8_t> raw(kRawTouchBytes);
+  const auto shift = static_cast<std::size_t>(state.range(0));
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    bitShiftRight(std::span(raw), shift);
+    benchmark::DoNotOptimize(raw.data());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_BitShiftRight)->Apply(realignShifts);
+
+static void BM_SphericalRoundTrip(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    const puara_gestures::Coord3D point{
+        signal[i % kSignalLength], signal[(i + 1) % kSignalLength],
+        signal[(i + 2) % kSignalLength]};
+    ++i;
+    benchmark::DoNotOptimize(convert::spheric_to_cartesian(convert::cartesian_to_spheric(point)));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_SphericalRoundTrip);
+
+static void BM_SphericalRoundTripBlock(benchmark::State& state)
+{
+  const auto& signal = noiseSignal();
+  const auto size = static_cast<std::size_t>(state.range(0));
+  std::vector<puara_gestures::Coord3D> points(size);
+  for(std::size_t i = 0; i < size; ++i)
+    points[i] = {
+        signal[i % kSignalLength], signal[(i + 1) % kSignalLength],
+        signal[(i + 2) % kSignalLength]};
+  std::vector<puara_gestures::Spherical> spheric(size);
+  std::vector<puara_gestures::Coord3D> back(size);
+
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    convert::cartesian_to_spheric(points, spheric);
+    convert::spheric_to_cartesian(spheric, back);
+    benchmark::DoNotOptimize(back.data());
+  }
+  puara_bench::reportPerSample(state, size, allocations);
+}
+BENCHMARK(BM_SphericalRoundTripBlock)->Arg(64)->Arg(1024);
+
+// blobDetector.h
+static void BM_BlobDetector(benchmark::State& state)
+{
+  const auto frame = touchFrame();
+  puara_gestures::BlobDetector<4> detector;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    detector.detect1D(frame.data(), kTouchSize);
+    benchmark::DoNotOptimize(detector.blobCount);
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_BlobDetector);
+
+// A touch matrix with four 3x3 fingers drifting across it, 64 frames.
+template <int side>
+static void BM_BlobDetector2D(benchmark::State& state)
+{
+  constexpr int frames = 64;
+  std::vector<uint64_t> grids(frames * side);
+  for(int f = 0; f < frames; ++f)
+  {
+    std::vector<int> cells(side * side, 0);
+    for(int finger = 0; finger < 4; ++finger)
+    {
+      const int x0 = (f / 8 + finger * side / 4) % (side - 3);
+      const int y0 = (f / 16 + finger * 5) % (side - 3);
+      for(int y = y0; y < y0 + 3; ++y)
+        for(int x = x0; x < x0 + 3; ++x)
+          cells[y * side + x] = 1;
+    }
+    for(int r = 0; r < side; ++r)
+      packBits(cells.data() + r * side, side, &grids[f * side + r]);
+  }
+
+  puara_gestures::BlobDetector<8, side> detector;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(int f = 0; f < frames; ++f)
+      detector.detect2D(&grids[f * side], side, side);
+    benchmark::DoNotOptimize(detector.blobs);
+  }
+  puara_bench::reportPerSample(state, frames, allocations);
+}
+BENCHMARK_TEMPLATE(BM_BlobDetector2D, 16);
+BENCHMARK_TEMPLATE(BM_BlobDetector2D, 32);
+
+// bitArray.h
+// A 120-stripe strip, unpacked against one stripe per bit.
+constexpr int kLongTouchSize = 120;
+
+static std::vector<int> longTouchFrame()
+{
+  std::vector<int> frame(kLongTouchSize);
+  for(int i = 0; i < kLongTouchSize; ++i)
+    frame[i] = (i % 23) < 6 ? 1 : 0;
+  return frame;
+}
+
+static void BM_BlobDetectorLong(benchmark::State& state)
+{
+  const auto frame = longTouchFrame();
+  puara_gestures::BlobDetector<8> detector;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    detector.detect1D(frame.data(), kLongTouchSize);
+    benchmark::DoNotOptimize(detector.blobCount);
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_BlobDetectorLong);
+
+static void BM_BlobDetectorBits(benchmark::State& state)
+{
+  const auto frame = longTouchFrame();
+  uint64_t bits[bitWordCount(kLongTouchSize)];
+  packBits(frame.data(), kLongTouchSize, bits);
+  puara_gestures::BlobDetector<8> detector;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(bits);
+    detector.detect1D(bits, kLongTouchSize);
+    benchmark::DoNotOptimize(detector.blobCount);
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_BlobDetectorBits);
+
+static void BM_PackBits(benchmark::State& state)
+{
+  const auto frame = longTouchFrame();
+  uint64_t bits[bitWordCount(kLongTouchSize)];
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    packBits(frame.data(), kLongTouchSize, bits);
+    benchmark::DoNotOptimize(bits);
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_PackBits);
+
+static void BM_CountBits(benchmark::State& state)
+{
+  const auto frame = longTouchFrame();
+  uint64_t bits[bitWordCount(kLongTouchSize)];
+  packBits(frame.data(), kLongTouchSize, bits);
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(bits);
+    benchmark::DoNotOptimize(countBits(bits, 10, kLongTouchSize - 10));
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_CountBits);
+
+// magnetometerCalibration_MinMaxScaling.h
+static std::vector<puara_gestures::Coord3D> magnetometerSphere(std::size_t count)
+{
+  std::vector<puara_gestures::Coord3D> samples(count);
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    const double t = static_cast<double>(i) * 0.1;
+    samples[i] = puara_gestures::Coord3D{
+        0.2 + 0.5 * std::cos(t) * std::sin(0.37 * t),
+        -0.1 + 0.4 * std::sin(t) * std::sin(0.37 * t), 0.05 + 0.6 * std::cos(0.37 * t)};
+  }
+  return samples;
+}
+
+static void BM_MagnetometerCalibrationApply(benchmark::State& state)
+{
+  const auto samples = magnetometerSphere(kSignalLength);
+  Embedded_Magnetometer_Calibration calibration(samples.size());
+  calibration.generateMagnetometerMatrices(samples.data(), samples.size());
+  puara_gestures::Imu9Axis imu;
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    imu.magn = samples[i++ % kSignalLength];
+    calibration.applyMagnetometerCalibration(imu);
+    benchmark::DoNotOptimize(calibration.myCalIMU.magn);
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_MagnetometerCalibrationApply);
+
+// Same samples through apply(), one fused affine transform per sample.
+static void BM_MagnetometerCalibrationApplyBlock(benchmark::State& state)
+{
+  const auto samples = magnetometerSphere(kSignalLength);
+  Embedded_Magnetometer_Calibration calibration(samples.size());
+  calibration.generateMagnetometerMatrices(samples.data(), samples.size());
+  const auto size = static_cast<std::size_t>(state.range(0));
+  std::vector<puara_gestures::Imu9Axis> in(size), out(size);
+  for(std::size_t i = 0; i < size; ++i)
+    in[i].magn = samples[i % kSignalLength];
+
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    calibration.apply(in, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, size, allocations);
+}
+BENCHMARK(BM_MagnetometerCalibrationApplyBlock)->Arg(64)->Arg(1024);
+
+static void BM_MagnetometerCalibrationGenerate(benchmark::State& state)
+{
+  const auto samples = magnetometerSphere(static_cast<std::size_t>(state.range(0)));
+  Embedded_Magnetometer_Calibration calibration(samples.size());
+
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(
+        calibration.generateMagnetometerMatrices(samples.data(), samples.size()));
+  }
+  puara_bench::reportPerSample(state, samples.size(), allocations);
+}
+BENCHMARK(BM_MagnetometerCalibrationGenerate)->Arg(512);
+
+// magnetometerCalibration_EllipsoidFit.h
+// Folding one sample into the statistics, and solving the ellipsoid fit,
+// whose cost does not depend on the number of samples.
+static void BM_StreamingMagnetometerCalibrationAdd(benchmark::State& state)
+{
+  const auto samples = magnetometerSphere(kSignalLength);
+  Streaming_Magnetometer_Calibration calibration;
+
+  std::size_t i = 0;
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    calibration.addSample(samples[i++ % kSignalLength]);
+    benchmark::DoNotOptimize(calibration.scatter.data());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_StreamingMagnetometerCalibrationAdd);
+
+static void BM_StreamingMagnetometerCalibrationGenerate(benchmark::State& state)
+{
+  const auto samples = magnetometerSphere(512);
+  Streaming_Magnetometer_Calibration calibration;
+  calibration.addSamples(samples);
+
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(calibration.generateMagnetometerMatrices());
+  }
+  puara_bench::reportPerSample(state, 1, allocations);
+}
+BENCHMARK(BM_StreamingMagnetometerCalibrationGenerate);
+
+// spscRing.h
+// 64 IMU samples through the queue, one push/pop per sample against one
+// block push/pop (single thread, so this is the per-element overhead only).
+static void BM_Imu9AxisRingPerSample(benchmark::State& state)
+{
+  Imu9AxisRing<256> ring;
+  std::vector<puara_gestures::Imu9Axis> in(64), out(64);
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    for(const auto& sample : in)
+      ring.push(sample);
+    for(auto& sample : out)
+      ring.pop(sample);
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, in.size(), allocations);
+}
+BENCHMARK(BM_Imu9AxisRingPerSample);
+
+static void BM_Imu9AxisRingBlock(benchmark::State& state)
+{
+  Imu9AxisRing<256> ring;
+  std::vector<puara_gestures::Imu9Axis> in(64), out(64);
+  const auto allocations = puara_bench::allocationCount();
+  for(auto _ : state)
+  {
+    ring.push(std::span<const puara_gestures::Imu9Axis>(in));
+    ring.pop(std::span(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  puara_bench::reportPerSample(state, in.size(), allocations);
+}
+BENCHMARK(BM_Imu9AxisRingBlock);
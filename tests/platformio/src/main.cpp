@@ -153,7 +153,7 @@ static void testSmooth() {
   ok &= almostEqual(smoother.smooth(5.0), (2.0 + 4.0 + 5.0) / 3.0);
 
   smoother.clear();
-  ok &= smoother.list.empty();
+  ok &= smoother.empty();
   ok &= almostEqual(smoother.smooth(10.0), 10.0);
 
   logResult(ok, name);
@@ -511,6 +511,86 @@ static void testIMUFilters() {
   logResult(ok, name);
 }
 
+// Synthetic motion shared by the single-precision check and the filter timing.
+static puara_gestures::Imu9Axis syntheticImu(size_t i) {
+  const double t = 0.01 * static_cast<double>(i);
+  return puara_gestures::Imu9Axis{
+      {std::sin(t), 0.2 * std::cos(t), 9.81},
+      {10.0 * std::cos(t), 5.0, -3.0 * std::sin(t)},
+      {0.3, 0.1 * std::sin(t), 0.5}};
+}
+
+template <template <typename, typename = puara_gestures::fastmath::StdMath> class Filter>
+static bool floatFilterTracksDouble() {
+  Filter<double> reference;
+  Filter<float> single;
+  double maxDiff = 0.0;
+  for (size_t i = 0; i < 500; ++i) {
+    const auto imu = syntheticImu(i);
+    const uint64_t micros = 1000 + 10000 * i;
+    reference.updateWithTimestamp(imu, micros, true);
+    single.updateWithTimestamp(static_cast<puara_gestures::Imu9AxisT<float>>(imu), micros, true);
+    const auto& a = reference.getQuaternion();
+    const auto& b = single.getQuaternion();
+    maxDiff = std::max({maxDiff, std::fabs(a.w - b.w), std::fabs(a.x - b.x),
+                        std::fabs(a.y - b.y), std::fabs(a.z - b.z)});
+  }
+  return maxDiff < 1e-4;
+}
+
+static void testIMUFiltersFloat() {
+  const char* name = "IMU filters in single precision track double";
+  bool ok = floatFilterTracksDouble<puara_gestures::MadgwickQuaternionFilterT>();
+  ok &= floatFilterTracksDouble<puara_gestures::MahonyQuaternionFilterT>();
+  ok &= floatFilterTracksDouble<puara_gestures::KalmanQuaternionFilterT>();
+  logResult(ok, name);
+}
+
+// Prints the average update time; informational only, it never fails.
+template <typename Filter>
+static void timeFilter(const char* label) {
+  using Scalar = decltype(Filter{}.quaternion.w);
+  constexpr size_t sampleCount = 256;
+  static puara_gestures::Imu9AxisT<Scalar> imu[sampleCount];
+  for (size_t i = 0; i < sampleCount; ++i) {
+    imu[i] = static_cast<puara_gestures::Imu9AxisT<Scalar>>(syntheticImu(i));
+  }
+
+  Filter filter;
+  const unsigned long start = micros();
+  for (size_t i = 0; i < sampleCount; ++i) {
+    filter.updateWithTimestamp(imu[i], 1000 + 10000 * i, true);
+  }
+  const unsigned long elapsed = micros() - start;
+
+  Serial.print("TIME: ");
+  Serial.print(label);
+  Serial.print(" ");
+  Serial.print(static_cast<double>(elapsed) / sampleCount, 3);
+  Serial.println(" us/update");
+}
+
+static void benchmarkIMUFilters() {
+  timeFilter<puara_gestures::MadgwickQuaternionFilter>("Madgwick double");
+  timeFilter<puara_gestures::MadgwickQuaternionFilterT<float>>("Madgwick float");
+  timeFilter<puara_gestures::MadgwickQuaternionFilterT<float, puara_gestures::fastmath::FastMath>>(
+      "Madgwick float FastMath");
+  timeFilter<puara_gestures::MadgwickQuaternionFilterT<float, puara_gestures::fastmath::FastMathNoHardwareSqrt>>(
+      "Madgwick float FastMathNoHardwareSqrt");
+  timeFilter<puara_gestures::MahonyQuaternionFilter>("Mahony double");
+  timeFilter<puara_gestures::MahonyQuaternionFilterT<float>>("Mahony float");
+  timeFilter<puara_gestures::MahonyQuaternionFilterT<float, puara_gestures::fastmath::FastMath>>(
+      "Mahony float FastMath");
+  timeFilter<puara_gestures::MahonyQuaternionFilterT<float, puara_gestures::fastmath::FastMathNoHardwareSqrt>>(
+      "Mahony float FastMathNoHardwareSqrt");
+  timeFilter<puara_gestures::KalmanQuaternionFilter>("Kalman double");
+  timeFilter<puara_gestures::KalmanQuaternionFilterT<float>>("Kalman float");
+  timeFilter<puara_gestures::KalmanQuaternionFilterT<float, puara_gestures::fastmath::FastMath>>(
+      "Kalman float FastMath");
+  timeFilter<puara_gestures::KalmanQuaternionFilterT<float, puara_gestures::fastmath::FastMathNoHardwareSqrt>>(
+      "Kalman float FastMathNoHardwareSqrt");
+}
+
 static void testEmbeddedMagnetometerCalibration() {
   const char* name = "Embedded magnetometer calibration";
   constexpr size_t sampleCount = 24;
@@ -545,6 +625,38 @@ static void testEmbeddedMagnetometerCalibration() {
   logResult(ok, name);
 }
 
+static void testStreamingMagnetometerCalibration() {
+  const char* name = "Streaming magnetometer calibration";
+  constexpr size_t sampleCount = 200;
+  auto sample = [](size_t i) {
+    const double longitude = 2.0 * M_PI * 7.0 * static_cast<double>(i) / static_cast<double>(sampleCount);
+    const double latitude = M_PI * static_cast<double>(i) / static_cast<double>(sampleCount) - M_PI / 2.0;
+    const double x = std::cos(latitude) * std::cos(longitude);
+    const double y = std::cos(latitude) * std::sin(longitude);
+    const double z = std::sin(latitude);
+    return puara_gestures::Coord3D{x * 1.25 + 0.2 * y + 0.22, y * 0.68 - 0.16, z * 1.14 + 0.1 * x + 0.06};
+  };
+
+  // The samples are folded in as they arrive; none is stored.
+  puara_gestures::utils::Streaming_Magnetometer_Calibration calib;
+  for (size_t i = 0; i < sampleCount; ++i) {
+    calib.addSample(sample(i));
+  }
+  bool ok = (calib.generateMagnetometerMatrices() == 1);
+
+  for (size_t i = 0; ok && i < sampleCount; i += 7) {
+    puara_gestures::Imu9Axis raw{};
+    raw.magn = sample(i);
+    calib.applyMagnetometerCalibration(raw);
+    const double r = std::sqrt(calib.myCalIMU.magn.x * calib.myCalIMU.magn.x +
+                              calib.myCalIMU.magn.y * calib.myCalIMU.magn.y +
+                              calib.myCalIMU.magn.z * calib.myCalIMU.magn.z);
+    ok &= almostEqual(r, 1.0, 1e-6);
+  }
+
+  logResult(ok, name);
+}
+
 static void testRollingMinMax() {
   const char* name = "RollingMinMax sliding range";
   puara_gestures::utils::RollingMinMax<int> window(3);
@@ -602,7 +714,9 @@ static void runEmbeddedTests() {
   testJabDescriptor();
   testShakeDescriptor();
   testIMUFilters();
+  testIMUFiltersFloat();
   testEmbeddedMagnetometerCalibration();
+  testStreamingMagnetometerCalibration();
   testRollingMinMax();
   testDiscretizer();
 
@@ -616,6 +730,8 @@ static void runEmbeddedTests() {
   } else {
     Serial.println("=== EMBEDDED TESTS FAILED ===");
   }
+
+  benchmarkIMUFilters();
 }
 
 void setup() {
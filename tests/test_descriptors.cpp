@@ -1,14 +1,20 @@
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <puara/descriptors/gestureEngine.h>
 #include <puara/gestures.h>
 
 #include <cmath>
 #include <rapidcsv.h>
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <random>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 using namespace puara_gestures;
 
@@ -140,6 +146,19 @@ TEST_CASE(
   tied.update();
   CHECK(tied.current_roll_value() == Catch::Approx(M_PI_2).margin(1e-6));
   CHECK(tied.current_tilt_value() == Catch::Approx(0.0).margin(1e-6));
+
+  puara_gestures::Tilt_RollT<puara_gestures::fastmath::FastMath> fast;
+  for(int i = 0; i < 360; ++i)
+  {
+    const double a = i * M_PI / 180.0;
+    const double x = std::cos(a) * std::cos(3.0 * a);
+    const double y = std::sin(a) * std::cos(3.0 * a);
+    const double z = std::sin(3.0 * a);
+    simple.update(x, y, z);
+    fast.update(x, y, z);
+    CHECK(fast.current_roll_value() == Catch::Approx(simple.current_roll_value()).margin(1e-8));
+    CHECK(fast.current_tilt_value() == Catch::Approx(simple.current_tilt_value()).margin(1e-8));
+  }
 }
 
 TEST_CASE(
@@ -277,6 +296,71 @@ TEST_CASE(
   CHECK(touchArrayGD.totalRub >= 0.0f);
 }
 
+TEST_CASE(
+    "Touch descriptor gives identical averages from a bit-packed array",
+    "[descriptors][touch]")
+{
+  constexpr int touchSize = 120;
+  TouchArrayGestureDetector<4, 10> fromInts;
+  TouchArrayGestureDetector<4, 10> fromBits;
+
+  int touchArray[touchSize] = {0};
+  uint64_t touchBits[utils::bitWordCount(touchSize)];
+  for(int frame = 0; frame < 20; ++frame)
+  {
+    std::fill(std::begin(touchArray), std::end(touchArray), 0);
+    for(int finger = 0; finger < 3; ++finger)
+      for(int w = 0; w < 4 + finger; ++w)
+        touchArray[(frame * (finger + 1) + 37 * finger + w) % touchSize] = 1;
+    utils::packBits(touchArray, touchSize, touchBits);
+
+    fromInts.update(touchArray, touchSize);
+    fromBits.update(touchBits, touchSize);
+
+    CHECK(fromBits.totalTouchAverage == fromInts.totalTouchAverage);
+    CHECK(fromBits.topTouchAverage == fromInts.topTouchAverage);
+    CHECK(fromBits.middleTouchAverage == fromInts.middleTouchAverage);
+    CHECK(fromBits.bottomTouchAverage == fromInts.bottomTouchAverage);
+  }
+}
+
+TEST_CASE(
+    "Touch descriptor keeps each finger's brush when other fingers land and lift",
+    "[descriptors][touch]")
+{
+  constexpr int touchSize = 40;
+  TouchArrayGestureDetector<4, 4> alone;
+  TouchArrayGestureDetector<4, 4> withOthers;
+
+  // One finger slides up the array by half a stripe per frame. In the second
+  // detector a resting finger lands below it (taking blob index 0) for a while,
+  // and a third one lands above it.
+  float maxBrush = 0.0f;
+  for(int frame = 0; frame < 60; ++frame)
+  {
+    int single[touchSize] = {0};
+    const int start = 20 + frame / 2 % 12;
+    for(int i = start; i < start + 3; ++i)
+      single[i] = 1;
+
+    int several[touchSize];
+    std::copy(std::begin(single), std::end(single), std::begin(several));
+    if(frame >= 10 && frame < 30)
+      several[2] = several[3] = 1;
+    if(frame >= 20 && frame < 50)
+      several[38] = 1;
+
+    const uint64_t micros = 1'000'000 + 20'000 * frame;
+    alone.updateAt(single, touchSize, micros);
+    withOthers.updateAt(several, touchSize, micros);
+
+    CHECK(withOthers.totalBrush == alone.totalBrush);
+    CHECK(withOthers.totalRub == alone.totalRub);
+    maxBrush = std::max(maxBrush, alone.totalBrush);
+  }
+  CHECK(maxBrush > 0.0f);
+}
+
 TEST_CASE("Button descriptor tracks taps, press time, and hold", "[descriptors][button]")
 {
   Button button;
@@ -322,3 +406,679 @@ TEST_CASE("Button descriptor tracks taps, press time, and hold", "[descriptors][
 
   CHECK(holdButton.hold == true);
 }
+
+TEST_CASE("Button reports timestamped events", "[descriptors][button]")
+{
+  ButtonEventRing<> events;
+  Button button;
+  button.events = &events;
+  button.id = 7;
+  button.countInterval = 200;
+  button.holdInterval = 1000;
+
+  auto next = [&] {
+    ButtonEvent event;
+    REQUIRE(events.pop(event));
+    CHECK(event.button == 7);
+    return event;
+  };
+
+  // Double tap: the sequence ends countInterval after the last release.
+  button.updateAt(1, 10'000);
+  button.updateAt(0, 60'000);
+  button.updateAt(1, 120'000);
+  button.updateAt(0, 170'000);
+  button.updateAt(0, 300'000);
+  button.updateAt(0, 400'000);
+
+  auto event = next();
+  CHECK(event.type == ButtonEventType::Press);
+  CHECK(event.timestampMicros == 10'000);
+  CHECK(next().type == ButtonEventType::Release);
+  CHECK(next().type == ButtonEventType::Press);
+  event = next();
+  CHECK(event.type == ButtonEventType::Release);
+  CHECK(event.timestampMicros == 170'000);
+  event = next();
+  CHECK(event.type == ButtonEventType::Tap);
+  CHECK(event.taps == 2);
+  CHECK(event.timestampMicros == 400'000);
+  CHECK(button.doubleTap == 1);
+  CHECK(events.empty());
+
+  // A hold reports its start and end, and no tap.
+  button.updateAt(1, 1'000'000);
+  button.updateAt(1, 2'500'000);
+  button.updateAt(1, 2'600'000);
+  button.updateAt(0, 3'000'000);
+  button.updateAt(0, 4'000'000);
+
+  CHECK(next().type == ButtonEventType::Press);
+  event = next();
+  CHECK(event.type == ButtonEventType::HoldStart);
+  CHECK(event.timestampMicros == 2'500'000);
+  CHECK(next().type == ButtonEventType::HoldEnd);
+  CHECK(next().type == ButtonEventType::Release);
+  CHECK(events.empty());
+  CHECK(button.droppedEvents == 0);
+}
+
+TEST_CASE("Button accepts an event ring of any capacity", "[descriptors][button]")
+{
+  ButtonEventRing<2> events;
+  Button button;
+  button.events = &events;
+  button.countInterval = 200;
+
+  // Press, release and tap: the tap does not fit.
+  button.updateAt(1, 10'000);
+  button.updateAt(0, 60'000);
+  button.updateAt(0, 400'000);
+  CHECK(events.size() == 2);
+  CHECK(button.droppedEvents == 1);
+
+  button.events = nullptr;
+  CHECK(button.events == nullptr);
+  button.updateAt(1, 500'000);
+  CHECK(button.droppedEvents == 1);
+}
+
+TEST_CASE("ButtonBank matches one Button per bit", "[descriptors][button]")
+{
+  constexpr size_t buttons = 12;
+  ButtonBank<buttons> bank;
+  bank.debounceInterval = 0;
+  bank.countInterval = 30;
+  bank.holdInterval = 120;
+
+  ButtonEventRing<> referenceEvents;
+  std::array<Button, buttons> reference;
+  for(size_t i = 0; i < buttons; ++i)
+  {
+    reference[i].countInterval = bank.countInterval;
+    reference[i].holdInterval = bank.holdInterval;
+    reference[i].events = &referenceEvents;
+    reference[i].id = uint8_t(i);
+  }
+
+  // 1 kHz scans of buttons held for random durations, from taps to holds.
+  // Halfway through, the clock steps back by 1.5 s, as after a device restart.
+  std::mt19937 rng(42);
+  std::array<int, buttons> remaining{};
+  uint64_t bits = 0;
+  size_t eventCount = 0;
+  for(uint64_t scan = 0; scan < 4000; ++scan)
+  {
+    for(size_t i = 0; i < buttons; ++i)
+    {
+      if(remaining[i]-- > 0)
+        continue;
+      bits ^= uint64_t(1) << i;
+      remaining[i] = (bits >> i) & 1 ? int(rng() % 200) : int(rng() % 80);
+    }
+    const uint64_t micros = 1'000'000 + 1'000 * scan - (scan >= 2000 ? 1'500'000 : 0);
+    bank.updateAt(bits, micros);
+    for(size_t i = 0; i < buttons; ++i)
+      reference[i].updateAt(int((bits >> i) & 1), micros);
+
+    ButtonEvent expected, measured;
+    while(referenceEvents.pop(expected))
+    {
+      REQUIRE(bank.events.pop(measured));
+      CHECK(measured.type == expected.type);
+      CHECK(measured.button == expected.button);
+      CHECK(measured.taps == expected.taps);
+      CHECK(measured.timestampMicros == expected.timestampMicros);
+      ++eventCount;
+    }
+    REQUIRE(bank.events.empty());
+    for(size_t i = 0; i < buttons; ++i)
+    {
+      CHECK(bool((bank.pressed() >> i) & 1) == reference[i].press);
+      CHECK(bool((bank.held() >> i) & 1) == reference[i].hold);
+    }
+  }
+  CHECK(eventCount > 500);
+  CHECK(bank.droppedEvents == 0);
+}
+
+TEST_CASE("ButtonBank restarts its intervals when the clock goes backwards", "[descriptors][button]")
+{
+  ButtonBank<2> bank;
+  bank.debounceInterval = 5;
+  Button reference;
+
+  // Button 0 is down when the clock steps back by 1 s; button 1 starts to
+  // settle just before the step.
+  bank.updateAt(0b01, 2'000'000);
+  reference.updateAt(1, 2'000'000);
+  bank.updateAt(0b01, 2'010'000);
+  reference.updateAt(1, 2'010'000);
+  bank.updateAt(0b11, 2'011'000);
+  bank.updateAt(0b11, 1'011'000);
+  reference.updateAt(1, 1'011'000);
+
+  // Neither a hold nor a debounced press of button 1 comes from the wrap.
+  CHECK(bank.held() == 0);
+  CHECK(!reference.hold);
+  CHECK(bank.pressed() == 0b01);
+
+  // The hold interval runs again from the step.
+  const uint64_t beforeHold = 1'011'000 + 1'000ULL * bank.holdInterval;
+  bank.updateAt(0b11, beforeHold);
+  reference.updateAt(1, beforeHold);
+  CHECK(bank.held() == 0);
+  CHECK(!reference.hold);
+  // Button 1 settled from the step and was accepted on the previous scan.
+  CHECK(bank.pressed() == 0b11);
+  bank.updateAt(0b11, beforeHold + 1'000);
+  reference.updateAt(1, beforeHold + 1'000);
+  CHECK(bank.held() == 0b01);
+  CHECK(reference.hold);
+}
+
+TEST_CASE("ButtonBank debounces contact bounce", "[descriptors][button]")
+{
+  ButtonBank<4> bank;
+  bank.debounceInterval = 5;
+
+  // Button 2 bounces for 3 ms, then stays down; button 0 glitches once.
+  const uint64_t scans[] = {0b0100, 0b0000, 0b0100, 0b0001, 0b0100, 0b0100, 0b0100,
+                            0b0100, 0b0100, 0b0100, 0b0100, 0b0100};
+  uint64_t micros = 0;
+  for(uint64_t bits : scans)
+    bank.updateAt(bits, micros += 1'000);
+
+  CHECK(bank.pressed() == 0b0100);
+  ButtonEvent event;
+  REQUIRE(bank.events.pop(event));
+  CHECK(event.type == ButtonEventType::Press);
+  CHECK(event.button == 2);
+  // Stable from the fifth scan (5 ms), accepted 5 ms later.
+  CHECK(event.timestampMicros == 10'000);
+  CHECK(bank.events.empty());
+}
+
+TEST_CASE("Block updates match per-sample updates", "[descriptors][batch]")
+{
+  const auto path = getTestDataPath("imu_data_jab_shake.csv");
+  REQUIRE(std::filesystem::exists(path));
+  rapidcsv::Document doc(path.string(), rapidcsv::LabelParams(0, -1));
+  const size_t rowCount = doc.GetRowCount();
+  REQUIRE(rowCount > 0);
+
+  std::vector<Coord3D> accel(rowCount);
+  for(size_t r = 0; r < rowCount; ++r)
+  {
+    accel[r].x = readCsvDouble(doc, "accl_x", r);
+    accel[r].y = readCsvDouble(doc, "accl_y", r);
+    accel[r].z = readCsvDouble(doc, "accl_z", r);
+  }
+
+  SECTION("Shake3D")
+  {
+    Shake3D single, block;
+    single.frequency(0);
+    block.frequency(0);
+
+    std::vector<Coord3D> out(rowCount);
+    REQUIRE(block.update(accel, out) == rowCount);
+    for(size_t r = 0; r < rowCount; ++r)
+    {
+      single.update(accel[r]);
+      const auto expected = single.current_value();
+      CHECK(out[r].x == expected.x);
+      CHECK(out[r].y == expected.y);
+      CHECK(out[r].z == expected.z);
+    }
+  }
+
+  SECTION("Shake writes the last reading to its tied input")
+  {
+    Coord1D tiedData{0.0};
+    Shake tiedShake(&tiedData);
+    tiedShake.frequency(0);
+    const std::vector<double> in{1.0, 2.0, 3.0};
+    std::vector<double> out(2);
+    // Only as many samples as the output can hold are processed.
+    REQUIRE(tiedShake.update(in, out) == 2);
+    CHECK(tiedData.x == 2.0);
+  }
+
+  SECTION("Jab3D")
+  {
+    Jab3D single, block;
+    single.threshold(1);
+    block.threshold(1);
+
+    std::vector<Coord3D> out(rowCount);
+    REQUIRE(block.update(accel, out) == rowCount);
+    for(size_t r = 0; r < rowCount; ++r)
+    {
+      single.update(accel[r]);
+      const auto expected = single.current_value();
+      CHECK(out[r].x == expected.x);
+      CHECK(out[r].y == expected.y);
+      CHECK(out[r].z == expected.z);
+    }
+  }
+
+  SECTION("Tilt_Roll")
+  {
+    Tilt_Roll single, block;
+    std::vector<Simple_Orientation> out(rowCount);
+    REQUIRE(block.update(accel, out) == rowCount);
+    for(size_t r = 0; r < rowCount; ++r)
+    {
+      single.update(accel[r]);
+      const auto expected = single.current_value();
+      CHECK(out[r].roll == expected.roll);
+      CHECK(out[r].tilt == expected.tilt);
+      CHECK(out[r].magnitude == expected.magnitude);
+    }
+    CHECK(block.current_roll_value() == single.current_roll_value());
+    CHECK(block.current_tilt_value() == single.current_tilt_value());
+  }
+
+  SECTION("Brush")
+  {
+    Brush single, block;
+    std::vector<double> in(rowCount), out(rowCount);
+    for(size_t r = 0; r < rowCount; ++r)
+      in[r] = accel[r].x * 0.1;
+
+    REQUIRE(block.update(in, out) == rowCount);
+    for(size_t r = 0; r < rowCount; ++r)
+    {
+      single.update(in[r]);
+      CHECK(out[r] == single.value);
+    }
+  }
+
+  SECTION("Button")
+  {
+    // Long intervals keep the outcome independent of the wall clock.
+    Button single, block;
+    single.countInterval = block.countInterval = 100000;
+    single.holdInterval = block.holdInterval = 100000;
+
+    const std::vector<int> in{0, 1, 1, 0, 1, 0, 0, 1};
+    std::vector<ButtonState> out(in.size());
+    REQUIRE(block.update(in, out) == in.size());
+    for(size_t i = 0; i < in.size(); ++i)
+    {
+      single.update(in[i]);
+      CHECK(out[i].press == single.press);
+      CHECK(out[i].count == single.count);
+      CHECK(out[i].hold == single.hold);
+    }
+    CHECK(out.back().count == 2);
+    CHECK(out.back().press == true);
+  }
+}
+
+TEST_CASE("ShakeBank and JabBank match per-device Shake3D and Jab3D", "[descriptors][bank]")
+{
+  const auto path = getTestDataPath("imu_data_jab_shake.csv");
+  REQUIRE(std::filesystem::exists(path));
+  rapidcsv::Document doc(path.string(), rapidcsv::LabelParams(0, -1));
+  const size_t rowCount = doc.GetRowCount();
+
+  // Each device sees the recording with a different gain and sign so that
+  // the channels diverge.
+  constexpr size_t devices = 5;
+  auto sample = [&](size_t device, size_t r) {
+    const double gain = (device % 2 == 0 ? 1.0 : -1.0) * (0.5 + 0.25 * device);
+    return Coord3D{
+        gain * readCsvDouble(doc, "accl_x", r), gain * readCsvDouble(doc, "accl_y", r),
+        gain * readCsvDouble(doc, "accl_z", r)};
+  };
+
+  SECTION("ShakeBank")
+  {
+    ShakeBank<devices> bank;
+    bank.frequency = 0;
+    bank.threshold = 2.0;
+    std::array<Shake3D, devices> reference;
+    for(auto& shake : reference)
+    {
+      shake.frequency(0);
+      shake.threshold(2.0);
+    }
+
+    std::array<Coord3D, devices> readings;
+    for(size_t r = 0; r < rowCount; ++r)
+    {
+      for(size_t d = 0; d < devices; ++d)
+      {
+        readings[d] = sample(d, r);
+        reference[d].update(readings[d]);
+      }
+      bank.update(readings);
+      for(size_t d = 0; d < devices; ++d)
+      {
+        const auto expected = reference[d].current_value();
+        const auto measured = bank.current_value(d);
+        CHECK(measured.x == expected.x);
+        CHECK(measured.y == expected.y);
+        CHECK(measured.z == expected.z);
+      }
+    }
+  }
+
+  SECTION("ShakeBank frequency gate")
+  {
+    // At 10 Hz, updates less than 100 ms apart accumulate without leaking.
+    ShakeBank<1> bank;
+    bank.threshold = 0.1;
+    const std::array<Coord3D, 1> moving{Coord3D{10.0, 0.0, 0.0}};
+    bank.updateAt(moving, 1'000'000);
+    CHECK(bank.current_value(0).x == Catch::Approx(1.0));
+    bank.updateAt(moving, 1'050'000);
+    CHECK(bank.current_value(0).x == Catch::Approx(2.0));
+    bank.updateAt(moving, 1'100'000);
+    CHECK(bank.current_value(0).x == Catch::Approx(1.0 + 2.0 * 0.6));
+  }
+
+  SECTION("ShakeBank restarts like Shake3D when timestamps go backwards")
+  {
+    // A looping replay: the second pass starts over at the first timestamp.
+    ShakeBank<devices> bank;
+    bank.threshold = 2.0;
+    std::array<Shake3D, devices> reference;
+    for(auto& shake : reference)
+      shake.threshold(2.0);
+
+    std::array<Coord3D, devices> readings;
+    for(int pass = 0; pass < 2; ++pass)
+    {
+      for(size_t r = 0; r < rowCount; ++r)
+      {
+        const uint64_t micros = 1'000'000 + uint64_t(5'000) * r;
+        for(size_t d = 0; d < devices; ++d)
+        {
+          readings[d] = sample(d, r);
+          reference[d].updateAt(readings[d], micros);
+        }
+        bank.updateAt(readings, micros);
+        for(size_t d = 0; d < devices; ++d)
+        {
+          const auto expected = reference[d].current_value();
+          const auto measured = bank.current_value(d);
+          CHECK(measured.x == expected.x);
+          CHECK(measured.y == expected.y);
+          CHECK(measured.z == expected.z);
+        }
+      }
+    }
+  }
+
+  SECTION("JabBank")
+  {
+    JabBank<devices> bank;
+    bank.threshold = 1;
+    std::array<Jab3D, devices> reference;
+    for(auto& jab : reference)
+      jab.threshold(1);
+
+    std::array<double, devices> x, y, z;
+    for(size_t r = 0; r < rowCount; ++r)
+    {
+      for(size_t d = 0; d < devices; ++d)
+      {
+        const auto s = sample(d, r);
+        x[d] = s.x;
+        y[d] = s.y;
+        z[d] = s.z;
+        reference[d].update(s);
+      }
+      bank.update(x, y, z);
+      for(size_t d = 0; d < devices; ++d)
+      {
+        const auto expected = reference[d].current_value();
+        const auto measured = bank.current_value(d);
+        CHECK(measured.x == expected.x);
+        CHECK(measured.y == expected.y);
+        CHECK(measured.z == expected.z);
+      }
+    }
+  }
+}
+
+TEST_CASE("BrushRubBank matches per-channel BrushRubDetector", "[descriptors][bank]")
+{
+  STATIC_REQUIRE(!std::is_polymorphic_v<Brush>);
+  STATIC_REQUIRE(!std::is_polymorphic_v<Rub>);
+
+  // Positions that hold still, creep, jump by more than one and go negative,
+  // at 1 ms steps so the 100 Hz gate both accumulates and leaks.
+  constexpr size_t channels = 4;
+  auto position = [](size_t channel, int frame) {
+    const int phase = (frame + 7 * int(channel)) % 60;
+    if(phase < 20)
+      return 0.1 * phase - double(channel);
+    if(phase < 35)
+      return 2.0;
+    if(phase < 40)
+      return 2.0 + 3.0 * (phase - 35);
+    return -0.05 * phase;
+  };
+
+  BrushRubBank<channels> bank;
+  std::array<BrushRubDetector, channels> reference;
+  std::array<double, channels> positions;
+  // The second half goes back in time to the first timestamp, as a looping
+  // replay or a restarted sensor does.
+  for(int frame = 0; frame < 1200; ++frame)
+  {
+    const uint64_t micros = 100'000 + 1'000 * uint64_t(frame % 600);
+    for(size_t c = 0; c < channels; ++c)
+    {
+      positions[c] = position(c, frame);
+      reference[c].updateAt(positions[c], micros);
+    }
+    bank.updateAt(positions, micros);
+    for(size_t c = 0; c < channels; ++c)
+    {
+      CHECK(bank.brushValue(c) == reference[c].brush.value);
+      CHECK(bank.rubValue(c) == reference[c].rub.value);
+    }
+  }
+  CHECK(bank.rubValue(0) > 0.0);
+
+  // The block update of a single detector replays the same values.
+  BrushRubDetector single, block;
+  std::vector<double> in(200), brushOut(in.size()), rubOut(in.size());
+  for(size_t i = 0; i < in.size(); ++i)
+    in[i] = position(1, int(i));
+  REQUIRE(block.update(in, brushOut, rubOut) == in.size());
+  for(size_t i = 0; i < in.size(); ++i)
+  {
+    single.update(in[i]);
+    CHECK(brushOut[i] == single.brush.value);
+    CHECK(rubOut[i] == single.rub.value);
+  }
+}
+
+TEST_CASE("Timestamped updates replay without reading the clock", "[descriptors][timestamp]")
+{
+  const auto path = getTestDataPath("imu_data_jab_shake.csv");
+  REQUIRE(std::filesystem::exists(path));
+  rapidcsv::Document doc(path.string(), rapidcsv::LabelParams(0, -1));
+  const size_t rowCount = doc.GetRowCount();
+
+  // 200 Hz timestamps: the 10 Hz integrator gate opens every 20th sample.
+  auto timestamp = [](size_t r) { return uint64_t(5'000) * r; };
+
+  SECTION("Shake3D runs twice to the same values and matches ShakeBank")
+  {
+    Shake3D first, second;
+    ShakeBank<1> bank;
+    first.threshold(2.0);
+    second.threshold(2.0);
+    bank.threshold = 2.0;
+
+    for(size_t r = 0; r < rowCount; ++r)
+    {
+      const Coord3D s{
+          readCsvDouble(doc, "accl_x", r), readCsvDouble(doc, "accl_y", r),
+          readCsvDouble(doc, "accl_z", r)};
+      first.updateAt(s, timestamp(r));
+      second.updateAt(s, timestamp(r));
+      bank.updateAt(std::array<Coord3D, 1>{s}, timestamp(r));
+
+      const auto expected = first.current_value();
+      CHECK(second.current_value().x == expected.x);
+      CHECK(bank.current_value(0).x == expected.x);
+      CHECK(bank.current_value(0).y == expected.y);
+      CHECK(bank.current_value(0).z == expected.z);
+    }
+  }
+
+  SECTION("Brush and Rub follow the sample times")
+  {
+    // 100 Hz integrator with 1 ms samples: nine samples out of ten accumulate.
+    BrushRubDetector detector;
+    double position = 0.0;
+    for(int i = 0; i < 10; ++i)
+    {
+      position += 0.1;
+      detector.updateAt(position, uint64_t(100'000 + 1'000 * i));
+    }
+    // The first sample leaks, the next nine add 0.015 each.
+    CHECK(detector.brush.value == Catch::Approx(0.15));
+    CHECK(detector.rub.value == Catch::Approx(0.15));
+  }
+}
+
+namespace
+{
+// Simulated accelerometer of device `device`, one sample every 10 ms.
+utils::ImuSample simulatedSample(std::size_t device, std::size_t index)
+{
+  const double t = 0.01 * double(index);
+  const double phase = 0.37 * double(device);
+  utils::ImuSample sample;
+  sample.timestampMicros = 10'000 * uint64_t(index);
+  sample.imu.accl = {
+      4.0 * std::sin(9.0 * t + phase), 2.0 * std::cos(5.0 * t + phase),
+      9.81 + std::sin(23.0 * t * (1.0 + 0.1 * double(device % 5)))};
+  return sample;
+}
+
+// Counts the blocks it receives, to check the span path.
+struct BlockCountingChain
+{
+  struct Output
+  {
+    std::size_t blocks = 0;
+    std::size_t samples = 0;
+  };
+  Output state;
+
+  void update(std::span<const utils::ImuSample> samples)
+  {
+    ++state.blocks;
+    state.samples += samples.size();
+  }
+  Output output() const { return state; }
+};
+}
+
+TEST_CASE("GestureEngine matches one chain per device", "[descriptors][engine]")
+{
+  constexpr std::size_t devices = 37;
+  constexpr std::size_t rounds = 4;
+
+  for(std::size_t threads : {1, 2, 4})
+  {
+    GestureEngine<> engine(threads);
+    REQUIRE(engine.threadCount() == threads);
+    std::vector<ImuGestureChain> reference(devices);
+    std::vector<std::size_t> sent(devices, 0);
+    for(std::size_t d = 0; d < devices; ++d)
+      REQUIRE(engine.addDevice() == d);
+
+    for(std::size_t round = 0; round < rounds; ++round)
+    {
+      // The first devices are much busier, so the other threads steal them.
+      std::size_t expected = 0;
+      for(std::size_t d = 0; d < devices; ++d)
+      {
+        const std::size_t count = d < 6 ? 200 : (d * 7 + round) % 13;
+        std::vector<utils::ImuSample> samples;
+        for(std::size_t i = 0; i < count; ++i)
+          samples.push_back(simulatedSample(d, sent[d]++));
+        REQUIRE(engine.ingest(d, samples) == count);
+        for(const auto& sample : samples)
+          reference[d].update(sample);
+        expected += count;
+      }
+      REQUIRE(engine.process() == expected);
+
+      bool matches = true;
+      for(std::size_t d = 0; d < devices; ++d)
+      {
+        ImuGestureChain::Output out;
+        engine.snapshot(d, out);
+        const auto want = reference[d].output();
+        matches = matches && out.timestampMicros == want.timestampMicros
+                  && out.shake.x == want.shake.x && out.shake.z == want.shake.z
+                  && out.jab.y == want.jab.y && out.tilt == want.tilt
+                  && out.roll == want.roll;
+      }
+      CHECK(matches);
+    }
+    CHECK(engine.process() == 0);
+  }
+}
+
+TEST_CASE("GestureEngine feeds blocks and counts dropped samples", "[descriptors][engine]")
+{
+  GestureEngine<BlockCountingChain, 128> engine(2);
+  engine.addDevice();
+  engine.addDevice();
+
+  std::vector<utils::ImuSample> samples(150);
+  CHECK(engine.ingest(0, samples) == 128);
+  CHECK(engine.droppedSamples(0) == 22);
+  CHECK(engine.ingest(1, std::span(samples).first(10)) == 10);
+  CHECK(engine.droppedSamples(1) == 0);
+  CHECK(engine.process() == 138);
+
+  BlockCountingChain::Output out;
+  CHECK(engine.snapshot(0, out) == 1);
+  CHECK(out.samples == 128);
+  CHECK(out.blocks == 2);
+  CHECK(engine.snapshot(1, out) == 1);
+  CHECK(out.samples == 10);
+  CHECK(out.blocks == 1);
+
+  // A round without samples for a device does not republish it.
+  engine.ingest(1, std::span(samples).first(3));
+  CHECK(engine.process() == 3);
+  CHECK(engine.snapshot(0, out) == 1);
+  CHECK(engine.snapshot(1, out) == 2);
+  CHECK(out.samples == 13);
+}
+
+TEST_CASE("Descriptor states publish through a Seqlock", "[descriptors][snapshot]")
+{
+  TouchArrayGestureDetector<4, 2> touch;
+  int stripes[8] = {0, 1, 1, 0, 0, 0, 1, 1};
+  touch.updateAt(stripes, 8, 1000);
+  utils::Seqlock<TouchArrayState> touchOutput;
+  touchOutput.write(touch.state());
+
+  const TouchArrayState state = touchOutput.read();
+  CHECK(touchOutput.version() == 1);
+  CHECK(state.totalTouchAverage == touch.totalTouchAverage);
+  CHECK(state.bottomTouchAverage == touch.bottomTouchAverage);
+  CHECK(state.totalBrush == touch.totalBrush);
+  CHECK(state.totalRub == touch.totalRub);
+
+  Button button;
+  button.updateAt(1, 0);
+  utils::Seqlock<ButtonState> buttonOutput(button.state());
+  CHECK(buttonOutput.read().press);
+}
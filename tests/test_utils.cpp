@@ -1,7 +1,19 @@
 #include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <span>
 #include <cmath>
 #include <puara/utils.h>
+#include <puara/utils/imuReplay.h>
+#include <rapidcsv.h>
 #include <thread>
+#include <vector>
 
 using namespace Catch;
 using namespace puara_gestures::utils;
@@ -62,6 +74,61 @@ TEST_CASE("bitShiftArrayL works as shift register with carry from next cell", "[
         REQUIRE(shifted2[i] == expected2[i]);
     }
 }
+// Bit-by-bit reference for bitShiftLeft/bitShiftRight: a big-endian bit stream.
+template <typename T>
+static std::vector<T> referenceShift(const std::vector<T>& in, std::size_t shift, bool left)
+{
+    constexpr std::size_t digits = std::numeric_limits<T>::digits;
+    const std::size_t total = in.size() * digits;
+    const auto bitAt = [&](std::size_t pos) {
+        return (in[pos / digits] >> (digits - 1 - pos % digits)) & 1u;
+    };
+    std::vector<T> out(in.size(), 0);
+    for (std::size_t pos = 0; pos < total; ++pos) {
+        const std::size_t from = left ? pos + shift : pos - shift;
+        const bool inside = left ? from < total : pos >= shift;
+        if (inside && bitAt(from))
+            out[pos / digits] |= T(T(1) << (digits - 1 - pos % digits));
+    }
+    return out;
+}
+
+TEMPLATE_TEST_CASE("bitShiftLeft and bitShiftRight match a bit-by-bit shift", "[utils]",
+                   uint8_t, uint32_t, uint64_t)
+{
+    constexpr std::size_t digits = std::numeric_limits<TestType>::digits;
+    std::mt19937_64 rng(digits);
+    for (std::size_t size : {1u, 2u, 5u, 16u}) {
+        std::vector<TestType> in(size);
+        for (auto& word : in)
+            word = static_cast<TestType>(rng());
+        for (std::size_t shift = 0; shift <= size * digits + 3; ++shift) {
+            auto left = in;
+            bitShiftLeft(std::span(left), shift);
+            REQUIRE(left == referenceShift(in, shift, true));
+
+            auto right = in;
+            bitShiftRight(std::span(right), shift);
+            REQUIRE(right == referenceShift(in, shift, false));
+        }
+    }
+}
+
+TEST_CASE("bitShiftLeft on bytes matches bitShiftArrayL", "[utils]")
+{
+    int legacyIn[] = {0x12, 0xf4, 0x56, 0x80, 0x01};
+    for (int shift = 0; shift < 12; ++shift) {
+        int legacy[5];
+        bitShiftArrayL(legacyIn, legacy, 5, shift);
+
+        uint8_t bytes[5];
+        std::copy(std::begin(legacyIn), std::end(legacyIn), bytes);
+        bitShiftLeft<uint8_t>(bytes, shift);
+        for (int i = 0; i < 5; ++i)
+            REQUIRE(bytes[i] == (legacy[i] & 0xff));
+    }
+}
+
 TEST_CASE("unit conversion helpers", "[utils]")
 {
     using namespace puara_gestures::utils::convert;
@@ -165,6 +232,42 @@ TEST_CASE("phased spherical/cartesian round trip", "[utils]")
     REQUIRE(p1rt.elevation == Approx(0.0).margin(1e-15));
 }
 
+TEST_CASE("Spherical conversions over spans match the per-point versions", "[utils]")
+{
+    using namespace puara_gestures::utils::convert;
+
+    std::vector<puara_gestures::Coord3D> points;
+    for (int i = 0; i < 16; ++i) {
+        points.push_back({std::cos(0.4 * i), std::sin(0.3 * i), 0.5 * i - 3.0});
+    }
+
+    std::vector<puara_gestures::Spherical> spheric(points.size());
+    std::vector<puara_gestures::Coord3D> back(points.size());
+    REQUIRE(cartesian_to_spheric(points, spheric) == points.size());
+    REQUIRE(spheric_to_cartesian(spheric, back) == points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        const auto expected = cartesian_to_spheric(points[i]);
+        REQUIRE(spheric[i].r == expected.r);
+        REQUIRE(spheric[i].elevation == expected.elevation);
+        REQUIRE(spheric[i].azimuth == expected.azimuth);
+        REQUIRE(back[i].x == Approx(points[i].x).margin(1e-12));
+        REQUIRE(back[i].y == Approx(points[i].y).margin(1e-12));
+        REQUIRE(back[i].z == Approx(points[i].z).margin(1e-12));
+    }
+
+    REQUIRE(phased_cartesian_to_spheric(points, spheric) == points.size());
+    REQUIRE(phased_spheric_to_cartesian(spheric, back) == points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        REQUIRE(spheric[i].azimuth == phased_cartesian_to_spheric(points[i]).azimuth);
+        REQUIRE(back[i].x == Approx(points[i].x).margin(1e-12));
+        REQUIRE(back[i].y == Approx(points[i].y).margin(1e-12));
+        REQUIRE(back[i].z == Approx(points[i].z).margin(1e-12));
+    }
+
+    // The shorter span bounds the work.
+    REQUIRE(cartesian_to_spheric(std::span(points).first(5), spheric) == 5);
+}
+
 //blobDetector.h
 TEST_CASE("BlobDetector handles empty array", "[blobDetector]")
 {
@@ -233,6 +336,323 @@ TEST_CASE("BlobDetector handles full array blob", "[blobDetector]")
     REQUIRE(detector.blobSize[0] == 4);
     REQUIRE(detector.blobCenter[0] == Approx(1.5));
 }
+TEST_CASE("BlobDetector finds the same blobs in a bit-packed array", "[blobDetector]")
+{
+    // Sizes around the word boundaries, with runs that cross them.
+    for (int size : {1, 7, 63, 64, 65, 120, 128, 200}) {
+        std::minstd_rand rng(size);
+        for (int frame = 0; frame < 50; ++frame) {
+            std::vector<int> touch(size);
+            int value = 0;
+            for (int i = 0; i < size; ++i) {
+                if (rng() % 5 == 0)
+                    value = 1 - value;
+                touch[i] = value;
+            }
+            std::vector<uint64_t> bits(puara_gestures::utils::bitWordCount(size));
+            puara_gestures::utils::packBits(touch.data(), size, bits.data());
+
+            puara_gestures::BlobDetector<8> fromInts;
+            puara_gestures::BlobDetector<8> fromBits;
+            fromInts.detect1D(touch.data(), size);
+            fromBits.detect1D(bits.data(), size);
+
+            REQUIRE(fromBits.blobCount == fromInts.blobCount);
+            for (int b = 0; b < 8; ++b) {
+                REQUIRE(fromBits.blobStartPos[b] == fromInts.blobStartPos[b]);
+                REQUIRE(fromBits.blobSize[b] == fromInts.blobSize[b]);
+                REQUIRE(fromBits.blobCenter[b] == fromInts.blobCenter[b]);
+            }
+
+            const int start = size / 3;
+            REQUIRE(puara_gestures::utils::countBits(bits.data(), start, size)
+                    == std::count(touch.begin() + start, touch.end(), 1));
+        }
+    }
+}
+
+// Packs a grid drawn with '#' for touched cells, one string per row.
+template <std::size_t rows>
+static std::vector<uint64_t> packGrid(const char* const (&picture)[rows], int cols)
+{
+    const int rowWords = puara_gestures::utils::bitWordCount(cols);
+    std::vector<uint64_t> bits(rows * rowWords);
+    std::vector<int> row(cols);
+    for (std::size_t r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c)
+            row[c] = picture[r][c] == '#' ? 1 : 0;
+        puara_gestures::utils::packBits(row.data(), cols, bits.data() + r * rowWords);
+    }
+    return bits;
+}
+
+TEST_CASE("BlobDetector detect2D labels 8-connected regions", "[blobDetector]")
+{
+    // The U merges on its last row, the diagonal pair is one region, and the
+    // lone cell at the bottom right is a third one.
+    const char* const picture[] = {
+        "#..#......",
+        "#..#...#..",
+        "####....#.",
+        "..........",
+        ".........#",
+    };
+    const auto grid = packGrid(picture, 10);
+
+    puara_gestures::BlobDetector<4, 16> detector;
+    REQUIRE(detector.detect2D(grid.data(), 5, 10));
+    REQUIRE(detector.blobCount == 3);
+
+    const auto& u = detector.blobs[0];
+    REQUIRE(u.area == 8);
+    REQUIRE(u.minX == 0);
+    REQUIRE(u.maxX == 3);
+    REQUIRE(u.minY == 0);
+    REQUIRE(u.maxY == 2);
+    REQUIRE(u.centroidX == Approx(1.5));
+    REQUIRE(u.centroidY == Approx(10.0 / 8.0));
+
+    const auto& diagonal = detector.blobs[1];
+    REQUIRE(diagonal.area == 2);
+    REQUIRE(diagonal.centroidX == Approx(7.5));
+    REQUIRE(diagonal.centroidY == Approx(1.5));
+    REQUIRE(diagonal.minY == 1);
+    REQUIRE(diagonal.maxY == 2);
+
+    const auto& lone = detector.blobs[2];
+    REQUIRE(lone.area == 1);
+    REQUIRE(lone.minX == 9);
+    REQUIRE(lone.maxX == 9);
+    REQUIRE(lone.centroidY == Approx(4.0));
+
+    REQUIRE(u.id != diagonal.id);
+    REQUIRE(diagonal.id != lone.id);
+}
+
+TEST_CASE("BlobDetector detect2D merges a region reached from both sides", "[blobDetector]")
+{
+    // Two arms are labeled separately until the bottom row joins them; a run
+    // over several rows of the previous row must merge them all.
+    const char* const picture[] = {
+        "#.#.#.#.",
+        "#.#.#.#.",
+        "########",
+    };
+    const auto grid = packGrid(picture, 8);
+
+    puara_gestures::BlobDetector<2, 8> detector;
+    REQUIRE(detector.detect2D(grid.data(), 3, 8));
+    REQUIRE(detector.blobCount == 1);
+    REQUIRE(detector.blobs[0].area == 16);
+    REQUIRE(detector.blobs[0].maxX == 7);
+}
+
+TEST_CASE("BlobDetector detect2D matches a flood fill on random grids", "[blobDetector]")
+{
+    constexpr int side = 32;
+    constexpr int maxBlobs = 64;
+    std::minstd_rand rng(2024);
+    for (int frame = 0; frame < 40; ++frame) {
+        std::vector<int> cells(side * side);
+        for (auto& cell : cells)
+            cell = static_cast<int>(rng() % 100) < 20 + frame ? 1 : 0;
+        std::vector<uint64_t> grid(side);
+        for (int r = 0; r < side; ++r)
+            puara_gestures::utils::packBits(cells.data() + r * side, side, &grid[r]);
+
+        // Reference: flood fill from each unvisited cell in raster order.
+        std::vector<int> label(cells.size(), -1);
+        std::vector<puara_gestures::Blob2D> expected;
+        for (int start = 0; start < side * side; ++start) {
+            if (!cells[start] || label[start] >= 0)
+                continue;
+            puara_gestures::Blob2D blob{0, 0, 0, 0, side, side, -1, -1};
+            std::vector<int> stack{start};
+            label[start] = int(expected.size());
+            while (!stack.empty()) {
+                const int cell = stack.back();
+                stack.pop_back();
+                const int x = cell % side, y = cell / side;
+                blob.area += 1;
+                blob.minX = std::min(blob.minX, x);
+                blob.maxX = std::max(blob.maxX, x);
+                blob.minY = std::min(blob.minY, y);
+                blob.maxY = std::max(blob.maxY, y);
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        const int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= side || ny >= side)
+                            continue;
+                        const int next = ny * side + nx;
+                        if (cells[next] && label[next] < 0) {
+                            label[next] = label[start];
+                            stack.push_back(next);
+                        }
+                    }
+            }
+            expected.push_back(blob);
+        }
+
+        puara_gestures::BlobDetector<maxBlobs, side> detector;
+        REQUIRE(detector.detect2D(grid.data(), side, side));
+        REQUIRE(detector.blobCount == std::min<int>(maxBlobs, int(expected.size())));
+        for (int i = 0; i < detector.blobCount; ++i) {
+            REQUIRE(detector.blobs[i].area == expected[i].area);
+            REQUIRE(detector.blobs[i].minX == expected[i].minX);
+            REQUIRE(detector.blobs[i].maxX == expected[i].maxX);
+            REQUIRE(detector.blobs[i].minY == expected[i].minY);
+            REQUIRE(detector.blobs[i].maxY == expected[i].maxY);
+        }
+    }
+}
+
+TEST_CASE("BlobDetector detect2D keeps the first maxNumBlobs regions", "[blobDetector]")
+{
+    const char* const picture[] = {
+        "#.#.#",
+        ".....",
+        "#.#.#",
+    };
+    const auto grid = packGrid(picture, 5);
+
+    puara_gestures::BlobDetector<4, 8> detector;
+    REQUIRE(detector.detect2D(grid.data(), 3, 5));
+    REQUIRE(detector.blobCount == 4);
+    REQUIRE(detector.blobs[3].minX == 0);
+    REQUIRE(detector.blobs[3].minY == 2);
+
+    // Larger than maxGridSide.
+    std::vector<uint64_t> big(9, 1);
+    REQUIRE_FALSE(detector.detect2D(big.data(), 9, 9));
+    REQUIRE(detector.blobCount == 0);
+}
+
+TEST_CASE("BlobDetector detect2D keeps blob ids across frames", "[blobDetector]")
+{
+    const char* const frame1[] = {
+        "##......",
+        "##......",
+        "......##",
+        "......##",
+    };
+    // Both fingers moved one cell; the right one is now above the left one
+    // in raster order.
+    const char* const frame2[] = {
+        ".....##.",
+        ".##..##.",
+        ".##.....",
+        "........",
+    };
+    // A third finger lands.
+    const char* const frame3[] = {
+        ".....##.",
+        ".##..##.",
+        ".##.....",
+        ".......#",
+    };
+
+    puara_gestures::BlobDetector<4, 8> detector;
+    detector.detect2D(packGrid(frame1, 8).data(), 4, 8);
+    REQUIRE(detector.blobCount == 2);
+    const int left = detector.blobs[0].id;
+    const int right = detector.blobs[1].id;
+    REQUIRE(left != right);
+
+    detector.detect2D(packGrid(frame2, 8).data(), 4, 8);
+    REQUIRE(detector.blobCount == 2);
+    REQUIRE(detector.prevBlobCount == 2);
+    REQUIRE(detector.blobs[0].id == right);
+    REQUIRE(detector.blobs[1].id == left);
+
+    detector.detect2D(packGrid(frame3, 8).data(), 4, 8);
+    REQUIRE(detector.blobCount == 3);
+    REQUIRE(detector.blobs[0].id == right);
+    REQUIRE(detector.blobs[1].id == left);
+    REQUIRE(detector.blobs[2].id != left);
+    REQUIRE(detector.blobs[2].id != right);
+}
+
+TEST_CASE("matchNearest pairs the closest points first", "[blobDetector]")
+{
+    constexpr int maxCount = 64;
+    std::minstd_rand rng(7);
+    for (int round = 0; round < 200; ++round) {
+        const int currentCount = int(rng() % (maxCount + 1));
+        const int previousCount = int(rng() % (maxCount + 1));
+        // Integer coordinates on a small grid, so that ties are common.
+        std::vector<int> current(currentCount), previous(previousCount);
+        for (auto& x : current)
+            x = int(rng() % 40);
+        for (auto& x : previous)
+            x = int(rng() % 40);
+        auto distanceSq = [&](int c, int p) {
+            const float d = float(current[c] - previous[p]);
+            return d * d;
+        };
+        const float maxDistance = float(rng() % 6);
+
+        // Reference: all pairs in range, stably sorted by distance.
+        struct Pair { float d; int c, p; };
+        std::vector<Pair> pairs;
+        for (int c = 0; c < currentCount; ++c)
+            for (int p = 0; p < previousCount; ++p)
+                if (distanceSq(c, p) <= maxDistance * maxDistance)
+                    pairs.push_back({distanceSq(c, p), c, p});
+        std::stable_sort(pairs.begin(), pairs.end(),
+                         [](const Pair& a, const Pair& b) { return a.d < b.d; });
+        std::vector<int> expected(currentCount, -1);
+        std::vector<bool> taken(previousCount);
+        for (const auto& pair : pairs) {
+            if (expected[pair.c] >= 0 || taken[pair.p])
+                continue;
+            expected[pair.c] = pair.p;
+            taken[pair.p] = true;
+        }
+
+        int match[maxCount];
+        puara_gestures::detail::matchNearest<maxCount>(
+            currentCount, previousCount, maxDistance, distanceSq, match);
+        for (int c = 0; c < currentCount; ++c)
+            REQUIRE(match[c] == expected[c]);
+    }
+}
+
+TEST_CASE("matchNearestSorted pairs points on a line like matchNearest", "[blobDetector]")
+{
+    constexpr int maxCount = 64;
+    std::minstd_rand rng(11);
+    // Strictly increasing half-integer positions, like detect1D centers.
+    auto positions = [&rng](int count) {
+        std::vector<float> result(count);
+        float x = float(rng() % 4) * 0.5f;
+        for (auto& position : result) {
+            position = x;
+            x += float(1 + rng() % 6) * 0.5f;
+        }
+        return result;
+    };
+    for (int round = 0; round < 500; ++round) {
+        const auto current = positions(int(rng() % (maxCount + 1)));
+        const auto previous = positions(int(rng() % (maxCount + 1)));
+        const int currentCount = int(current.size());
+        const int previousCount = int(previous.size());
+        const float maxDistance = float(rng() % 12) * 0.5f;
+        auto distanceSq = [&](int c, int p) {
+            const float d = current[c] - previous[p];
+            return d * d;
+        };
+
+        int expected[maxCount];
+        puara_gestures::detail::matchNearest<maxCount>(
+            currentCount, previousCount, maxDistance, distanceSq, expected);
+        int match[maxCount];
+        puara_gestures::detail::matchNearestSorted<maxCount>(
+            current.data(), currentCount, previous.data(), previousCount, maxDistance, match);
+        for (int c = 0; c < currentCount; ++c)
+            REQUIRE(match[c] == expected[c]);
+    }
+}
+
 // calibration.h not is this file
 
 // chrono.h
@@ -263,6 +683,270 @@ TEST_CASE("CircularBuffer retains most recent values", "[utils]")
     REQUIRE(buf.buffer[2] == Approx(2.0));
 }
 
+TEST_CASE("Fixed-capacity CircularBuffer wraps and exposes contiguous segments", "[utils]")
+{
+    puara_gestures::utils::CircularBuffer<int, 3> buf;
+    STATIC_REQUIRE(buf.capacity() == 3);
+    STATIC_REQUIRE(buf.storage_size == 4);
+    REQUIRE(buf.empty());
+
+    auto collect = [&buf] {
+        std::vector<int> values;
+        for (auto segment : buf.segments())
+            values.insert(values.end(), segment.begin(), segment.end());
+        return values;
+    };
+
+    buf.add(1);
+    buf.add(2);
+    REQUIRE(buf.size() == 2);
+    REQUIRE(collect() == std::vector<int>{1, 2});
+
+    // Keep pushing until the stored range wraps around the end of the storage.
+    for (int v = 3; v <= 6; ++v)
+        buf.add(v);
+
+    REQUIRE(buf.full());
+    REQUIRE(buf.size() == 3);
+    REQUIRE(buf[0] == 6);
+    REQUIRE(buf[1] == 5);
+    REQUIRE(buf[2] == 4);
+    REQUIRE(buf.front() == 6);
+    REQUIRE(buf.back() == 4);
+    REQUIRE(buf.segments()[1].size() > 0);
+    REQUIRE(collect() == std::vector<int>{4, 5, 6});
+
+    buf.clear();
+    REQUIRE(buf.empty());
+    REQUIRE(collect().empty());
+}
+
+// spscRing.h
+TEST_CASE("SpscRing is a bounded FIFO", "[utils][spsc]")
+{
+    SpscRing<int, 4> ring;
+    int value = 0;
+    REQUIRE(ring.empty());
+    REQUIRE_FALSE(ring.pop(value));
+
+    // Several laps around the storage.
+    int next = 0, expected = 0;
+    for(int lap = 0; lap < 5; ++lap)
+    {
+        while(ring.push(next))
+            ++next;
+        REQUIRE(ring.size() == 4);
+        REQUIRE(ring.pop(value));
+        REQUIRE(value == expected++);
+        REQUIRE(ring.pop(value));
+        REQUIRE(value == expected++);
+        REQUIRE(ring.size() == 2);
+    }
+    while(ring.pop(value))
+        REQUIRE(value == expected++);
+    REQUIRE(expected == next);
+}
+
+TEST_CASE("SpscRing hands values between two threads in order", "[utils][spsc]")
+{
+    constexpr uint32_t count = 200000;
+    SpscRing<uint32_t, 64> ring;
+
+    std::thread producer([&] {
+        for(uint32_t i = 0; i < count;)
+            if(ring.push(i))
+                ++i;
+            else
+                std::this_thread::yield();
+    });
+
+    uint32_t expected = 0;
+    bool inOrder = true;
+    while(expected < count)
+    {
+        uint32_t value;
+        if(ring.pop(value))
+            inOrder = inOrder && value == expected++;
+        else
+            std::this_thread::yield();
+    }
+    producer.join();
+
+    REQUIRE(inOrder);
+    REQUIRE(ring.empty());
+}
+
+TEST_CASE("SpscRing moves blocks with one index update", "[utils][spsc]")
+{
+    Imu9AxisRing<8> ring;
+    std::vector<puara_gestures::Imu9Axis> in(12), out(12);
+    for(std::size_t i = 0; i < in.size(); ++i)
+        in[i].accl.x = double(i);
+
+    // Only the free slots are filled.
+    REQUIRE(ring.push(std::span<const puara_gestures::Imu9Axis>(in).first(5)) == 5);
+    REQUIRE(ring.push(std::span<const puara_gestures::Imu9Axis>(in).subspan(5)) == 3);
+    REQUIRE(ring.size() == 8);
+    REQUIRE(ring.pop(std::span(out).first(6)) == 6);
+
+    // Wraps around the storage.
+    REQUIRE(ring.push(std::span<const puara_gestures::Imu9Axis>(in).subspan(8)) == 4);
+    REQUIRE(ring.pop(std::span(out).subspan(6)) == 6);
+    REQUIRE(ring.empty());
+    REQUIRE(ring.pop(std::span(out)) == 0);
+
+    for(std::size_t i = 0; i < out.size(); ++i)
+        CHECK(out[i].accl.x == double(i));
+}
+
+// tripleBuffer.h
+TEST_CASE("TripleBuffer hands over the latest value", "[utils][spsc]")
+{
+    TripleBuffer<int> buffer;
+    REQUIRE_FALSE(buffer.update());
+    REQUIRE(buffer.read() == 0);
+
+    buffer.write(1);
+    buffer.write(2);
+    REQUIRE(buffer.update());
+    REQUIRE(buffer.read() == 2);
+    REQUIRE_FALSE(buffer.update());
+    REQUIRE(buffer.read() == 2);
+
+    buffer.writeBuffer() = 3;
+    REQUIRE(buffer.read() == 2);
+    buffer.publish();
+    REQUIRE(buffer.update());
+    REQUIRE(buffer.read() == 3);
+}
+
+TEST_CASE("TripleBuffer readers never see a torn value", "[utils][spsc]")
+{
+    struct Outputs
+    {
+        uint64_t sequence = 0;
+        double values[15]{};
+    };
+    constexpr uint64_t count = 100000;
+    TripleBuffer<Outputs> buffer;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&] {
+        for(uint64_t i = 1; i <= count; ++i)
+        {
+            Outputs& out = buffer.writeBuffer();
+            out.sequence = i;
+            std::fill(std::begin(out.values), std::end(out.values), double(i));
+            buffer.publish();
+            if(i % 64 == 0)
+                std::this_thread::yield();
+        }
+        done = true;
+    });
+
+    uint64_t last = 0;
+    bool consistent = true;
+    for(;;)
+    {
+        // Everything is published before done is set.
+        const bool finished = done;
+        if(buffer.update())
+        {
+            const Outputs& out = buffer.read();
+            consistent = consistent && out.sequence > last
+                         && std::all_of(std::begin(out.values), std::end(out.values),
+                                        [&](double v) { return v == double(out.sequence); });
+            last = out.sequence;
+        }
+        else if(finished)
+            break;
+        else
+            std::this_thread::yield();
+    }
+    writer.join();
+
+    REQUIRE(consistent);
+    REQUIRE(buffer.read().sequence == count);
+}
+
+// seqlock.h
+TEST_CASE("Seqlock versions its value", "[utils][spsc]")
+{
+    Seqlock<puara_gestures::Coord3D> published(puara_gestures::Coord3D{1.0, 2.0, 3.0});
+    puara_gestures::Coord3D value;
+    REQUIRE(published.version() == 0);
+    REQUIRE(published.read(value) == 0);
+    REQUIRE(value.z == 3.0);
+
+    published.write({4.0, 5.0, 6.0});
+    published.write({7.0, 8.0, 9.0});
+    REQUIRE(published.version() == 2);
+    REQUIRE(published.tryRead(value));
+    REQUIRE(value.x == 7.0);
+    REQUIRE(published.read().y == 8.0);
+}
+
+TEST_CASE("Seqlock readers never see a torn value", "[utils][spsc]")
+{
+    // Larger than a cache line, so a copy spans several words and lines.
+    struct Outputs
+    {
+        uint64_t sequence = 0;
+        double values[13]{};
+        uint64_t check = 0;
+    };
+    constexpr uint64_t count = 50000;
+    constexpr int readers = 3;
+    Seqlock<Outputs> published;
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> threads;
+    std::vector<int> consistent(readers, 1);
+    std::vector<uint64_t> reads(readers, 0);
+    for(int r = 0; r < readers; ++r)
+        threads.emplace_back([&, r] {
+            uint64_t lastVersion = 0, lastSequence = 0;
+            while(!done.load(std::memory_order_relaxed))
+            {
+                Outputs out;
+                const uint64_t version = published.read(out);
+                // Version 0 is the default-constructed value.
+                const bool whole
+                    = version == 0
+                      || (out.check == ~out.sequence && out.sequence == version
+                          && std::all_of(std::begin(out.values), std::end(out.values),
+                                         [&](double v) { return v == double(out.sequence); }));
+                consistent[r] = consistent[r] && whole && version >= lastVersion
+                                && out.sequence >= lastSequence;
+                lastVersion = version;
+                lastSequence = out.sequence;
+                ++reads[r];
+                std::this_thread::yield();
+            }
+        });
+
+    Outputs out;
+    for(uint64_t i = 1; i <= count; ++i)
+    {
+        out.sequence = i;
+        std::fill(std::begin(out.values), std::end(out.values), double(i));
+        out.check = ~i;
+        published.write(out);
+        if(i % 64 == 0)
+            std::this_thread::yield();
+    }
+    done = true;
+    for(auto& thread : threads)
+        thread.join();
+
+    for(int r = 0; r < readers; ++r)
+    {
+        CHECK(consistent[r]);
+        CHECK(reads[r] > 0);
+    }
+    CHECK(published.read().sequence == count);
+}
+
 // discretizer.h
 TEST_CASE("Discretizer detects changes in data flow", "[utils]")
 {
@@ -278,6 +962,83 @@ TEST_CASE("Discretizer detects changes in data flow", "[utils]")
 
 }
 
+// fastmath.h
+// Sweeps the whole domain against libm, evaluated in double, and asserts the
+// bounds documented in fastmath.h.
+template <typename T>
+struct FastMathBounds;
+
+template <>
+struct FastMathBounds<float>
+{
+    static constexpr double rsqrt = 2e-7, atan = 4e-7, atan2 = 6e-7, asin = 1e-6;
+};
+
+template <>
+struct FastMathBounds<double>
+{
+    static constexpr double rsqrt = 5e-16, atan = 1e-9, atan2 = 1e-9, asin = 3e-10;
+};
+
+TEMPLATE_TEST_CASE("fastmath approximations stay within their documented error", "[utils][fastmath]",
+                   float, double)
+{
+    namespace fm = puara_gestures::fastmath;
+    using Bounds = FastMathBounds<TestType>;
+    constexpr int steps = 200000;
+
+    double rsqrtError = 0.0, atanError = 0.0, atan2Error = 0.0, asinError = 0.0;
+    for (int i = 0; i <= steps; ++i)
+    {
+        const double u = static_cast<double>(i) / steps;
+
+        const auto x = static_cast<TestType>(std::pow(10.0, -20.0 + 40.0 * u));
+        rsqrtError = std::max(rsqrtError, std::abs(double(fm::rsqrt(x)) * std::sqrt(double(x)) - 1.0));
+
+        const auto t = static_cast<TestType>(-50.0 + 100.0 * u);
+        atanError = std::max(atanError, std::abs(double(fm::atan(t)) - std::atan(double(t))));
+
+        const double angle = -M_PI + 2.0 * M_PI * u;
+        const auto ry = static_cast<TestType>(3.0 * std::sin(angle));
+        const auto rx = static_cast<TestType>(3.0 * std::cos(angle));
+        atan2Error = std::max(
+            atan2Error, std::abs(double(fm::atan2(ry, rx)) - std::atan2(double(ry), double(rx))));
+
+        const auto s = static_cast<TestType>(-1.0 + 2.0 * u);
+        asinError = std::max(asinError, std::abs(double(fm::asin(s)) - std::asin(double(s))));
+    }
+
+    INFO("rsqrt " << rsqrtError << ", atan " << atanError << ", atan2 " << atan2Error
+                  << ", asin " << asinError);
+    CHECK(rsqrtError < Bounds::rsqrt);
+    CHECK(atanError < Bounds::atan);
+    CHECK(atan2Error < Bounds::atan2);
+    CHECK(asinError < Bounds::asin);
+}
+
+TEST_CASE("fastmath edge cases", "[utils][fastmath]")
+{
+    namespace fm = puara_gestures::fastmath;
+
+    REQUIRE(fm::atan2(0.0, 0.0) == 0.0);
+    REQUIRE(fm::atan2(0.0f, -1.0f) == Approx(M_PI));
+    REQUIRE(fm::atan2(1.0, 0.0) == Approx(M_PI_2));
+    REQUIRE(fm::atan2(-1.0, 0.0) == Approx(-M_PI_2));
+    REQUIRE(fm::atan2(-1.0, -1.0) == Approx(-0.75 * M_PI));
+
+    REQUIRE(fm::asin(1.0) == Approx(M_PI_2));
+    REQUIRE(fm::asin(-1.0f) == Approx(-M_PI_2));
+    REQUIRE(fm::asin(1.5) == Approx(M_PI_2));
+    REQUIRE(fm::StdMath::asin(-1.5) == Approx(-M_PI_2));
+
+    REQUIRE(fm::rsqrt(4.0) == Approx(0.5));
+    REQUIRE(fm::rsqrt(1e-30) == Approx(1e15));
+    REQUIRE(fm::StdMath::rsqrt(4.0f) == 0.5f);
+    REQUIRE(fm::FastMath::atan2(1.0, 1.0) == Approx(M_PI / 4));
+    REQUIRE(fm::FastMath::rsqrt(4.0f) == 0.5f);
+    REQUIRE(fm::FastMathNoHardwareSqrt::rsqrt(4.0) == Approx(0.5));
+}
+
 // leakyintegrator.h
 TEST_CASE("LeakyIntegrator basic leak behavior with freq = 0", "[utils]")
 {
@@ -316,6 +1077,85 @@ TEST_CASE("LeakyIntegrator cutoff branch when timer pushes update", "[utils]")
     REQUIRE(v2 == Approx(2.0));
 }
 
+TEST_CASE("LeakyIntegrator gates the leak on supplied timestamps", "[utils]")
+{
+    puara_gestures::utils::LeakyIntegrator integrator(0.0, 0.0, 0.5, 10, 0);
+
+    // 10 Hz: the leak is applied at most once per 100 ms.
+    REQUIRE(integrator.integrateAt(1.0, 200'000) == Approx(1.0));
+    REQUIRE(integrator.timer == 200);
+    REQUIRE(integrator.integrateAt(1.0, 250'000) == Approx(2.0)); // gated
+    REQUIRE(integrator.integrateAt(1.0, 300'000) == Approx(2.0)); // 1 + 2 * 0.5
+    REQUIRE(integrator.timer == 300);
+
+    // Durations drive the same gate from an internal clock.
+    puara_gestures::utils::LeakyIntegrator stepped(0.0, 1.0, 0.5, 10, 0);
+    REQUIRE(stepped.integrateDt(0.0, 0.05) == Approx(1.0)); // 50 ms: gated
+    REQUIRE(stepped.integrateDt(0.0, 0.05) == Approx(0.5)); // 100 ms
+    REQUIRE(stepped.integrateDt(0.0, 0.05) == Approx(0.5)); // 150 ms: gated
+}
+
+TEST_CASE("LeakyIntegrator continuous mode does not depend on the sample rate", "[utils]")
+{
+    using puara_gestures::utils::LeakMode;
+    using puara_gestures::utils::LeakyIntegrator;
+
+    // Keep half of the value every 10 ms.
+    LeakyIntegrator fast(0.0, 1.0, 0.5, 100, 0, LeakMode::Continuous);
+    LeakyIntegrator slow(0.0, 1.0, 0.5, 100, 0, LeakMode::Continuous);
+
+    for(int i = 0; i < 20; ++i)
+        fast.integrateDt(0.0, 0.001);
+    for(int i = 0; i < 2; ++i)
+        slow.integrateDt(0.0, 0.010);
+
+    REQUIRE(fast.current_value == Approx(0.25));
+    REQUIRE(slow.current_value == Approx(0.25));
+
+    // Timestamps give the same result; the first one only sets the origin.
+    LeakyIntegrator stamped(0.0, 1.0, 0.5, 100, 0, LeakMode::Continuous);
+    REQUIRE(stamped.integrateAt(0.0, 5'000'000) == Approx(1.0));
+    REQUIRE(stamped.integrateAt(0.0, 5'005'000) == Approx(std::sqrt(0.5)));
+    REQUIRE(stamped.integrateAt(0.0, 5'020'000) == Approx(0.25));
+
+    // Without a frequency the leak is applied once per sample.
+    LeakyIntegrator perSample(0.0, 1.0, 0.5, 0, 0, LeakMode::Continuous);
+    REQUIRE(perSample.integrateDt(0.0, 0.123) == Approx(0.5));
+    REQUIRE(perSample.integrate(0.0) == Approx(0.25));
+}
+
+TEST_CASE("LeakyIntegrator continuous mode also times integrate() from the clock", "[utils]")
+{
+    using puara_gestures::utils::LeakMode;
+    using puara_gestures::utils::LeakyIntegrator;
+
+    // 100 Hz: after at least 20 ms at most a quarter is kept, where the gated
+    // mode would leak once and keep half.
+    LeakyIntegrator integrator(0.0, 0.0, 0.5, 100, 0, LeakMode::Continuous);
+    REQUIRE(integrator.integrate(1.0) == Approx(1.0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(integrator.integrate(0.0) <= 0.25 + 1e-9);
+}
+
+TEST_CASE("LeakyIntegrator restarts its time base when timestamps go backwards", "[utils]")
+{
+    using puara_gestures::utils::LeakMode;
+    using puara_gestures::utils::LeakyIntegrator;
+
+    LeakyIntegrator continuous(0.0, 0.0, 0.5, 100, 0, LeakMode::Continuous);
+    REQUIRE(continuous.integrateAt(1.0, 1'000'000) == Approx(1.0));
+    REQUIRE(continuous.integrateAt(1.0, 1'010'000) == Approx(1.5));
+    REQUIRE(continuous.integrateAt(1.0, 500) == Approx(2.5));     // new origin, no leak
+    REQUIRE(continuous.integrateAt(1.0, 10'500) == Approx(2.25)); // 1 + 2.5 * 0.5
+    REQUIRE(continuous.integrateDt(0.0, -0.01) == Approx(2.25));  // no negative leak
+
+    LeakyIntegrator gated(0.0, 0.0, 0.5, 10, 0);
+    REQUIRE(gated.integrateAt(1.0, 5'000'000) == Approx(1.0));
+    REQUIRE(gated.integrateAt(1.0, 1'000) == Approx(2.0));   // new origin, gated
+    REQUIRE(gated.timer == 1);
+    REQUIRE(gated.integrateAt(1.0, 101'000) == Approx(2.0)); // 1 + 2 * 0.5
+}
+
 // maprange.h
 TEST_CASE("MapRange maps and preserves values when outMin == outMax", "[utils]")
 {
@@ -360,6 +1200,189 @@ TEST_CASE("RollingMinMax tracks the min and max of a sliding window", "[utils]")
     REQUIRE(range5.max == Approx(12));
 }
 
+TEST_CASE("RollingMinMax monotonic wedge mode matches the rescan mode", "[utils]")
+{
+    using puara_gestures::utils::RollingMinMaxMode;
+
+    for (size_t windowSize : {size_t{1}, size_t{3}, size_t{10}, size_t{64}})
+    {
+        puara_gestures::utils::RollingMinMax<double> rescan(windowSize);
+        puara_gestures::utils::RollingMinMax<double> wedge(windowSize, RollingMinMaxMode::MonotonicWedge);
+        REQUIRE(wedge.mode() == RollingMinMaxMode::MonotonicWedge);
+
+        // Deterministic pseudo-random walk with plateaus and repeated values.
+        double value = 0.0;
+        for (int i = 0; i < 1000; ++i)
+        {
+            value += ((i * 7919) % 13) - 6.0;
+            if (i % 17 == 0)
+                value = std::round(value / 5.0) * 5.0;
+
+            auto expected = rescan.update(value);
+            auto measured = wedge.update(value);
+            INFO("window=" << windowSize << " sample=" << i);
+            REQUIRE(measured.min == expected.min);
+            REQUIRE(measured.max == expected.max);
+            REQUIRE(wedge.current_value.min == rescan.current_value.min);
+            REQUIRE(wedge.current_value.max == rescan.current_value.max);
+        }
+    }
+
+    puara_gestures::utils::RollingMinMax<int> window(3, RollingMinMaxMode::MonotonicWedge);
+    window.update(10);
+    window.update(4);
+    window.update(7);
+    auto range = window.update(2);
+    REQUIRE(range.min == 2);
+    REQUIRE(range.max == 7);
+}
+
+TEST_CASE("RollingMinMax with a compile-time window matches the runtime window", "[utils]")
+{
+    using puara_gestures::utils::RollingMinMaxMode;
+
+    puara_gestures::utils::RollingMinMax<double> runtime(10);
+    puara_gestures::utils::RollingMinMax<double, 10> fixed;
+    puara_gestures::utils::RollingMinMax<double, 10> fixedWedge(RollingMinMaxMode::MonotonicWedge);
+
+    double value = 0.0;
+    for (int i = 0; i < 500; ++i)
+    {
+        value += ((i * 7919) % 13) - 6.0;
+        auto expected = runtime.update(value);
+        auto measured = fixed.update(value);
+        auto measuredWedge = fixedWedge.update(value);
+        INFO("sample=" << i);
+        REQUIRE(measured.min == expected.min);
+        REQUIRE(measured.max == expected.max);
+        REQUIRE(measuredWedge.min == expected.min);
+        REQUIRE(measuredWedge.max == expected.max);
+    }
+}
+
+
+
+// smooth.h
+TEST_CASE("Smooth averages the most recent values", "[utils][smooth]")
+{
+    puara_gestures::utils::Smooth smoother(3);
+    REQUIRE(smoother.empty());
+
+    REQUIRE(smoother.smooth(1.0) == Approx(1.0));
+    REQUIRE(smoother.smooth(2.0) == Approx(1.5));
+    REQUIRE(smoother.smooth(4.0) == Approx((1.0 + 2.0 + 4.0) / 3.0));
+    REQUIRE(smoother.smooth(5.0) == Approx((2.0 + 4.0 + 5.0) / 3.0));
+    REQUIRE(smoother.smooth(6.0) == Approx((4.0 + 5.0 + 6.0) / 3.0));
+
+    // Shrinking the window keeps the most recent values.
+    smoother.size = 2;
+    REQUIRE(smoother.smooth(8.0) == Approx((6.0 + 8.0) / 2.0));
+
+    smoother.clear();
+    REQUIRE(smoother.empty());
+    REQUIRE(smoother.smooth(10.0) == Approx(10.0));
+
+    puara_gestures::utils::Smooth disabled(0);
+    REQUIRE(disabled.smooth(3.0) == Approx(0.0));
+}
+
+TEST_CASE("Smooth running mean does not drift over long sessions", "[utils][smooth]")
+{
+    // A large offset with small variations loses the small part quickly when
+    // adding and removing values from a plain running sum.
+    puara_gestures::utils::Smooth smoother(50);
+    double last = 0.0;
+    for (int i = 0; i < 1000000; ++i)
+        last = smoother.smooth((i % 2 == 0 ? 1e8 : -1e8) + 0.1 * (i % 7));
+
+    double expected = 0.0;
+    for (int i = 1000000 - 50; i < 1000000; ++i)
+        expected += (i % 2 == 0 ? 1e8 : -1e8) + 0.1 * (i % 7);
+    expected /= 50.0;
+
+    REQUIRE(last == Approx(expected).margin(1e-9));
+}
+
+TEST_CASE("Smooth exponential mode", "[utils][smooth]")
+{
+    using puara_gestures::utils::SmoothMode;
+    puara_gestures::utils::Smooth smoother(3, SmoothMode::Exponential);
+    REQUIRE(smoother.mode() == SmoothMode::Exponential);
+
+    // alpha = 2 / (3 + 1) = 0.5
+    REQUIRE(smoother.smooth(4.0) == Approx(4.0));
+    REQUIRE(smoother.smooth(0.0) == Approx(2.0));
+    REQUIRE(smoother.smooth(2.0) == Approx(2.0));
+    REQUIRE(smoother.smooth(6.0) == Approx(4.0));
+
+    smoother.clear();
+    REQUIRE(smoother.empty());
+    REQUIRE(smoother.smooth(1.0) == Approx(1.0));
+}
+
+TEST_CASE("Smooth median mode rejects spikes", "[utils][smooth]")
+{
+    using puara_gestures::utils::SmoothMode;
+    puara_gestures::utils::Smooth smoother(5, SmoothMode::Median);
+
+    REQUIRE(smoother.smooth(1.0) == Approx(1.0));
+    REQUIRE(smoother.smooth(3.0) == Approx(2.0));
+    REQUIRE(smoother.smooth(2.0) == Approx(2.0));
+    REQUIRE(smoother.smooth(100.0) == Approx(2.5));
+    REQUIRE(smoother.smooth(2.0) == Approx(2.0));
+    // Window is now {3, 2, 100, 2, 2}; the spike does not leak into the output.
+    REQUIRE(smoother.smooth(2.0) == Approx(2.0));
+    REQUIRE(smoother.smooth(-50.0) == Approx(2.0));
+
+    smoother.setMode(SmoothMode::Mean);
+    REQUIRE(smoother.empty());
+    REQUIRE(smoother.smooth(4.0) == Approx(4.0));
+}
+
+TEST_CASE("Smooth median mode recovers after a NaN reading", "[utils][smooth]")
+{
+    using puara_gestures::utils::SmoothMode;
+    puara_gestures::utils::Smooth smoother(4, SmoothMode::Median);
+
+    for (double v : {8.0, std::numeric_limits<double>::quiet_NaN(), 4.0, 8.0, 0.0})
+        smoother.smooth(v);
+
+    // The NaN has left the window, which is now {4, 8, 0, 4}, then {8, 0, 4, 3}.
+    REQUIRE(smoother.smooth(4.0) == Approx(4.0));
+    REQUIRE(smoother.smooth(3.0) == Approx(3.5));
+    REQUIRE(smoother.smooth(9.0) == Approx(3.5));
+}
+
+TEST_CASE("Smooth Savitzky-Golay mode follows polynomial trends", "[utils][smooth]")
+{
+    using puara_gestures::utils::SmoothMode;
+    puara_gestures::utils::Smooth smoother(7, SmoothMode::SavitzkyGolay);
+
+    auto quadratic = [](int i) {
+        const double x = static_cast<double>(i);
+        return 0.5 * x * x - 3.0 * x + 1.0;
+    };
+
+    // Mean until three values are available.
+    REQUIRE(smoother.smooth(quadratic(0)) == Approx(1.0));
+    REQUIRE(smoother.smooth(quadratic(1)) == Approx((1.0 - 1.5) / 2.0));
+
+    // A quadratic fit reproduces quadratic inputs exactly, without the lag
+    // of the moving average, also once the window wraps around.
+    for (int i = 2; i < 30; ++i)
+    {
+        const double out = smoother.smooth(quadratic(i));
+        INFO("sample=" << i);
+        REQUIRE(out == Approx(quadratic(i)).margin(1e-6));
+    }
+
+    // Zero-mean alternating noise on a constant is attenuated.
+    smoother.clear();
+    double out = 0.0;
+    for (int i = 0; i < 20; ++i)
+        out = smoother.smooth(i % 2 == 0 ? 11.0 : 9.0);
+    REQUIRE(std::abs(out - 10.0) < 1.0);
+}
 
 
 //threshold.h
@@ -445,4 +1468,481 @@ TEST_CASE("Unwrap continues decreasing through the negative boundary and resets
     u.clear();
     double restart = u.unwrap(1.0);
     REQUIRE(restart == Approx(1.0));
-}
\ No newline at end of file
+}
+
+// imuReplay.h
+namespace
+{
+std::filesystem::path testDataPath(const char* filename)
+{
+    return std::filesystem::path(__FILE__).parent_path() / "data" / filename;
+}
+
+std::vector<ImuSample> readAll(CsvImuReader& reader, std::size_t chunk)
+{
+    std::vector<ImuSample> samples;
+    std::vector<ImuSample> buffer(chunk);
+    while(std::size_t n = reader.read(buffer))
+        samples.insert(samples.end(), buffer.begin(), buffer.begin() + n);
+    return samples;
+}
+}
+
+TEST_CASE("CsvImuReader streams the values rapidcsv reads", "[utils][replay]")
+{
+    const auto path = testDataPath("imu_data_jab_shake.csv");
+    rapidcsv::Document doc(path.string(), rapidcsv::LabelParams(0, -1));
+
+    // A small buffer and an odd chunk size, so rows straddle both.
+    CsvImuReader reader(path.string().c_str(), 1000.0, 256);
+    REQUIRE(reader.isOpen());
+    const auto samples = readAll(reader, 7);
+
+    REQUIRE(samples.size() == doc.GetRowCount());
+    CHECK(reader.skippedRows == 0);
+    for(std::size_t r = 0; r < samples.size(); ++r)
+    {
+        const auto& s = samples[r];
+        CHECK(s.timestampMicros == uint64_t(doc.GetCell<double>("timestamp", r) * 1000.0));
+        CHECK(s.imu.accl.x == doc.GetCell<double>("accl_x", r));
+        CHECK(s.imu.accl.z == doc.GetCell<double>("accl_z", r));
+        CHECK(s.imu.gyro.y == doc.GetCell<double>("gyro_y", r));
+        CHECK(s.imu.magn.x == doc.GetCell<double>("magn_x", r));
+        CHECK(s.imu.magn.z == doc.GetCell<double>("magn_z", r));
+    }
+}
+
+TEST_CASE("CsvImuReader handles mag_ columns, seconds, CRLF and bad rows", "[utils][replay]")
+{
+    const auto path = std::filesystem::temp_directory_path() / "puara_replay_test.csv";
+    {
+        std::ofstream csv(path, std::ios::binary);
+        csv << "timestamp,mag_x,accl_x,label,mag_z\r\n"
+            << "0.5,1.5,-2,a,3e-3\r\n"
+            << "oops,1,2,b,3\r\n"
+            << "\r\n"
+            << "1.25,4,5,c,6"; // no final newline
+    }
+
+    CsvImuReader reader(path.string().c_str(), 1.0e6);
+    REQUIRE(reader.isOpen());
+    const auto samples = readAll(reader, 16);
+    std::filesystem::remove(path);
+
+    REQUIRE(samples.size() == 2);
+    CHECK(reader.skippedRows == 1);
+    CHECK(samples[0].timestampMicros == 500000);
+    CHECK(samples[0].imu.magn.x == 1.5);
+    CHECK(samples[0].imu.accl.x == -2.0);
+    CHECK(samples[0].imu.magn.z == 3e-3);
+    CHECK(samples[0].imu.gyro.x == 0.0);
+    CHECK(samples[1].timestampMicros == 1250000);
+    CHECK(samples[1].imu.magn.z == 6.0);
+}
+
+TEST_CASE("CsvImuReader skips truncated rows", "[utils][replay]")
+{
+    const auto path = std::filesystem::temp_directory_path() / "puara_replay_short.csv";
+    {
+        std::ofstream csv(path, std::ios::binary);
+        csv << "timestamp,accl_x,accl_z,label\n"
+            << "1,2,3,a\n"
+            << "2,5\n"     // ends before accl_z
+            << "3,6,7\n"   // only the unmapped label is missing
+            << "4,8";      // truncated last row
+    }
+
+    CsvImuReader reader(path.string().c_str());
+    REQUIRE(reader.isOpen());
+    const auto samples = readAll(reader, 16);
+    std::filesystem::remove(path);
+
+    REQUIRE(samples.size() == 2);
+    CHECK(reader.skippedRows == 2);
+    CHECK(samples[0].timestampMicros == 1000);
+    CHECK(samples[1].timestampMicros == 3000);
+    CHECK(samples[1].imu.accl.z == 7.0);
+}
+
+TEST_CASE("CsvImuReader skips a row longer than its buffer", "[utils][replay]")
+{
+    const auto path = std::filesystem::temp_directory_path() / "puara_replay_long.csv";
+    {
+        // The end of the long row would parse as a row of its own.
+        std::ofstream csv(path, std::ios::binary);
+        csv << "timestamp,accl_x\n"
+            << "1,2\n"
+            << std::string(300, '0') << "5,6\n"
+            << "7,8\n";
+    }
+
+    CsvImuReader reader(path.string().c_str(), 1000.0, 64);
+    REQUIRE(reader.isOpen());
+    const auto samples = readAll(reader, 16);
+    std::filesystem::remove(path);
+
+    REQUIRE(samples.size() == 2);
+    CHECK(reader.skippedRows == 1);
+    CHECK(samples[0].timestampMicros == 1000);
+    CHECK(samples[1].timestampMicros == 7000);
+    CHECK(samples[1].imu.accl.x == 8.0);
+}
+
+TEST_CASE("Binary IMU recordings round trip in single precision", "[utils][replay]")
+{
+    CsvImuReader csv(testDataPath("imu_data_roll.csv").string().c_str(), 1.0e6);
+    const auto samples = readAll(csv, 64);
+    REQUIRE(samples.size() > 50);
+
+    const auto path = std::filesystem::temp_directory_path() / "puara_replay_test.imu";
+    {
+        BinaryImuWriter writer(
+            path.string().c_str(), ImuRecordingHeader::float32(), ImuWriteMode::Replace, 16);
+        REQUIRE(writer.isOpen());
+        REQUIRE(writer.write(samples));
+        REQUIRE(writer.close());
+    }
+    CHECK(std::filesystem::file_size(path)
+          == sizeof(ImuRecordingHeader) + samples.size() * sizeof(ImuRecord));
+
+    BinaryImuReader reader(path.string().c_str(), 10);
+    REQUIRE(reader.isOpen());
+    std::size_t index = 0;
+    bool matches = true;
+    const std::size_t replayed = replay<32>(reader, [&](const ImuSample& s) {
+        const auto& expected = samples[index++];
+        matches = matches && s.timestampMicros == expected.timestampMicros
+                  && s.imu.accl.y == double(float(expected.imu.accl.y))
+                  && s.imu.gyro.z == double(float(expected.imu.gyro.z))
+                  && s.imu.magn.x == double(float(expected.imu.magn.x));
+    });
+    std::filesystem::remove(path);
+
+    CHECK(replayed == samples.size());
+    CHECK(index == samples.size());
+    CHECK(matches);
+}
+
+TEST_CASE("replay feeds chunk sinks and sample sinks in order", "[utils][replay]")
+{
+    CsvImuReader reader(testDataPath("imu_data_tilt.csv").string().c_str(), 1.0e6);
+    std::vector<uint64_t> fromChunks, fromSamples;
+    std::size_t largestChunk = 0;
+    const std::size_t total = replay<16>(
+        reader,
+        [&](std::span<const ImuSample> chunk) {
+            largestChunk = std::max(largestChunk, chunk.size());
+            for(const auto& s : chunk)
+                fromChunks.push_back(s.timestampMicros);
+        },
+        [&](const ImuSample& s) { fromSamples.push_back(s.timestampMicros); });
+
+    CHECK(total == 100);
+    CHECK(largestChunk == 16);
+    CHECK(fromChunks == fromSamples);
+    CHECK(fromSamples[0] == 14);
+    CHECK(fromSamples[1] == 33594);
+}
+
+TEST_CASE("replay accepts generic lambda sinks", "[utils][replay]")
+{
+    // The documented form: sinks taking `const auto&` get one sample each.
+    CsvImuReader reader(testDataPath("imu_data_tilt.csv").string().c_str(), 1.0e6);
+    std::vector<uint64_t> timestamps;
+    double acclSum = 0.0;
+    const std::size_t total = replay<16>(
+        reader,
+        [&](const auto& s) { timestamps.push_back(s.timestampMicros); },
+        [&](const auto& s) { acclSum += s.imu.accl.x; });
+
+    CsvImuReader again(testDataPath("imu_data_tilt.csv").string().c_str(), 1.0e6);
+    const auto samples = readAll(again, 64);
+    double expectedSum = 0.0;
+    for(const auto& s : samples)
+        expectedSum += s.imu.accl.x;
+
+    CHECK(total == 100);
+    REQUIRE(timestamps.size() == samples.size());
+    CHECK(timestamps[1] == samples[1].timestampMicros);
+    CHECK(acclSum == expectedSum);
+}
+
+// imuRecording.h
+TEST_CASE("floatToHalf and halfToFloat", "[utils][replay]")
+{
+    SECTION("every half value round trips")
+    {
+        bool matches = true;
+        for(uint32_t bits = 0; bits < 0x10000; ++bits)
+        {
+            const float value = halfToFloat(uint16_t(bits));
+            if(std::isnan(value))
+                matches = matches && std::isnan(halfToFloat(floatToHalf(value)));
+            else
+                matches = matches && floatToHalf(value) == bits;
+        }
+        CHECK(matches);
+    }
+
+    SECTION("rounding to nearest even")
+    {
+        CHECK(floatToHalf(1.0f) == 0x3c00);
+        CHECK(floatToHalf(1.0f + 0x1p-11f) == 0x3c00);
+        CHECK(floatToHalf(1.0f + 3 * 0x1p-11f) == 0x3c02);
+        CHECK(floatToHalf(-2.0f) == 0xc000);
+        CHECK(floatToHalf(65519.0f) == 0x7bff);
+        CHECK(floatToHalf(65520.0f) == 0x7c00);
+        CHECK(floatToHalf(0x1p-24f) == 0x0001);
+        CHECK(floatToHalf(0x1p-25f) == 0x0000);
+        CHECK(floatToHalf(1.5f * 0x1p-25f) == 0x0001);
+        CHECK(floatToHalf(0x1p-14f - 0x1p-25f) == 0x0400);
+        CHECK(halfToFloat(0x3555) == Approx(1.0 / 3.0).epsilon(1e-3));
+    }
+}
+
+namespace
+{
+std::vector<ImuSample> readAll(BinaryImuReader& reader)
+{
+    std::vector<ImuSample> samples;
+    std::vector<ImuSample> buffer(100);
+    while(std::size_t n = reader.read(buffer))
+        samples.insert(samples.end(), buffer.begin(), buffer.begin() + n);
+    return samples;
+}
+
+double largestError(const puara_gestures::Coord3D& a, const puara_gestures::Coord3D& b)
+{
+    return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+}
+}
+
+TEST_CASE("Quantized IMU recordings stay within their resolution", "[utils][replay]")
+{
+    CsvImuReader csv(testDataPath("imu_data_jab_shake.csv").string().c_str());
+    const auto samples = readAll(csv, 64);
+    const auto path = std::filesystem::temp_directory_path() / "puara_quantized_test.imu";
+
+    SECTION("int16: half a step of each sensor's scale")
+    {
+        const auto format = ImuRecordingHeader::int16(40.0, 20.0, 2.0);
+        REQUIRE(BinaryImuWriter(path.string().c_str(), format).write(samples));
+        CHECK(std::filesystem::file_size(path) == 64 + samples.size() * 32);
+
+        BinaryImuReader reader(path.string().c_str());
+        REQUIRE(reader.isOpen());
+        CHECK(reader.header().encoding == ImuEncoding::Int16);
+        const auto decoded = readAll(reader);
+        REQUIRE(decoded.size() == samples.size());
+        bool within = true;
+        for(std::size_t i = 0; i < samples.size(); ++i)
+            within = within && decoded[i].timestampMicros == samples[i].timestampMicros
+                     && largestError(decoded[i].imu.accl, samples[i].imu.accl)
+                            <= 0.5001 * format.acclScale
+                     && largestError(decoded[i].imu.gyro, samples[i].imu.gyro)
+                            <= 0.5001 * format.gyroScale
+                     && largestError(decoded[i].imu.magn, samples[i].imu.magn)
+                            <= 0.5001 * format.magnScale;
+        CHECK(within);
+    }
+
+    SECTION("int16: out of range values clamp")
+    {
+        ImuSample sample;
+        sample.imu.accl = {100.0, -100.0, 1.0};
+        const auto format = ImuRecordingHeader::int16(10.0, 1.0, 1.0);
+        const auto decoded = ImuRecordInt16::encode(sample, format).decode(format);
+        CHECK(decoded.imu.accl.x == Approx(10.0));
+        CHECK(decoded.imu.accl.y == Approx(-10.0));
+        CHECK(decoded.imu.accl.z == Approx(1.0).margin(format.acclScale));
+    }
+
+    SECTION("int16: NaN stores as zero")
+    {
+        CHECK(Int16Codec::encode(std::numeric_limits<double>::quiet_NaN()) == 0);
+        CHECK(Int16Codec::encode(std::numeric_limits<double>::infinity()) == 32767);
+    }
+
+    SECTION("int16: non-positive ranges are rejected")
+    {
+        for(const double range : {0.0, -1.0, std::numeric_limits<double>::infinity()})
+        {
+            const auto format = ImuRecordingHeader::int16(10.0, range, 1.0);
+            CHECK_FALSE(format.hasUsableScales());
+            CHECK_FALSE(BinaryImuWriter(path.string().c_str(), format).isOpen());
+
+            ImuRecordingHeader parsed;
+            CHECK_FALSE(parseImuRecordingHeader(
+                std::as_bytes(std::span(&format, 1)), parsed));
+        }
+        CHECK(ImuRecordingHeader::int16(10.0, 1.0, 1.0).hasUsableScales());
+    }
+
+    SECTION("float16: 11 significant bits")
+    {
+        REQUIRE(BinaryImuWriter(path.string().c_str(), ImuRecordingHeader::float16())
+                    .write(samples));
+        BinaryImuReader reader(path.string().c_str());
+        const auto decoded = readAll(reader);
+        REQUIRE(decoded.size() == samples.size());
+        bool within = true;
+        for(std::size_t i = 0; i < samples.size(); ++i)
+        {
+            const auto& a = samples[i].imu;
+            const auto& b = decoded[i].imu;
+            for(const auto& [x, y] :
+                {std::pair{a.accl.x, b.accl.x}, std::pair{a.gyro.y, b.gyro.y},
+                 std::pair{a.magn.z, b.magn.z}})
+                within = within && std::abs(x - y) <= std::abs(x) * 0x1p-11 + 0x1p-25;
+        }
+        CHECK(within);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("MappedImuRecording views the records in place", "[utils][replay]")
+{
+    CsvImuReader csv(testDataPath("imu_data_roll.csv").string().c_str(), 1.0e6);
+    const auto samples = readAll(csv, 64);
+    const auto path = std::filesystem::temp_directory_path() / "puara_mapped_test.imu";
+    const auto format = ImuRecordingHeader::int16(20.0, 10.0, 1.0);
+    REQUIRE(BinaryImuWriter(path.string().c_str(), format).write(samples));
+
+    MappedImuRecording mapped(path.string().c_str());
+    REQUIRE(mapped.isOpen());
+    CHECK(mapped.size() == samples.size());
+    CHECK(mapped.records<ImuRecord>().empty());
+    CHECK(mapped.records<ImuRecordHalf>().empty());
+    const auto records = mapped.records<ImuRecordInt16>();
+    REQUIRE(records.size() == samples.size());
+
+    BinaryImuReader reader(path.string().c_str());
+    const auto decoded = readAll(reader);
+    REQUIRE(decoded.size() == samples.size());
+    bool matches = true;
+    for(std::size_t i = 0; i < records.size(); ++i)
+    {
+        const auto sample = records[i].decode(mapped.header());
+        matches = matches && sample.timestampMicros == decoded[i].timestampMicros
+                  && sample.imu.accl.x == decoded[i].imu.accl.x
+                  && sample.imu.gyro.y == decoded[i].imu.gyro.y
+                  && sample.imu.magn.z == decoded[i].imu.magn.z;
+    }
+    CHECK(matches);
+
+    // read() decodes the same samples, so the mapping also replays.
+    std::size_t index = 0;
+    CHECK(replay<16>(mapped, [&](const ImuSample& s) {
+              matches = matches && s.imu.accl.y == decoded[index++].imu.accl.y;
+          })
+          == samples.size());
+    CHECK(matches);
+    CHECK(replay(mapped, [](const ImuSample&) {}) == 0);
+    mapped.rewind();
+    CHECK(replay(mapped, [](const ImuSample&) {}) == samples.size());
+
+    std::filesystem::remove(path);
+    CHECK_FALSE(MappedImuRecording(path.string().c_str()).isOpen());
+}
+
+TEST_CASE("BinaryImuWriter appends to an existing recording", "[utils][replay]")
+{
+    CsvImuReader csv(testDataPath("imu_data_tilt.csv").string().c_str(), 1.0e6);
+    const auto samples = readAll(csv, 64);
+    const std::span<const ImuSample> all(samples);
+    const auto path = std::filesystem::temp_directory_path() / "puara_append_test.imu";
+    std::filesystem::remove(path);
+
+    const auto format = ImuRecordingHeader::float16();
+    {
+        // A missing file is created with the given format.
+        BinaryImuWriter writer(path.string().c_str(), format, ImuWriteMode::Append, 8);
+        REQUIRE(writer.write(all.first(30)));
+    }
+    {
+        // A partial record, as left by an interrupted write, is overwritten.
+        std::ofstream(path, std::ios::binary | std::ios::app) << "partial";
+        // The existing header wins over the requested format.
+        BinaryImuWriter writer(
+            path.string().c_str(), ImuRecordingHeader::float32(), ImuWriteMode::Append, 8);
+        REQUIRE(writer.isOpen());
+        CHECK(writer.format().encoding == ImuEncoding::Float16);
+        REQUIRE(writer.write(all.subspan(30)));
+    }
+
+    CHECK(std::filesystem::file_size(path) == 64 + samples.size() * 32);
+    MappedImuRecording mapped(path.string().c_str());
+    const auto records = mapped.records<ImuRecordHalf>();
+    REQUIRE(records.size() == samples.size());
+    bool matches = true;
+    for(std::size_t i = 0; i < samples.size(); ++i)
+        matches = matches
+                  && records[i].decode(mapped.header()).timestampMicros
+                         == samples[i].timestampMicros
+                  && records[i].accl[2]
+                         == ImuRecordHalf::encode(samples[i], format).accl[2];
+    CHECK(matches);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("BinaryImuWriter refuses to append to a corrupt header", "[utils][replay]")
+{
+    const auto path = std::filesystem::temp_directory_path() / "puara_corrupt_test.imu";
+    {
+        // The magic matches, but the rest of the header is zeros.
+        const char magic[8] = {'P', 'U', 'A', 'R', 'A', 'I', 'M', 'U'};
+        std::ofstream file(path, std::ios::binary);
+        file.write(magic, sizeof magic);
+        file << std::string(sizeof(ImuRecordingHeader) - sizeof magic, '\0');
+    }
+
+    const auto format = ImuRecordingHeader::float16();
+    BinaryImuWriter writer(path.string().c_str(), format, ImuWriteMode::Append, 8);
+    CHECK_FALSE(writer.isOpen());
+    CHECK(writer.format().encoding == ImuEncoding::Float16);
+    CHECK(writer.format().recordSize == format.recordSize);
+
+    ImuSample sample;
+    CHECK_FALSE(writer.write(sample));
+    CHECK_FALSE(writer.close());
+    CHECK(std::filesystem::file_size(path) == sizeof(ImuRecordingHeader));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Version 1 IMU recordings still read", "[utils][replay]")
+{
+    const auto path = std::filesystem::temp_directory_path() / "puara_v1_test.imu";
+    ImuSample sample;
+    sample.timestampMicros = 1234;
+    sample.imu.accl = {1.0, 2.0, 3.0};
+    sample.imu.magn = {0.25, 0.5, 0.75};
+    {
+        // 16-byte header: magic, uint32_t version 1, record size.
+        const char magic[8] = {'P', 'U', 'A', 'R', 'A', 'I', 'M', 'U'};
+        const uint32_t fields[2] = {1, 48};
+        const auto record = ImuRecord::encode(sample, {});
+        std::ofstream file(path, std::ios::binary);
+        file.write(magic, sizeof magic);
+        file.write(reinterpret_cast<const char*>(fields), sizeof fields);
+        file.write(reinterpret_cast<const char*>(&record), sizeof record);
+        file.write(reinterpret_cast<const char*>(&record), sizeof record);
+    }
+
+    BinaryImuReader reader(path.string().c_str());
+    REQUIRE(reader.isOpen());
+    CHECK(reader.header().version == 1);
+    const auto decoded = readAll(reader);
+    REQUIRE(decoded.size() == 2);
+    CHECK(decoded[1].timestampMicros == 1234);
+    CHECK(decoded[1].imu.accl.z == 3.0);
+
+    MappedImuRecording mapped(path.string().c_str());
+    const auto records = mapped.records<ImuRecord>();
+    REQUIRE(records.size() == 2);
+    CHECK(records[0].magn[1] == 0.5f);
+
+    // Appending keeps the version 1 layout.
+    REQUIRE(BinaryImuWriter(path.string().c_str(), {}, ImuWriteMode::Append).write(sample));
+    CHECK(std::filesystem::file_size(path) == 16 + 3 * 48);
+    std::filesystem::remove(path);
+}
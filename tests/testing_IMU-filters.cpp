@@ -1,8 +1,16 @@
 #include <catch2/catch_all.hpp>
 #include <cmath>
 #include <puara/utils.h>
+#include <puara/utils/imuReplay.h>
 #include <thread>
+#include <type_traits>
 #include <chrono>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
 
 using namespace Catch;
 
@@ -82,3 +90,328 @@ TEST_CASE("IMU filters support synthetic timestamp updates", "[imu-filters]") {
         REQUIRE(isQuaternionNormalized(filter.getQuaternion()));
     }
 }
+
+// Tilt, in degrees, between the gravity direction of a filter's orientation
+// and the accelerometer's.
+template <typename Filter>
+static double tiltErrorDegrees(const Filter& filter, const puara_gestures::Coord3D& accl) {
+    const auto& q = filter.getQuaternion();
+    const double gx = 2.0 * (q.x * q.z - q.w * q.y);
+    const double gy = 2.0 * (q.y * q.z + q.w * q.x);
+    const double gz = 1.0 - 2.0 * (q.x * q.x + q.y * q.y);
+    const double norm = std::sqrt(accl.x * accl.x + accl.y * accl.y + accl.z * accl.z);
+    const double cosine = (gx * accl.x + gy * accl.y + gz * accl.z) / norm;
+    return std::acos(std::clamp(cosine, -1.0, 1.0)) * 57.29577951308232;
+}
+
+// A device held still at roll 0.5, pitch -0.3, yaw 0.7 rad, sampled at 100 Hz,
+// with a constant gyro offset.
+struct StationaryImu {
+    static constexpr double roll = 0.5;
+    static constexpr double pitch = -0.3;
+    static constexpr double yaw = 0.7;
+    puara_gestures::Coord3D gyroBias{0.02, -0.03, 0.05};
+
+    puara_gestures::Imu9Axis sample() const {
+        const double cr = std::cos(roll), sr = std::sin(roll);
+        const double cp = std::cos(pitch), sp = std::sin(pitch);
+        const double cy = std::cos(yaw), sy = std::sin(yaw);
+        // Earth field (0.4, 0, -0.9) rotated into the body frame.
+        const double ex = 0.4, ez = -0.9;
+        return puara_gestures::Imu9Axis{
+            {-sp, sr * cp, cr * cp},
+            gyroBias,
+            {cp * cy * ex - sp * ez,
+             (sr * sp * cy - cr * sy) * ex + sr * cp * ez,
+             (cr * sp * cy + sr * sy) * ex + cr * cp * ez}};
+    }
+};
+
+TEST_CASE("Kalman filter estimates the gyro bias of a stationary device", "[imu-filters][kalman]") {
+    const StationaryImu device;
+    const auto imu = device.sample();
+
+    puara_gestures::KalmanQuaternionFilter kalman;
+    puara_gestures::MadgwickQuaternionFilter madgwick;
+    puara_gestures::MahonyQuaternionFilter mahony;
+    for (uint64_t i = 0; i < 6000; ++i) {
+        const uint64_t micros = 1 + i * 10000;
+        kalman.updateWithTimestamp(imu, micros, false);
+        madgwick.updateWithTimestamp(imu, micros, false);
+        mahony.updateWithTimestamp(imu, micros, false);
+        if (i == 50) {
+            // Aligned from the first sample, it has converged within half a second.
+            REQUIRE(tiltErrorDegrees(kalman, imu.accl) < 0.5);
+        }
+    }
+
+    CHECK(kalman.gyroBias.x == Approx(device.gyroBias.x).margin(1e-3));
+    CHECK(kalman.gyroBias.y == Approx(device.gyroBias.y).margin(1e-3));
+    CHECK(kalman.gyroBias.z == Approx(device.gyroBias.z).margin(1e-3));
+
+    const double kalmanTilt = tiltErrorDegrees(kalman, imu.accl);
+    INFO("tilt error after 60 s: Kalman " << kalmanTilt << ", Madgwick "
+         << tiltErrorDegrees(madgwick, imu.accl) << ", Mahony " << tiltErrorDegrees(mahony, imu.accl));
+    CHECK(kalmanTilt < 0.05);
+    CHECK(kalmanTilt < tiltErrorDegrees(madgwick, imu.accl));
+    CHECK(kalmanTilt < tiltErrorDegrees(mahony, imu.accl));
+
+    double roll, pitch, yaw;
+    kalman.getEulerRadians(roll, pitch, yaw);
+    CHECK(roll == Approx(StationaryImu::roll).margin(1e-3));
+    CHECK(pitch == Approx(StationaryImu::pitch).margin(1e-3));
+    CHECK(yaw == Approx(StationaryImu::yaw).margin(1e-3));
+}
+
+TEST_CASE("Kalman filter restarts its time base when the clock goes backwards", "[imu-filters][kalman]") {
+    const auto imu = StationaryImu{}.sample();
+    puara_gestures::KalmanQuaternionFilter filter;
+
+    REQUIRE(filter.updateWithTimestamp(imu, 5000, false) == false);
+    REQUIRE(filter.updateWithTimestamp(imu, 15000, false) == true);
+    REQUIRE(filter.updateWithTimestamp(imu, 1000, false) == false);
+    REQUIRE(filter.updateWithTimestamp(imu, 11000, false) == true);
+    REQUIRE(isQuaternionNormalized(filter.getQuaternion()));
+    REQUIRE(tiltErrorDegrees(filter, imu.accl) < 0.5);
+
+    filter.reset();
+    REQUIRE(filter.gyroBias.x == 0.0);
+    REQUIRE(filter.updateWithTimestamp(imu, 1000, false) == false);
+}
+
+TEMPLATE_TEST_CASE("IMU filters block updates match per-sample updates", "[imu-filters]",
+                   puara_gestures::MadgwickQuaternionFilter,
+                   puara_gestures::MahonyQuaternionFilter,
+                   puara_gestures::KalmanQuaternionFilter) {
+    std::vector<puara_gestures::Imu9Axis> imu(64);
+    std::vector<uint64_t> micros(imu.size());
+    for (std::size_t i = 0; i < imu.size(); ++i) {
+        const double t = 0.01 * static_cast<double>(i);
+        imu[i] = puara_gestures::Imu9Axis{
+            {std::sin(t), 0.2 * std::cos(t), 9.81},
+            {10.0 * std::cos(t), 5.0, -3.0 * std::sin(t)},
+            {0.3, 0.1 * std::sin(t), 0.5}};
+        micros[i] = 1000 + 10000 * i;
+    }
+
+    TestType single;
+    TestType block;
+    std::vector<puara_gestures::Quaternion> out(imu.size());
+    REQUIRE(block.updateWithTimestamp(imu, micros, out, true) == imu.size());
+
+    for (std::size_t i = 0; i < imu.size(); ++i) {
+        single.updateWithTimestamp(imu[i], micros[i], true);
+        const auto& expected = single.getQuaternion();
+        REQUIRE(out[i].w == expected.w);
+        REQUIRE(out[i].x == expected.x);
+        REQUIRE(out[i].y == expected.y);
+        REQUIRE(out[i].z == expected.z);
+    }
+    REQUIRE(isQuaternionNormalized(block.getQuaternion()));
+}
+
+// Recorded IMU session from tests/data, with timestamps converted to microseconds.
+struct ImuRecording {
+    std::vector<puara_gestures::Imu9Axis> imu;
+    std::vector<uint64_t> micros;
+};
+
+static ImuRecording loadImuRecording(std::string_view filename, double microsPerTimeUnit) {
+    const auto path = std::filesystem::path(__FILE__).parent_path() / "data" / filename;
+    puara_gestures::utils::CsvImuReader reader(path.string().c_str(), microsPerTimeUnit);
+    REQUIRE(reader.isOpen());
+
+    ImuRecording recording;
+    puara_gestures::utils::replay(reader, [&](const puara_gestures::utils::ImuSample& sample) {
+        recording.imu.push_back(sample.imu);
+        // Offset by one so that the first sample is not mistaken for "no timestamp".
+        recording.micros.push_back(1 + sample.timestampMicros);
+    });
+    REQUIRE(reader.skippedRows == 0);
+    return recording;
+}
+
+// Recordings the single-precision filters are checked against, and how to read them.
+struct ImuRecordingFixture {
+    const char* file;
+    double microsPerTimeUnit;
+    bool gyroDegrees;
+};
+
+static constexpr ImuRecordingFixture imuRecordingFixtures[] = {
+    {"imu_data_jab_shake.csv", 1.0e3, false},
+    {"imu_data_roll.csv", 1.0e6, true},
+    {"imu_data_tilt.csv", 1.0e6, true}};
+
+// Feeds a recording to a double-precision filter and to a single-precision one (given
+// float samples), then calls afterUpdate(referenceResult, singleResult) after each sample.
+template <typename Reference, typename Single, typename AfterUpdate>
+static void replayRecording(const ImuRecordingFixture& fixture, Reference& reference,
+                            Single& single, AfterUpdate&& afterUpdate) {
+    const auto recording = loadImuRecording(fixture.file, fixture.microsPerTimeUnit);
+    REQUIRE(recording.imu.size() > 50);
+
+    for (std::size_t i = 0; i < recording.imu.size(); ++i) {
+        const auto sample = static_cast<puara_gestures::Imu9AxisT<float>>(recording.imu[i]);
+        const auto referenceResult
+            = reference.updateWithTimestamp(recording.imu[i], recording.micros[i], fixture.gyroDegrees);
+        const auto singleResult
+            = single.updateWithTimestamp(sample, recording.micros[i], fixture.gyroDegrees);
+        afterUpdate(referenceResult, singleResult);
+    }
+}
+
+template <typename Filter>
+struct SinglePrecision;
+
+template <template <typename, typename> class Filter, typename Math>
+struct SinglePrecision<Filter<double, Math>> {
+    using type = Filter<float, Math>;
+};
+
+// Rotation angle, in degrees, between two orientations.
+static double angleBetweenDegrees(const puara_gestures::Quaternion& a,
+                                  const puara_gestures::Quaternion& b) {
+    // Relative rotation conj(a) * b; atan2 stays accurate for tiny angles where acos does not.
+    const double w = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+    const double x = a.w * b.x - a.x * b.w - a.y * b.z + a.z * b.y;
+    const double y = a.w * b.y + a.x * b.z - a.y * b.w - a.z * b.x;
+    const double z = a.w * b.z - a.x * b.y + a.y * b.x - a.z * b.w;
+    return 2.0 * std::atan2(std::sqrt(x * x + y * y + z * z), std::abs(w)) * 57.29577951308232;
+}
+
+TEMPLATE_TEST_CASE("Single-precision IMU filters track the double reference on recorded data",
+                   "[imu-filters][float]",
+                   puara_gestures::MadgwickQuaternionFilter,
+                   puara_gestures::MahonyQuaternionFilter,
+                   puara_gestures::KalmanQuaternionFilter) {
+    using FloatFilter = typename SinglePrecision<TestType>::type;
+    static_assert(std::is_same_v<decltype(FloatFilter{}.quaternion), puara_gestures::QuaternionT<float>>);
+
+    for (const auto& fixture : imuRecordingFixtures) {
+        TestType reference;
+        FloatFilter single;
+        double maxAngle = 0.0;
+        replayRecording(fixture, reference, single, [&](auto referenceResult, auto singleResult) {
+            REQUIRE(referenceResult == singleResult);
+            const auto q = static_cast<puara_gestures::Quaternion>(single.getQuaternion());
+            maxAngle = std::max(maxAngle, angleBetweenDegrees(reference.getQuaternion(), q));
+        });
+        INFO(fixture.file << ": max deviation " << maxAngle << " degrees");
+        CHECK(maxAngle < 1.0e-3);
+        CHECK(isQuaternionNormalized(static_cast<puara_gestures::Quaternion>(single.getQuaternion())));
+    }
+}
+
+template <typename Filter, typename Math>
+struct FloatVariant;
+
+template <template <typename, typename> class Filter, typename T, typename Math>
+struct FloatVariant<Filter<T, puara_gestures::fastmath::StdMath>, Math> {
+    using type = Filter<float, Math>;
+};
+
+template <typename Reference, typename Math>
+void checkFastMathFilter() {
+    using FastFilter = typename FloatVariant<Reference, Math>::type;
+
+    for (const auto& fixture : imuRecordingFixtures) {
+        Reference reference;
+        FastFilter fast;
+        double maxAngle = 0.0;
+        double maxEuler = 0.0;
+        replayRecording(fixture, reference, fast, [&](auto, auto) {
+            const auto q = static_cast<puara_gestures::Quaternion>(fast.getQuaternion());
+            maxAngle = std::max(maxAngle, angleBetweenDegrees(reference.getQuaternion(), q));
+
+            // Away from the pitch singularity, where roll and yaw are not defined.
+            double roll, pitch, yaw;
+            reference.getEulerRadians(roll, pitch, yaw);
+            if (std::abs(pitch) < 1.4) {
+                float fastRoll, fastPitch, fastYaw;
+                fast.getEulerRadians(fastRoll, fastPitch, fastYaw);
+                maxEuler = std::max({maxEuler, std::abs(fastPitch - pitch),
+                                     std::abs(std::remainder(fastRoll - roll, 2.0 * M_PI)),
+                                     std::abs(std::remainder(fastYaw - yaw, 2.0 * M_PI))});
+            }
+        });
+        INFO(fixture.file << ": max deviation " << maxAngle << " degrees, Euler " << maxEuler << " rad");
+        // The float rounding alone accounts for most of it, see the test above.
+        CHECK(maxAngle < 2.0e-3);
+        CHECK(maxEuler < 1.0e-4);
+    }
+}
+
+TEMPLATE_TEST_CASE("Single-precision IMU filters with FastMath track the double reference",
+                   "[imu-filters][float][fastmath]",
+                   puara_gestures::MadgwickQuaternionFilter,
+                   puara_gestures::MahonyQuaternionFilter,
+                   puara_gestures::KalmanQuaternionFilter) {
+    SECTION("FastMath") {
+        checkFastMathFilter<TestType, puara_gestures::fastmath::FastMath>();
+    }
+    SECTION("FastMathNoHardwareSqrt") {
+        checkFastMathFilter<TestType, puara_gestures::fastmath::FastMathNoHardwareSqrt>();
+    }
+}
+
+TEST_CASE("MadgwickBank matches one MadgwickQuaternionFilter per device", "[imu-filters][bank]") {
+    constexpr std::size_t devices = 8;
+    auto sample = [](std::size_t device, std::size_t i) {
+        const double t = 0.01 * static_cast<double>(i) + 0.3 * static_cast<double>(device);
+        puara_gestures::Imu9Axis imu{
+            {std::sin(t), 0.2 * std::cos(t), 9.81},
+            {10.0 * std::cos(t), 5.0 - device, -3.0 * std::sin(t)},
+            {0.3, 0.1 * std::sin(t), 0.5}};
+        if (device == 2) {
+            imu.magn = {0.0, 0.0, 0.0}; // 6-DoF update
+        }
+        if (device == 5 && i % 3 == 0) {
+            imu.accl = {0.0, 0.0, 0.0}; // invalid sample, orientation kept
+        }
+        return imu;
+    };
+
+    puara_gestures::MadgwickBank<devices> bank;
+    std::array<puara_gestures::MadgwickQuaternionFilter, devices> reference;
+    for (std::size_t d = 0; d < devices; ++d) {
+        bank.beta[d] = 0.05 + 0.05 * static_cast<double>(d);
+        reference[d].beta = bank.beta[d];
+    }
+
+    // The arithmetic is the same as the scalar filter's. Targets with FMA may
+    // contract the vector and scalar code differently; near convergence the
+    // normalized gradient then amplifies the rounding to about one correction
+    // step of beta * dt.
+    constexpr double deltat = 0.01;
+    std::array<puara_gestures::Imu9Axis, devices> imu;
+    std::array<double, devices> maxDiff{};
+    for (std::size_t i = 0; i < 2000; ++i) {
+        const uint64_t micros = 1000 + static_cast<uint64_t>(deltat * 1e6) * i;
+        for (std::size_t d = 0; d < devices; ++d) {
+            imu[d] = sample(d, i);
+            reference[d].updateWithTimestamp(imu[d], micros, true);
+        }
+        REQUIRE(bank.updateWithTimestamp(imu, micros, true) == (i > 0));
+
+        for (std::size_t d = 0; d < devices; ++d) {
+            const auto expected = reference[d].getQuaternion();
+            const auto measured = bank.getQuaternion(d);
+            maxDiff[d] = std::max({maxDiff[d], std::abs(measured.w - expected.w),
+                                   std::abs(measured.x - expected.x),
+                                   std::abs(measured.y - expected.y),
+                                   std::abs(measured.z - expected.z)});
+        }
+    }
+    for (std::size_t d = 0; d < devices; ++d) {
+        INFO("device " << d << " max difference " << maxDiff[d]);
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+        CHECK(maxDiff[d] <= 2.0 * bank.beta[d] * deltat);
+#else
+        CHECK(maxDiff[d] <= 1e-12);
+#endif
+    }
+    for (std::size_t d = 0; d < devices; ++d) {
+        REQUIRE(isQuaternionNormalized(bank.getQuaternion(d)));
+    }
+}
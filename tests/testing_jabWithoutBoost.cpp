@@ -0,0 +1,19 @@
+// jab.h must stay usable on targets without Boost: it is included first,
+// before anything that could bring Boost in, and every Boost header includes
+// boost/config.hpp.
+#include <puara/descriptors/jab.h>
+
+#if defined(BOOST_CONFIG_HPP)
+#error "jab.h must not depend on Boost"
+#endif
+
+#include <catch2/catch_all.hpp>
+
+TEST_CASE("Jab3D builds without Boost", "[descriptors][jab]")
+{
+    puara_gestures::Jab3D jab;
+    jab.threshold(1);
+    jab.update(puara_gestures::Coord3D{0.0, 0.0, 0.0});
+    jab.update(puara_gestures::Coord3D{5.0, 0.0, 0.0});
+    CHECK(jab.current_value().x > 0.0);
+}
@@ -1,7 +1,9 @@
 #include <catch2/catch_all.hpp>
 
+#include <cstddef>
 #include <filesystem>
 #include <limits>
+#include <span>
 #include <rapidcsv.h>
 #include <string>
 #include <vector>
@@ -9,6 +11,8 @@
 
 #include <puara/utils/calibration.h>
 
+#include "allocationCounter.h"
+
 using namespace Catch;
 using namespace puara_gestures;
 using namespace puara_gestures::utils;
@@ -115,7 +119,8 @@ TEST_CASE("Calibration: applyMagnetometerCalibration removes hard-iron bias", "[
     REQUIRE(calib.myCalIMU.magn.z == Approx(1.0));
 }
 
-static void verifySphereLikeCalibration(Embedded_Magnetometer_Calibration& calib, std::vector<Coord3D> const& samples)
+template <typename Calibration>
+static void verifySphereLikeCalibration(Calibration& calib, std::vector<Coord3D> const& samples)
 {
     std::vector<Eigen::Vector3d> calibratedPoints;
     calibratedPoints.reserve(samples.size());
@@ -167,3 +172,165 @@ TEST_CASE("Calibration: generateMagnetometerMatrices with magnetometer_raw_float
     REQUIRE(calib.enforceRadialEqualization == true);
     verifySphereLikeCalibration(calib, samples);
 }
+
+// Points on the unit sphere, spread evenly (Fibonacci lattice).
+static std::vector<Eigen::Vector3d> makeUnitSphere(size_t count)
+{
+    std::vector<Eigen::Vector3d> points;
+    points.reserve(count);
+    const double goldenAngle = M_PI * (3.0 - std::sqrt(5.0));
+    for (size_t i = 0; i < count; ++i)
+    {
+        const double z = 1.0 - 2.0 * (static_cast<double>(i) + 0.5) / static_cast<double>(count);
+        const double r = std::sqrt(1.0 - z * z);
+        const double longitude = goldenAngle * static_cast<double>(i);
+        points.emplace_back(r * std::cos(longitude), r * std::sin(longitude), z);
+    }
+    return points;
+}
+
+TEST_CASE("Streaming calibration: recovers a rotated, sheared ellipsoid with a large bias", "[calibration][streaming]")
+{
+    // Field of 50 uT seen through soft iron with off-diagonal terms and a
+    // hard-iron bias six times larger than the field.
+    Eigen::Matrix3d distortion;
+    distortion << 1.3, 0.25, -0.1,
+                  0.05, 0.7, 0.2,
+                  -0.15, 0.1, 1.1;
+    distortion *= 50.0;
+    const Eigen::Vector3d bias(300.0, -120.0, 45.0);
+
+    Streaming_Magnetometer_Calibration calib;
+    calib.calibrationRadius = 1.0;
+    for (const auto& p : makeUnitSphere(200))
+    {
+        const Eigen::Vector3d raw = distortion * p + bias;
+        calib.addSample({raw.x(), raw.y(), raw.z()});
+    }
+    REQUIRE(calib.sampleCount == 200);
+    REQUIRE(calib.generateMagnetometerMatrices() == 1);
+
+    CHECK((calib.hardIronBias - bias).norm() < 1e-6);
+    // The correction undoes the distortion up to a rotation.
+    const Eigen::Matrix3d product = calib.softIronMatrix * distortion;
+    CHECK((product * product.transpose() - Eigen::Matrix3d::Identity()).norm() < 1e-8);
+    CHECK((calib.softIronMatrix - calib.softIronMatrix.transpose()).norm() < 1e-12);
+
+    for (const auto& p : makeUnitSphere(37))
+    {
+        const Eigen::Vector3d raw = distortion * p + bias;
+        Imu9Axis imu;
+        imu.magn = {raw.x(), raw.y(), raw.z()};
+        calib.applyMagnetometerCalibration(imu);
+        const Eigen::Vector3d calibrated{calib.myCalIMU.magn.x, calib.myCalIMU.magn.y, calib.myCalIMU.magn.z};
+        CHECK(calibrated.norm() == Approx(1.0).margin(1e-8));
+    }
+}
+
+TEST_CASE("Streaming calibration: keeps the previous matrices when the fit is not an ellipsoid", "[calibration][streaming]")
+{
+    Streaming_Magnetometer_Calibration calib;
+    REQUIRE(calib.generateMagnetometerMatrices() == 0);
+
+    const auto sphere = makeUnitSphere(64);
+    for (size_t i = 0; i < Streaming_Magnetometer_Calibration::MinSamples - 1; ++i)
+    {
+        calib.addSample({sphere[i].x(), sphere[i].y(), sphere[i].z()});
+    }
+    REQUIRE(calib.generateMagnetometerMatrices() == 0);
+
+    // A flat circle: the device was only turned about one axis.
+    calib.reset();
+    for (size_t i = 0; i < 64; ++i)
+    {
+        const double angle = 2.0 * M_PI * static_cast<double>(i) / 64.0;
+        calib.addSample({0.3 + std::cos(angle), -0.2 + std::sin(angle), 0.5});
+    }
+    REQUIRE(calib.generateMagnetometerMatrices() == 0);
+    CHECK(calib.softIronMatrix.isIdentity());
+    CHECK(calib.hardIronBias.isZero());
+
+    calib.reset();
+    for (const auto& p : sphere)
+    {
+        calib.addSample({p.x() * 2.0 + 1.0, p.y() * 2.0, p.z() * 2.0});
+    }
+    REQUIRE(calib.generateMagnetometerMatrices() == 1);
+    CHECK(calib.hardIronBias.x() == Approx(1.0));
+    CHECK(calib.softIronMatrix(0, 0) == Approx(0.5));
+}
+
+TEST_CASE("Streaming calibration: magnetometer_raw_floats.csv without storing the samples", "[calibration][streaming][csv]")
+{
+    std::filesystem::path csvPath = std::filesystem::path(__FILE__).parent_path() / "data" / "magnetometer_raw_floats.csv";
+    auto samples = loadMagnetometerCsv(csvPath);
+    REQUIRE(samples.size() > 100);
+
+    // Constant size, against MaxSamples raw samples for the min/max calibration.
+    CHECK(sizeof(Streaming_Magnetometer_Calibration) * 8
+          < Embedded_Magnetometer_Calibration::MaxSamples * sizeof(Coord3D));
+
+    Streaming_Magnetometer_Calibration calib;
+    REQUIRE(calib.addSamples(samples) == samples.size());
+    REQUIRE(calib.generateMagnetometerMatrices() == 1);
+    verifySphereLikeCalibration(calib, samples);
+}
+
+TEST_CASE("Calibration: batched apply matches the per-sample path and allocates nothing", "[calibration][apply]")
+{
+    static_assert(decltype(Embedded_Magnetometer_Calibration::softIronMatrix)::SizeAtCompileTime == 9);
+    static_assert(decltype(Embedded_Magnetometer_Calibration::hardIronBias)::SizeAtCompileTime == 3);
+    static_assert(decltype(Streaming_Magnetometer_Calibration::softIronMatrix)::SizeAtCompileTime == 9);
+    static_assert(decltype(Streaming_Magnetometer_Calibration::hardIronBias)::SizeAtCompileTime == 3);
+
+    const auto samples = makeBiasedScaledSphere(48);
+    std::vector<Imu9Axis> in(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        in[i].accl = {0.1 * static_cast<double>(i), 0.0, 9.81};
+        in[i].gyro = {0.0, -0.2, static_cast<double>(i)};
+        in[i].magn = samples[i];
+    }
+    std::vector<Imu9Axis> out(in.size());
+    std::vector<Imu9Axis> inPlace = in;
+
+    Embedded_Magnetometer_Calibration embedded(samples.size());
+    Streaming_Magnetometer_Calibration streaming;
+
+    // operator new is counted; Eigen's dynamic storage uses malloc, which
+    // EIGEN_RUNTIME_NO_MALLOC turns into an assertion while it is disallowed.
+    Eigen::internal::set_is_malloc_allowed(false);
+    const auto before = puara_tests::heapAllocationCount();
+    const int embeddedResult = embedded.generateMagnetometerMatrices(samples.data(), samples.size());
+    streaming.addSamples(samples);
+    const int streamingResult = streaming.generateMagnetometerMatrices();
+    const size_t embeddedCount = embedded.apply(in, out);
+    const size_t inPlaceCount = streaming.apply(inPlace, inPlace);
+    embedded.applyMagnetometerCalibration(in[0]);
+    streaming.applyMagnetometerCalibration(in[0]);
+    const auto allocations = puara_tests::heapAllocationCount() - before;
+    Eigen::internal::set_is_malloc_allowed(true);
+
+    CHECK(allocations == 0);
+    REQUIRE(embeddedResult == 1);
+    REQUIRE(streamingResult == 1);
+    REQUIRE(embeddedCount == in.size());
+    REQUIRE(inPlaceCount == in.size());
+    CHECK(embedded.apply(std::span<const Imu9Axis>(in).first(5), out) == 5);
+
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        embedded.applyMagnetometerCalibration(in[i]);
+        CHECK(out[i].magn.x == Approx(embedded.myCalIMU.magn.x).margin(1e-12));
+        CHECK(out[i].magn.y == Approx(embedded.myCalIMU.magn.y).margin(1e-12));
+        CHECK(out[i].magn.z == Approx(embedded.myCalIMU.magn.z).margin(1e-12));
+        CHECK(out[i].accl.x == in[i].accl.x);
+        CHECK(out[i].gyro.z == in[i].gyro.z);
+
+        streaming.applyMagnetometerCalibration(in[i]);
+        CHECK(inPlace[i].magn.x == Approx(streaming.myCalIMU.magn.x).margin(1e-12));
+        CHECK(inPlace[i].magn.y == Approx(streaming.myCalIMU.magn.y).margin(1e-12));
+        CHECK(inPlace[i].magn.z == Approx(streaming.myCalIMU.magn.z).margin(1e-12));
+        CHECK(inPlace[i].accl.x == in[i].accl.x);
+    }
+}
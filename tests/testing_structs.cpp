@@ -2,6 +2,10 @@
 
 #include <puara/structs.h>
 
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
 using namespace Catch;
 
 TEST_CASE("Spherical alias fields work as expected", "[structs]")
@@ -25,6 +29,36 @@ TEST_CASE("Spherical alias fields work as expected", "[structs]")
     REQUIRE(s.distance == Approx(9.75));
 }
 
+TEST_CASE("Spherical copies are independent plain values", "[structs]")
+{
+    STATIC_REQUIRE(sizeof(puara_gestures::Spherical) == 4 * sizeof(double));
+    STATIC_REQUIRE(std::is_trivially_copyable_v<puara_gestures::Spherical>);
+    STATIC_REQUIRE(std::is_standard_layout_v<puara_gestures::Spherical>);
+
+    puara_gestures::Spherical a{};
+    a.yaw = 0.25;
+    a.pitch = 0.5;
+    a.r = 2.0;
+    a.roll = -1.0;
+
+    // Aliases of a copy refer to the copy, not to the original.
+    puara_gestures::Spherical b = a;
+    b.yaw = 3.0;
+    REQUIRE(a.azimuth == Approx(0.25));
+    REQUIRE(b.azimuth == Approx(3.0));
+
+    a = b;
+    REQUIRE(a.yaw == Approx(3.0));
+
+    std::vector<puara_gestures::Spherical> points(3);
+    std::memcpy(points.data() + 1, &a, sizeof(a));
+    REQUIRE(points[1].azimuth == Approx(3.0));
+    REQUIRE(points[1].pitch == Approx(0.5));
+    REQUIRE(points[1].distance == Approx(2.0));
+    REQUIRE(points[1].roll == Approx(-1.0));
+    REQUIRE(points[2].r == 0.0);
+}
+
 TEST_CASE("DiscreteArray and MinMax basic behavior", "[structs]")
 {
     puara_gestures::DiscreteArray da(4);
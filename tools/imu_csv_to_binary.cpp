@@ -0,0 +1,111 @@
+// Converts a CSV IMU recording (as in tests/data) to the binary recording
+// format of puara/utils/imuRecording.h.
+//
+// Usage: imu_csv_to_binary <input.csv> <output.imu> [microseconds per time unit]
+//                          [float32|float16|int16]
+//
+// The time unit defaults to milliseconds (1000). The roll and tilt recordings
+// in tests/data have timestamps in seconds: pass 1000000 for them.
+//
+// The encoding defaults to float32 (48-byte records). float16 and int16 store
+// 32-byte records; int16 first scans the file for the range of each sensor.
+
+#include <puara/utils/imuReplay.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace puara_gestures::utils;
+
+namespace
+{
+double largestMagnitude(const puara_gestures::Coord3D& v, double current)
+{
+  return std::max({current, std::abs(v.x), std::abs(v.y), std::abs(v.z)});
+}
+
+// Ranges of the three sensors over the whole recording, for int16.
+bool scanRanges(const char* path, double microsPerTimeUnit, ImuRecordingHeader& format)
+{
+  CsvImuReader reader(path, microsPerTimeUnit);
+  if(!reader.isOpen())
+    return false;
+  double accl = 0.0, gyro = 0.0, magn = 0.0;
+  replay(reader, [&](const ImuSample& s) {
+    accl = largestMagnitude(s.imu.accl, accl);
+    gyro = largestMagnitude(s.imu.gyro, gyro);
+    magn = largestMagnitude(s.imu.magn, magn);
+  });
+  // An all-zero sensor still needs a valid scale.
+  format = ImuRecordingHeader::int16(
+      accl > 0.0 ? accl : 1.0, gyro > 0.0 ? gyro : 1.0, magn > 0.0 ? magn : 1.0);
+  return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+  if(argc < 3 || argc > 5)
+  {
+    std::fprintf(
+        stderr,
+        "usage: %s <input.csv> <output.imu> [microseconds per time unit] "
+        "[float32|float16|int16]\n",
+        argv[0]);
+    return 2;
+  }
+  const double microsPerTimeUnit = argc >= 4 ? std::atof(argv[3]) : 1000.0;
+  if(microsPerTimeUnit <= 0.0)
+  {
+    std::fprintf(stderr, "invalid time unit: %s\n", argv[3]);
+    return 2;
+  }
+
+  const char* encoding = argc == 5 ? argv[4] : "float32";
+  ImuRecordingHeader format;
+  if(std::strcmp(encoding, "float16") == 0)
+    format = ImuRecordingHeader::float16();
+  else if(std::strcmp(encoding, "int16") == 0)
+  {
+    if(!scanRanges(argv[1], microsPerTimeUnit, format))
+    {
+      std::fprintf(stderr, "cannot read %s\n", argv[1]);
+      return 1;
+    }
+  }
+  else if(std::strcmp(encoding, "float32") != 0)
+  {
+    std::fprintf(stderr, "invalid encoding: %s\n", encoding);
+    return 2;
+  }
+
+  CsvImuReader reader(argv[1], microsPerTimeUnit);
+  if(!reader.isOpen())
+  {
+    std::fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+  BinaryImuWriter writer(argv[2], format);
+  if(!writer.isOpen())
+  {
+    std::fprintf(stderr, "cannot write %s\n", argv[2]);
+    return 1;
+  }
+
+  const std::size_t samples
+      = replay(reader, [&](std::span<const ImuSample> chunk) { writer.write(chunk); });
+  const bool written = writer.close();
+  if(!written)
+  {
+    std::fprintf(stderr, "error writing %s\n", argv[2]);
+    return 1;
+  }
+  std::printf("%s: %zu samples (%s)", argv[2], samples, encoding);
+  if(reader.skippedRows > 0)
+    std::printf(", %zu rows skipped", reader.skippedRows);
+  std::printf("\n");
+  return 0;
+}